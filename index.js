@@ -1,2 +1,27 @@
+var WebRTC = require('./build/Release/webrtc.node');
 
-module.exports = require('./build/Release/webrtc.node');
+function promisify(method, argc) {
+  return function() {
+    var self = this;
+    var args = Array.prototype.slice.call(arguments);
+    
+    if (args.length > argc || typeof Promise !== 'function') {
+      return method.apply(self, args);
+    }
+    
+    return new Promise(function(resolve, reject) {
+      while (args.length < argc) {
+        args.push(undefined);
+      }
+      
+      method.apply(self, args.concat([ resolve, reject ]));
+    });
+  };
+}
+
+WebRTC.getUserMedia = promisify(WebRTC.getUserMedia, 1);
+WebRTC.getSources = promisify(WebRTC.getSources, 0);
+WebRTC.generateCertificate = promisify(WebRTC.generateCertificate, 1);
+WebRTC.RTCPeerConnection.generateCertificate = WebRTC.generateCertificate;
+
+module.exports = WebRTC;
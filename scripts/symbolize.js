@@ -0,0 +1,177 @@
+var fs = require('fs');
+var os = require('os');
+var execFileSync = require('child_process').execFileSync;
+
+// Symbolizes a crash report written by BackTrace::Crash().
+//
+// node scripts/symbolize.js [crash.log]
+//
+// Frames are resolved with addr2line using the memory map in the report,
+// or with atos against the module load address on OS X. Event times are
+// printed relative to the newest event.
+
+var PLATFORM = os.platform();
+
+function parse(text) {
+  var report = { header: [], frames: [], threads: [], maps: [], module: null };
+  var section = 'frames';
+  var thread = null;
+
+  text.split('\n').forEach(function(line) {
+    var match;
+
+    if (line.indexOf('***') === 0) {
+      report.header.push(line);
+      section = 'frames';
+    } else if (section === 'maps') {
+      match = /^([0-9a-f]+)-([0-9a-f]+) \S+ ([0-9a-f]+) \S+ \S+\s+(\S.*)$/.exec(line);
+
+      if (match) {
+        report.maps.push({
+          start: parseInt(match[1], 16),
+          end: parseInt(match[2], 16),
+          offset: parseInt(match[3], 16),
+          path: match[4],
+        });
+      }
+    } else if (line === 'maps') {
+      section = 'maps';
+    } else if ((match = /^module (.*) (0x[0-9a-f]+)$/.exec(line))) {
+      report.module = { path: match[1], base: parseInt(match[2], 16) };
+    } else if ((match = /^frame (0x[0-9a-f]+)$/.exec(line))) {
+      report.frames.push({ address: parseInt(match[1], 16) });
+    } else if ((match = /^thread (\d+) (.*)$/.exec(line))) {
+      thread = { id: match[1], name: match[2], events: [] };
+      report.threads.push(thread);
+    } else if (thread && (match = /^event (\d+) (\S+) (\S+) (\S+) (-?\d+)$/.exec(line))) {
+      thread.events.push({
+        time: Number(match[1]),
+        event: match[2],
+        object: match[3],
+        id: match[4],
+        value: match[5],
+      });
+    }
+  });
+
+  return report;
+}
+
+// Load address of every file, the start of its first mapping.
+function bases(maps) {
+  var result = {};
+
+  maps.forEach(function(map) {
+    if (map.path.charAt(0) === '/' && map.offset === 0 && !(map.path in result)) {
+      result[map.path] = map.start;
+    }
+  });
+
+  return result;
+}
+
+function locate(report, address) {
+  var loaded = bases(report.maps);
+
+  for (var index = 0; index < report.maps.length; index++) {
+    var map = report.maps[index];
+
+    if (address >= map.start && address < map.end && map.path in loaded) {
+      return { path: map.path, base: loaded[map.path] };
+    }
+  }
+
+  if (report.module) {
+    return report.module;
+  }
+
+  return null;
+}
+
+function hex(value) {
+  return '0x' + value.toString(16);
+}
+
+function resolve(module, addresses) {
+  try {
+    if (PLATFORM === 'darwin') {
+      return execFileSync('atos', [ '-o', module.path, '-l', hex(module.base) ].concat(addresses.map(hex)))
+        .toString().trim().split('\n');
+    }
+
+    var output = execFileSync('addr2line', [ '-C', '-f', '-e', module.path ].concat(addresses.map(function(address) {
+      return hex(address - module.base);
+    }))).toString().trim().split('\n');
+    var result = [];
+
+    for (var index = 0; index + 1 < output.length; index += 2) {
+      result.push(output[index] + ' ' + output[index + 1]);
+    }
+
+    return result;
+  } catch (ignored) {
+    return [];
+  }
+}
+
+function symbolize(report) {
+  var modules = {};
+
+  report.frames.forEach(function(frame) {
+    frame.module = locate(report, frame.address);
+
+    if (frame.module) {
+      modules[frame.module.path] = modules[frame.module.path] || { module: frame.module, frames: [] };
+      modules[frame.module.path].frames.push(frame);
+    }
+  });
+
+  Object.keys(modules).forEach(function(path) {
+    var entry = modules[path];
+    var symbols = resolve(entry.module, entry.frames.map(function(frame) {
+      return frame.address;
+    }));
+
+    entry.frames.forEach(function(frame, index) {
+      frame.symbol = symbols[index];
+    });
+  });
+}
+
+function print(report) {
+  var newest = 0;
+
+  report.header.slice(0, 1).forEach(function(line) {
+    console.log(line);
+  });
+
+  report.frames.forEach(function(frame, index) {
+    var location = frame.module ?
+      ' [' + frame.module.path + '+' + hex(frame.address - frame.module.base) + ']' : '';
+
+    console.log('#' + index + ' ' + hex(frame.address) + ' ' + (frame.symbol || '??') + location);
+  });
+
+  report.threads.forEach(function(thread) {
+    thread.events.forEach(function(event) {
+      newest = Math.max(newest, event.time);
+    });
+  });
+
+  report.threads.forEach(function(thread) {
+    console.log('');
+    console.log('thread ' + thread.id + ' (' + thread.name + ')');
+
+    thread.events.forEach(function(event) {
+      var ms = ((event.time - newest) / 1e6).toFixed(3);
+
+      console.log('  ' + ms + ' ms ' + event.event + ' ' + event.object + ' ' + event.id + ' ' + event.value);
+    });
+  });
+}
+
+var input = process.argv[2] ? fs.readFileSync(process.argv[2], 'utf8') : fs.readFileSync('/dev/stdin', 'utf8');
+var report = parse(input);
+
+symbolize(report);
+print(report);
@@ -0,0 +1,185 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <math.h>
+#include <algorithm>
+
+#include "AudioAnalyzer.h"
+#include "MediaStreamTrack.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WEBRTC_AUDIOANALYZER_SSE2
+#endif
+
+using namespace WebRTC;
+
+#define WEBRTC_VAD_MIN_DBFS -50.0
+#define WEBRTC_VAD_MARGIN_DB 9.0
+#define WEBRTC_VAD_HANGOVER_MS 300
+
+static void ScanSamples(const int16_t *data, size_t count, uint64_t *squares, uint32_t *peak) {
+  uint64_t sum = 0;
+  int32_t high = 0;
+  int32_t low = 0;
+  size_t index = 0;
+
+#ifdef WEBRTC_AUDIOANALYZER_SSE2
+  __m128i zero = _mm_setzero_si128();
+  __m128i acc = _mm_setzero_si128();
+  __m128i vmax = _mm_setzero_si128();
+  __m128i vmin = _mm_setzero_si128();
+
+  for (; index + 8 <= count; index += 8) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+    
+    // madd of two int16 squares fits in uint32, widen before accumulating.
+    __m128i pairs = _mm_madd_epi16(block, block);
+    acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(pairs, zero));
+    acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(pairs, zero));
+    
+    vmax = _mm_max_epi16(vmax, block);
+    vmin = _mm_min_epi16(vmin, block);
+  }
+
+  uint64_t lanes[2];
+  int16_t maxes[8];
+  int16_t mins[8];
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(maxes), vmax);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(mins), vmin);
+
+  sum = lanes[0] + lanes[1];
+
+  for (int lane = 0; lane < 8; lane++) {
+    high = std::max<int32_t>(high, maxes[lane]);
+    low = std::min<int32_t>(low, mins[lane]);
+  }
+#endif
+
+  for (; index < count; index++) {
+    int32_t sample = data[index];
+    
+    sum += static_cast<uint64_t>(sample * sample);
+    high = std::max<int32_t>(high, sample);
+    low = std::min<int32_t>(low, sample);
+  }
+
+  *squares += sum;
+  *peak = std::max<uint32_t>(*peak, static_cast<uint32_t>(std::max<int32_t>(high, -low)));
+}
+
+AudioAnalyzer::AudioAnalyzer(EventEmitter *listener, int interval) :
+  NotifyEmitter(listener),
+  _interval(interval),
+  _squares(0),
+  _peak(0),
+  _samples(0),
+  _elapsed(0),
+  _floor(WEBRTC_VAD_MIN_DBFS),
+  _hangover(0),
+  _speaking(false)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+void AudioAnalyzer::SetInterval(int interval) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::AtomicOps::ReleaseStore(&_interval, (interval > 0) ? interval : 0);
+}
+
+int AudioAnalyzer::Interval() const {
+  return rtc::AtomicOps::AcquireLoad(&_interval);
+}
+
+void AudioAnalyzer::OnData(const void* audio_data, int bits_per_sample, int sample_rate, size_t number_of_channels, size_t number_of_frames) {
+  if (!audio_data || bits_per_sample != 16 || sample_rate <= 0 || !number_of_channels || !number_of_frames) {
+    return;
+  }
+  
+  const int16_t *data = static_cast<const int16_t*>(audio_data);
+  size_t count = number_of_channels * number_of_frames;
+  uint64_t squares = 0;
+  uint32_t peak = 0;
+  
+  ScanSamples(data, count, &squares, &peak);
+  
+  _squares += squares;
+  _peak = std::max(_peak, peak);
+  _samples += count;
+  
+  AudioAnalyzer::OnBlock(static_cast<double>(squares) / count, sample_rate, number_of_frames);
+}
+
+void AudioAnalyzer::OnBlock(double energy, int sample_rate, size_t number_of_frames) {
+  double db = (energy > 0) ? 10.0 * log10(energy / (32768.0 * 32768.0)) : -100.0;
+  size_t duration = (number_of_frames * 1000) / sample_rate;
+  bool speaking = _speaking;
+  
+  if (db < _floor) {
+    _floor = db;
+  } else {
+    _floor += (db - _floor) * 0.002;
+  }
+  
+  if (db > WEBRTC_VAD_MIN_DBFS && db > (_floor + WEBRTC_VAD_MARGIN_DB)) {
+    _hangover = WEBRTC_VAD_HANGOVER_MS;
+    speaking = true;
+  } else if (_hangover > duration) {
+    _hangover -= duration;
+  } else {
+    _hangover = 0;
+    speaking = false;
+  }
+  
+  if (speaking != _speaking) {
+    AudioLevel event;
+    
+    _speaking = speaking;
+    event.speaking = speaking;
+    Emit(kMediaStreamTrackSpeaking, event);
+  }
+  
+  _elapsed += duration;
+  
+  int interval = rtc::AtomicOps::AcquireLoad(&_interval);
+  
+  if (interval && _elapsed >= static_cast<size_t>(interval)) {
+    AudioLevel event;
+
+    event.level = sqrt(static_cast<double>(_squares) / _samples) / 32768.0;
+    event.peak = _peak / 32768.0;
+    event.speaking = _speaking;
+    
+    _squares = 0;
+    _peak = 0;
+    _samples = 0;
+    _elapsed = 0;
+    
+    Emit(kMediaStreamTrackLevel, event);
+  }
+}
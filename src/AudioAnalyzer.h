@@ -0,0 +1,71 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_AUDIOANALYZER_H
+#define WEBRTC_AUDIOANALYZER_H
+
+#include "EventEmitter.h"
+
+namespace WebRTC {
+  struct AudioLevel {
+    AudioLevel() : level(0), peak(0), speaking(false) { }
+    
+    double level;
+    double peak;
+    bool speaking;
+  };
+  
+  class AudioAnalyzer : 
+    public webrtc::AudioTrackSinkInterface,
+    public rtc::RefCountInterface,
+    public NotifyEmitter
+  {
+   public:
+    AudioAnalyzer(EventEmitter *listener = 0, int interval = 100);
+    
+    void SetInterval(int interval);
+    int Interval() const;
+    
+    void OnData(const void* audio_data, int bits_per_sample, int sample_rate, size_t number_of_channels, size_t number_of_frames) final;
+    
+   private:
+    void OnBlock(double energy, int sample_rate, size_t number_of_frames);
+    
+   protected:
+    // Written from JavaScript, read on the audio thread.
+    volatile int _interval;
+    
+    uint64_t _squares;
+    uint32_t _peak;
+    size_t _samples;
+    size_t _elapsed;
+    
+    double _floor;
+    size_t _hangover;
+    bool _speaking;
+  };
+};
+
+#endif
@@ -0,0 +1,746 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <string.h>
+
+#include "webrtc/base/stringutils.h"
+#include "webrtc/base/timeutils.h"
+
+#include "AudioDevice.h"
+
+using namespace WebRTC;
+
+enum AudioDeviceMessage {
+  kAudioDeviceTick,
+};
+
+static size_t FifoWrite(std::vector<int16_t> &buffer, size_t &read, size_t &size, const int16_t *data, size_t count, bool overwrite) {
+  size_t capacity = buffer.size();
+  
+  if (count > capacity - size) {
+    if (!overwrite) {
+      count = capacity - size;
+    } else {
+      size_t drop = std::min(count - (capacity - size), size);
+      
+      read = (read + drop) % capacity;
+      size -= drop;
+      
+      if (count > capacity) {
+        data += count - capacity;
+        count = capacity;
+      }
+    }
+  }
+  
+  size_t write = (read + size) % capacity;
+  
+  for (size_t index = 0; index < count; index++) {
+    buffer[write] = data[index];
+    write = (write + 1) % capacity;
+  }
+  
+  size += count;
+  return count;
+}
+
+static size_t FifoRead(std::vector<int16_t> &buffer, size_t &read, size_t &size, int16_t *data, size_t count) {
+  size_t capacity = buffer.size();
+  
+  count = std::min(count, size);
+  
+  for (size_t index = 0; index < count; index++) {
+    data[index] = buffer[read];
+    read = (read + 1) % capacity;
+  }
+  
+  size -= count;
+  return count;
+}
+
+rtc::scoped_refptr<AudioDevice> AudioDevice::Create(bool silence) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  return new rtc::RefCountedObject<AudioDevice>(silence);
+}
+
+AudioDevice::AudioDevice(bool silence) :
+  _thread(0),
+  _transport(0),
+  _silence(silence),
+  _initialized(false),
+  _playInitialized(false),
+  _recInitialized(false),
+  _playing(false),
+  _recording(false),
+  _mute(false),
+  _next(0),
+  _level(0),
+  _recBuffer(kBufferSamples * kChannels),
+  _recRead(0),
+  _recSize(0),
+  _playBuffer(kBufferSamples * kChannels),
+  _playRead(0),
+  _playSize(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  memset(_recFrame, 0, sizeof(_recFrame));
+  memset(_playFrame, 0, sizeof(_playFrame));
+}
+
+AudioDevice::~AudioDevice() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    _playing = false;
+    _recording = false;
+  }
+  
+  AudioDevice::UpdateThread();
+}
+
+size_t AudioDevice::PushRecording(const int16_t *data, size_t frames, int sample_rate, size_t channels) {
+  if (!data || !frames || sample_rate <= 0 || !channels) {
+    return 0;
+  }
+  
+  int16_t block[kFrameSamples];
+  size_t length = 0;
+  size_t count = 0;
+  
+  // Downmix to mono and resample linearly to the device rate.
+  double step = static_cast<double>(sample_rate) / kSampleRate;
+  size_t total = static_cast<size_t>(frames / step);
+  
+  rtc::CritScope lock(&_fifo);
+  
+  for (size_t index = 0; index < total; index++) {
+    double position = index * step;
+    size_t left = static_cast<size_t>(position);
+    size_t right = std::min(left + 1, frames - 1);
+    double fraction = position - left;
+    int32_t a = 0;
+    int32_t b = 0;
+    
+    for (size_t channel = 0; channel < channels; channel++) {
+      a += data[left * channels + channel];
+      b += data[right * channels + channel];
+    }
+    
+    block[length++] = static_cast<int16_t>((a + (b - a) * fraction) / static_cast<int32_t>(channels));
+    
+    if (length == kFrameSamples) {
+      count += FifoWrite(_recBuffer, _recRead, _recSize, block, length, false);
+      length = 0;
+    }
+  }
+  
+  if (length) {
+    count += FifoWrite(_recBuffer, _recRead, _recSize, block, length, false);
+  }
+  
+  return count;
+}
+
+size_t AudioDevice::PullPlayout(int16_t *data, size_t samples) {
+  if (!data || !samples) {
+    return 0;
+  }
+  
+  rtc::CritScope lock(&_fifo);
+  return FifoRead(_playBuffer, _playRead, _playSize, data, samples);
+}
+
+void AudioDevice::UpdateThread() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::Thread *thread = 0;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    if (_playing || _recording) {
+      if (!_thread) {
+        _thread = new rtc::Thread();
+        _thread->SetName("AudioDevice", this);
+        _thread->Start();
+        
+        _next = rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec;
+        _thread->Post(this, kAudioDeviceTick);
+      }
+    } else {
+      thread = _thread;
+      _thread = 0;
+    }
+  }
+  
+  if (thread) {
+    thread->Clear(this);
+    thread->Stop();
+    delete thread;
+  }
+}
+
+void AudioDevice::ProcessFrame() {
+  webrtc::AudioTransport *transport = 0;
+  bool recording = false;
+  bool playing = false;
+  bool mute = false;
+  uint32_t level = 0;
+  
+  // Snapshot the state under the lock, the transport calls back into the
+  // voice engine which may in turn call into this module.
+  {
+    rtc::CritScope lock(&_lock);
+    
+    transport = _transport;
+    recording = _recording;
+    playing = _playing;
+    mute = _mute;
+    level = _level;
+  }
+  
+  if (!transport) {
+    return;
+  }
+  
+  size_t recorded = 0;
+  
+  if (recording) {
+    rtc::CritScope fifo(&_fifo);
+    recorded = FifoRead(_recBuffer, _recRead, _recSize, _recFrame, kFrameSamples * kChannels);
+  }
+  
+  if (recording && (recorded || _silence)) {
+    uint32_t newLevel = 0;
+    
+    if (recorded < kFrameSamples * kChannels) {
+      memset(_recFrame + recorded, 0, (kFrameSamples * kChannels - recorded) * sizeof(int16_t));
+    }
+    
+    if (mute) {
+      memset(_recFrame, 0, sizeof(_recFrame));
+    }
+    
+    transport->RecordedDataIsAvailable(_recFrame, kFrameSamples, sizeof(int16_t) * kChannels, kChannels, kSampleRate, 0, 0, level, false, newLevel);
+    
+    rtc::CritScope lock(&_lock);
+    _level = newLevel;
+  }
+  
+  if (playing) {
+    size_t count = 0;
+    int64_t elapsed = 0;
+    int64_t ntp = 0;
+    
+    transport->NeedMorePlayData(kFrameSamples, sizeof(int16_t) * kChannels, kChannels, kSampleRate, _playFrame, count, &elapsed, &ntp);
+    
+    if (count) {
+      rtc::CritScope fifo(&_fifo);
+      FifoWrite(_playBuffer, _playRead, _playSize, _playFrame, std::min<size_t>(count, kFrameSamples) * kChannels, true);
+    }
+  }
+}
+
+void AudioDevice::OnMessage(rtc::Message *msg) {
+  if (msg->message_id != kAudioDeviceTick) {
+    return;
+  }
+  
+  AudioDevice::ProcessFrame();
+  
+  int64_t now = rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec;
+  
+  _next += kFrameMs;
+  
+  if (now - _next > 10 * kFrameMs) {
+    _next = now + kFrameMs;
+  }
+  
+  rtc::Thread::Current()->PostDelayed(static_cast<int>(std::max<int64_t>(_next - now, 0)), this, kAudioDeviceTick);
+}
+
+int64_t AudioDevice::TimeUntilNextProcess() {
+  return 1000;
+}
+
+void AudioDevice::Process() { }
+
+int32_t AudioDevice::ActiveAudioLayer(AudioLayer *audioLayer) const {
+  if (audioLayer) {
+    *audioLayer = kDummyAudio;
+  }
+  
+  return 0;
+}
+
+webrtc::AudioDeviceModule::ErrorCode AudioDevice::LastError() const {
+  return kAdmErrNone;
+}
+
+int32_t AudioDevice::RegisterEventObserver(webrtc::AudioDeviceObserver *eventCallback) {
+  return 0;
+}
+
+int32_t AudioDevice::RegisterAudioCallback(webrtc::AudioTransport *audioCallback) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  _transport = audioCallback;
+  return 0;
+}
+
+int32_t AudioDevice::Init() {
+  _initialized = true;
+  return 0;
+}
+
+int32_t AudioDevice::Terminate() {
+  StopPlayout();
+  StopRecording();
+  
+  _initialized = false;
+  return 0;
+}
+
+bool AudioDevice::Initialized() const {
+  return _initialized;
+}
+
+int16_t AudioDevice::PlayoutDevices() {
+  return 1;
+}
+
+int16_t AudioDevice::RecordingDevices() {
+  return 1;
+}
+
+int32_t AudioDevice::PlayoutDeviceName(uint16_t index, char name[webrtc::kAdmMaxDeviceNameSize], char guid[webrtc::kAdmMaxGuidSize]) {
+  if (index) {
+    return -1;
+  }
+  
+  rtc::strcpyn(name, webrtc::kAdmMaxDeviceNameSize, "Virtual Playout");
+  
+  if (guid) {
+    rtc::strcpyn(guid, webrtc::kAdmMaxGuidSize, "virtual-playout");
+  }
+  
+  return 0;
+}
+
+int32_t AudioDevice::RecordingDeviceName(uint16_t index, char name[webrtc::kAdmMaxDeviceNameSize], char guid[webrtc::kAdmMaxGuidSize]) {
+  if (index) {
+    return -1;
+  }
+  
+  rtc::strcpyn(name, webrtc::kAdmMaxDeviceNameSize, "Virtual Recording");
+  
+  if (guid) {
+    rtc::strcpyn(guid, webrtc::kAdmMaxGuidSize, "virtual-recording");
+  }
+  
+  return 0;
+}
+
+int32_t AudioDevice::SetPlayoutDevice(uint16_t index) {
+  return index ? -1 : 0;
+}
+
+int32_t AudioDevice::SetPlayoutDevice(WindowsDeviceType device) {
+  return 0;
+}
+
+int32_t AudioDevice::SetRecordingDevice(uint16_t index) {
+  return index ? -1 : 0;
+}
+
+int32_t AudioDevice::SetRecordingDevice(WindowsDeviceType device) {
+  return 0;
+}
+
+int32_t AudioDevice::PlayoutIsAvailable(bool *available) {
+  *available = true;
+  return 0;
+}
+
+int32_t AudioDevice::InitPlayout() {
+  _playInitialized = true;
+  return 0;
+}
+
+bool AudioDevice::PlayoutIsInitialized() const {
+  return _playInitialized;
+}
+
+int32_t AudioDevice::RecordingIsAvailable(bool *available) {
+  *available = true;
+  return 0;
+}
+
+int32_t AudioDevice::InitRecording() {
+  _recInitialized = true;
+  return 0;
+}
+
+bool AudioDevice::RecordingIsInitialized() const {
+  return _recInitialized;
+}
+
+int32_t AudioDevice::StartPlayout() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!_playInitialized) {
+    return -1;
+  }
+  
+  {
+    rtc::CritScope lock(&_lock);
+    _playing = true;
+  }
+  
+  AudioDevice::UpdateThread();
+  return 0;
+}
+
+int32_t AudioDevice::StopPlayout() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    _playing = false;
+  }
+  
+  AudioDevice::UpdateThread();
+  return 0;
+}
+
+bool AudioDevice::Playing() const {
+  return _playing;
+}
+
+int32_t AudioDevice::StartRecording() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!_recInitialized) {
+    return -1;
+  }
+  
+  {
+    rtc::CritScope lock(&_lock);
+    _recording = true;
+  }
+  
+  AudioDevice::UpdateThread();
+  return 0;
+}
+
+int32_t AudioDevice::StopRecording() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    _recording = false;
+  }
+  
+  AudioDevice::UpdateThread();
+  return 0;
+}
+
+bool AudioDevice::Recording() const {
+  return _recording;
+}
+
+int32_t AudioDevice::SetAGC(bool enable) {
+  return enable ? -1 : 0;
+}
+
+bool AudioDevice::AGC() const {
+  return false;
+}
+
+int32_t AudioDevice::SetWaveOutVolume(uint16_t volumeLeft, uint16_t volumeRight) {
+  return -1;
+}
+
+int32_t AudioDevice::WaveOutVolume(uint16_t *volumeLeft, uint16_t *volumeRight) const {
+  return -1;
+}
+
+int32_t AudioDevice::InitSpeaker() {
+  return 0;
+}
+
+bool AudioDevice::SpeakerIsInitialized() const {
+  return true;
+}
+
+int32_t AudioDevice::InitMicrophone() {
+  return 0;
+}
+
+bool AudioDevice::MicrophoneIsInitialized() const {
+  return true;
+}
+
+int32_t AudioDevice::SpeakerVolumeIsAvailable(bool *available) {
+  *available = false;
+  return 0;
+}
+
+int32_t AudioDevice::SetSpeakerVolume(uint32_t volume) {
+  return -1;
+}
+
+int32_t AudioDevice::SpeakerVolume(uint32_t *volume) const {
+  return -1;
+}
+
+int32_t AudioDevice::MaxSpeakerVolume(uint32_t *maxVolume) const {
+  return -1;
+}
+
+int32_t AudioDevice::MinSpeakerVolume(uint32_t *minVolume) const {
+  return -1;
+}
+
+int32_t AudioDevice::SpeakerVolumeStepSize(uint16_t *stepSize) const {
+  return -1;
+}
+
+int32_t AudioDevice::MicrophoneVolumeIsAvailable(bool *available) {
+  *available = false;
+  return 0;
+}
+
+int32_t AudioDevice::SetMicrophoneVolume(uint32_t volume) {
+  rtc::CritScope lock(&_lock);
+  
+  _level = volume;
+  return 0;
+}
+
+int32_t AudioDevice::MicrophoneVolume(uint32_t *volume) const {
+  rtc::CritScope lock(&_lock);
+  
+  *volume = _level;
+  return 0;
+}
+
+int32_t AudioDevice::MaxMicrophoneVolume(uint32_t *maxVolume) const {
+  *maxVolume = 255;
+  return 0;
+}
+
+int32_t AudioDevice::MinMicrophoneVolume(uint32_t *minVolume) const {
+  *minVolume = 0;
+  return 0;
+}
+
+int32_t AudioDevice::MicrophoneVolumeStepSize(uint16_t *stepSize) const {
+  *stepSize = 1;
+  return 0;
+}
+
+int32_t AudioDevice::SpeakerMuteIsAvailable(bool *available) {
+  *available = false;
+  return 0;
+}
+
+int32_t AudioDevice::SetSpeakerMute(bool enable) {
+  return -1;
+}
+
+int32_t AudioDevice::SpeakerMute(bool *enabled) const {
+  return -1;
+}
+
+int32_t AudioDevice::MicrophoneMuteIsAvailable(bool *available) {
+  *available = true;
+  return 0;
+}
+
+int32_t AudioDevice::SetMicrophoneMute(bool enable) {
+  rtc::CritScope lock(&_lock);
+  _mute = enable;
+  return 0;
+}
+
+int32_t AudioDevice::MicrophoneMute(bool *enabled) const {
+  *enabled = _mute;
+  return 0;
+}
+
+int32_t AudioDevice::MicrophoneBoostIsAvailable(bool *available) {
+  *available = false;
+  return 0;
+}
+
+int32_t AudioDevice::SetMicrophoneBoost(bool enable) {
+  return -1;
+}
+
+int32_t AudioDevice::MicrophoneBoost(bool *enabled) const {
+  return -1;
+}
+
+int32_t AudioDevice::StereoPlayoutIsAvailable(bool *available) const {
+  *available = (kChannels == 2);
+  return 0;
+}
+
+int32_t AudioDevice::SetStereoPlayout(bool enable) {
+  return (enable == (kChannels == 2)) ? 0 : -1;
+}
+
+int32_t AudioDevice::StereoPlayout(bool *enabled) const {
+  *enabled = (kChannels == 2);
+  return 0;
+}
+
+int32_t AudioDevice::StereoRecordingIsAvailable(bool *available) const {
+  *available = (kChannels == 2);
+  return 0;
+}
+
+int32_t AudioDevice::SetStereoRecording(bool enable) {
+  return (enable == (kChannels == 2)) ? 0 : -1;
+}
+
+int32_t AudioDevice::StereoRecording(bool *enabled) const {
+  *enabled = (kChannels == 2);
+  return 0;
+}
+
+int32_t AudioDevice::SetRecordingChannel(const ChannelType channel) {
+  return (channel == kChannelBoth) ? 0 : -1;
+}
+
+int32_t AudioDevice::RecordingChannel(ChannelType *channel) const {
+  *channel = kChannelBoth;
+  return 0;
+}
+
+int32_t AudioDevice::SetPlayoutBuffer(const BufferType type, uint16_t sizeMS) {
+  return 0;
+}
+
+int32_t AudioDevice::PlayoutBuffer(BufferType *type, uint16_t *sizeMS) const {
+  *type = kFixedBufferSize;
+  *sizeMS = kFrameMs;
+  return 0;
+}
+
+int32_t AudioDevice::PlayoutDelay(uint16_t *delayMS) const {
+  *delayMS = 0;
+  return 0;
+}
+
+int32_t AudioDevice::RecordingDelay(uint16_t *delayMS) const {
+  *delayMS = 0;
+  return 0;
+}
+
+int32_t AudioDevice::CPULoad(uint16_t *load) const {
+  *load = 0;
+  return 0;
+}
+
+int32_t AudioDevice::StartRawOutputFileRecording(const char pcmFileNameUTF8[webrtc::kAdmMaxFileNameSize]) {
+  return -1;
+}
+
+int32_t AudioDevice::StopRawOutputFileRecording() {
+  return 0;
+}
+
+int32_t AudioDevice::StartRawInputFileRecording(const char pcmFileNameUTF8[webrtc::kAdmMaxFileNameSize]) {
+  return -1;
+}
+
+int32_t AudioDevice::StopRawInputFileRecording() {
+  return 0;
+}
+
+int32_t AudioDevice::SetRecordingSampleRate(const uint32_t samplesPerSec) {
+  return (samplesPerSec == kSampleRate) ? 0 : -1;
+}
+
+int32_t AudioDevice::RecordingSampleRate(uint32_t *samplesPerSec) const {
+  *samplesPerSec = kSampleRate;
+  return 0;
+}
+
+int32_t AudioDevice::SetPlayoutSampleRate(const uint32_t samplesPerSec) {
+  return (samplesPerSec == kSampleRate) ? 0 : -1;
+}
+
+int32_t AudioDevice::PlayoutSampleRate(uint32_t *samplesPerSec) const {
+  *samplesPerSec = kSampleRate;
+  return 0;
+}
+
+int32_t AudioDevice::ResetAudioDevice() {
+  rtc::CritScope lock(&_fifo);
+  
+  _recRead = _recSize = 0;
+  _playRead = _playSize = 0;
+  return 0;
+}
+
+int32_t AudioDevice::SetLoudspeakerStatus(bool enable) {
+  return -1;
+}
+
+int32_t AudioDevice::GetLoudspeakerStatus(bool *enabled) const {
+  return -1;
+}
+
+bool AudioDevice::BuiltInAECIsAvailable() const {
+  return false;
+}
+
+int32_t AudioDevice::EnableBuiltInAEC(bool enable) {
+  return -1;
+}
+
+bool AudioDevice::BuiltInAGCIsAvailable() const {
+  return false;
+}
+
+int32_t AudioDevice::EnableBuiltInAGC(bool enable) {
+  return -1;
+}
+
+bool AudioDevice::BuiltInNSIsAvailable() const {
+  return false;
+}
+
+int32_t AudioDevice::EnableBuiltInNS(bool enable) {
+  return -1;
+}
@@ -0,0 +1,202 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_AUDIODEVICE_H
+#define WEBRTC_AUDIODEVICE_H
+
+#include <vector>
+
+#include "Common.h"
+
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/modules/audio_device/include/audio_device.h"
+
+namespace WebRTC {
+  class AudioDevice : public webrtc::AudioDeviceModule, public rtc::MessageHandler {
+   public:
+    enum {
+      kSampleRate = 48000,
+      kChannels = 1,
+      kFrameMs = 10,
+      kFrameSamples = (kSampleRate / 1000) * kFrameMs,
+      kBufferSamples = kSampleRate,
+    };
+    
+    // Without silence a tick with nothing queued records nothing, so voice
+    // channels fed by the sinks of their track get no extra frames.
+    static rtc::scoped_refptr<AudioDevice> Create(bool silence = true);
+    
+    size_t PushRecording(const int16_t *data, size_t frames, int sample_rate = kSampleRate, size_t channels = kChannels);
+    size_t PullPlayout(int16_t *data, size_t samples);
+    
+    int64_t TimeUntilNextProcess() override;
+    void Process() override;
+    
+    int32_t ActiveAudioLayer(AudioLayer *audioLayer) const override;
+    ErrorCode LastError() const override;
+    int32_t RegisterEventObserver(webrtc::AudioDeviceObserver *eventCallback) override;
+    int32_t RegisterAudioCallback(webrtc::AudioTransport *audioCallback) override;
+    
+    int32_t Init() override;
+    int32_t Terminate() override;
+    bool Initialized() const override;
+    
+    int16_t PlayoutDevices() override;
+    int16_t RecordingDevices() override;
+    int32_t PlayoutDeviceName(uint16_t index, char name[webrtc::kAdmMaxDeviceNameSize], char guid[webrtc::kAdmMaxGuidSize]) override;
+    int32_t RecordingDeviceName(uint16_t index, char name[webrtc::kAdmMaxDeviceNameSize], char guid[webrtc::kAdmMaxGuidSize]) override;
+    
+    int32_t SetPlayoutDevice(uint16_t index) override;
+    int32_t SetPlayoutDevice(WindowsDeviceType device) override;
+    int32_t SetRecordingDevice(uint16_t index) override;
+    int32_t SetRecordingDevice(WindowsDeviceType device) override;
+    
+    int32_t PlayoutIsAvailable(bool *available) override;
+    int32_t InitPlayout() override;
+    bool PlayoutIsInitialized() const override;
+    int32_t RecordingIsAvailable(bool *available) override;
+    int32_t InitRecording() override;
+    bool RecordingIsInitialized() const override;
+    
+    int32_t StartPlayout() override;
+    int32_t StopPlayout() override;
+    bool Playing() const override;
+    int32_t StartRecording() override;
+    int32_t StopRecording() override;
+    bool Recording() const override;
+    
+    int32_t SetAGC(bool enable) override;
+    bool AGC() const override;
+    
+    int32_t SetWaveOutVolume(uint16_t volumeLeft, uint16_t volumeRight) override;
+    int32_t WaveOutVolume(uint16_t *volumeLeft, uint16_t *volumeRight) const override;
+    
+    int32_t InitSpeaker() override;
+    bool SpeakerIsInitialized() const override;
+    int32_t InitMicrophone() override;
+    bool MicrophoneIsInitialized() const override;
+    
+    int32_t SpeakerVolumeIsAvailable(bool *available) override;
+    int32_t SetSpeakerVolume(uint32_t volume) override;
+    int32_t SpeakerVolume(uint32_t *volume) const override;
+    int32_t MaxSpeakerVolume(uint32_t *maxVolume) const override;
+    int32_t MinSpeakerVolume(uint32_t *minVolume) const override;
+    int32_t SpeakerVolumeStepSize(uint16_t *stepSize) const override;
+    
+    int32_t MicrophoneVolumeIsAvailable(bool *available) override;
+    int32_t SetMicrophoneVolume(uint32_t volume) override;
+    int32_t MicrophoneVolume(uint32_t *volume) const override;
+    int32_t MaxMicrophoneVolume(uint32_t *maxVolume) const override;
+    int32_t MinMicrophoneVolume(uint32_t *minVolume) const override;
+    int32_t MicrophoneVolumeStepSize(uint16_t *stepSize) const override;
+    
+    int32_t SpeakerMuteIsAvailable(bool *available) override;
+    int32_t SetSpeakerMute(bool enable) override;
+    int32_t SpeakerMute(bool *enabled) const override;
+    int32_t MicrophoneMuteIsAvailable(bool *available) override;
+    int32_t SetMicrophoneMute(bool enable) override;
+    int32_t MicrophoneMute(bool *enabled) const override;
+    int32_t MicrophoneBoostIsAvailable(bool *available) override;
+    int32_t SetMicrophoneBoost(bool enable) override;
+    int32_t MicrophoneBoost(bool *enabled) const override;
+    
+    int32_t StereoPlayoutIsAvailable(bool *available) const override;
+    int32_t SetStereoPlayout(bool enable) override;
+    int32_t StereoPlayout(bool *enabled) const override;
+    int32_t StereoRecordingIsAvailable(bool *available) const override;
+    int32_t SetStereoRecording(bool enable) override;
+    int32_t StereoRecording(bool *enabled) const override;
+    int32_t SetRecordingChannel(const ChannelType channel) override;
+    int32_t RecordingChannel(ChannelType *channel) const override;
+    
+    int32_t SetPlayoutBuffer(const BufferType type, uint16_t sizeMS = 0) override;
+    int32_t PlayoutBuffer(BufferType *type, uint16_t *sizeMS) const override;
+    int32_t PlayoutDelay(uint16_t *delayMS) const override;
+    int32_t RecordingDelay(uint16_t *delayMS) const override;
+    int32_t CPULoad(uint16_t *load) const override;
+    
+    int32_t StartRawOutputFileRecording(const char pcmFileNameUTF8[webrtc::kAdmMaxFileNameSize]) override;
+    int32_t StopRawOutputFileRecording() override;
+    int32_t StartRawInputFileRecording(const char pcmFileNameUTF8[webrtc::kAdmMaxFileNameSize]) override;
+    int32_t StopRawInputFileRecording() override;
+    
+    int32_t SetRecordingSampleRate(const uint32_t samplesPerSec) override;
+    int32_t RecordingSampleRate(uint32_t *samplesPerSec) const override;
+    int32_t SetPlayoutSampleRate(const uint32_t samplesPerSec) override;
+    int32_t PlayoutSampleRate(uint32_t *samplesPerSec) const override;
+    
+    int32_t ResetAudioDevice() override;
+    int32_t SetLoudspeakerStatus(bool enable) override;
+    int32_t GetLoudspeakerStatus(bool *enabled) const override;
+    
+    bool BuiltInAECIsAvailable() const override;
+    int32_t EnableBuiltInAEC(bool enable) override;
+    bool BuiltInAGCIsAvailable() const override;
+    int32_t EnableBuiltInAGC(bool enable) override;
+    bool BuiltInNSIsAvailable() const override;
+    int32_t EnableBuiltInNS(bool enable) override;
+    
+    void OnMessage(rtc::Message *msg) final;
+    
+   protected:
+    explicit AudioDevice(bool silence);
+    ~AudioDevice() override;
+    
+   private:
+    void UpdateThread();
+    void ProcessFrame();
+    
+   protected:
+    mutable rtc::CriticalSection _lock;
+    rtc::CriticalSection _fifo;
+    rtc::Thread *_thread;
+    webrtc::AudioTransport *_transport;
+    
+    bool _silence;
+    bool _initialized;
+    bool _playInitialized;
+    bool _recInitialized;
+    bool _playing;
+    bool _recording;
+    bool _mute;
+    
+    int64_t _next;
+    uint32_t _level;
+    
+    std::vector<int16_t> _recBuffer;
+    size_t _recRead;
+    size_t _recSize;
+    
+    std::vector<int16_t> _playBuffer;
+    size_t _playRead;
+    size_t _playSize;
+    
+    int16_t _recFrame[kFrameSamples * kChannels];
+    int16_t _playFrame[kFrameSamples * kChannels];
+  };
+};
+
+#endif
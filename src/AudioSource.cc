@@ -0,0 +1,227 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <node_buffer.h>
+
+#include "Platform.h"
+#include "AudioSource.h"
+#include "MediaStream.h"
+#include "MediaStreamTrack.h"
+#include "MediaConstraints.h"
+#include "ArrayBuffer.h"
+
+using namespace v8;
+using namespace WebRTC;
+
+Nan::Persistent<Function> AudioSource::constructor;
+
+static int16_t *GetSamples(Local<Value> value, size_t *length) {
+  if (node::Buffer::HasInstance(value)) {
+    *length = node::Buffer::Length(value) / sizeof(int16_t);
+    return reinterpret_cast<int16_t*>(node::Buffer::Data(value));
+  }
+  
+  if (value->IsArrayBuffer()) {
+    node::ArrayBuffer *container = node::ArrayBuffer::New(value);
+    *length = container->Length() / sizeof(int16_t);
+    return reinterpret_cast<int16_t*>(container->Data());
+  }
+  
+  *length = 0;
+  return 0;
+}
+
+void AudioSource::Init(Handle<Object> exports) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::HandleScope scope;
+  
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(AudioSource::New);
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+  tpl->SetClassName(Nan::New("RTCAudioSource").ToLocalChecked());
+  
+  Nan::SetPrototypeMethod(tpl, "push", AudioSource::Push);
+  Nan::SetPrototypeMethod(tpl, "pull", AudioSource::Pull);
+  Nan::SetPrototypeMethod(tpl, "stop", AudioSource::Stop);
+  
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("track").ToLocalChecked(), AudioSource::GetTrack);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("stream").ToLocalChecked(), AudioSource::GetStream);
+  
+  constructor.Reset<Function>(tpl->GetFunction());
+  exports->Set(Nan::New("RTCAudioSource").ToLocalChecked(), tpl->GetFunction());
+}
+
+AudioSource::AudioSource() :
+  _signal(0),
+  _worker(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<MediaConstraints> constraints = MediaConstraints::New();
+  
+  // Every source records from its own device, so audio pushed into one
+  // source never mixes with another.
+  _device = AudioDevice::Create();
+  _factory = Platform::CreateFactory(&_signal, &_worker, _device.get());
+  
+  if (_factory.get()) {
+    _source = _factory->CreateAudioSource(constraints->ToConstraints());
+    
+    if (_source.get()) {
+      _track = _factory->CreateAudioTrack("audio", _source);
+      _stream = _factory->CreateLocalMediaStream("stream");
+      
+      if (_stream.get() && _track.get()) {
+        _stream->AddTrack(_track);
+      }
+    }
+  }
+}
+
+AudioSource::~AudioSource() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> AudioSource::GetFactory(Local<Value> value,
+                                                                                  rtc::Thread **signaling,
+                                                                                  rtc::Thread **worker)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!value.IsEmpty() && value->IsObject() && Local<Object>::Cast(value)->InternalFieldCount() > 0) {
+    AudioSource *self = RTCWrap::Unwrap<AudioSource>(Local<Object>::Cast(value), "AudioSource");
+    
+    if (self && self->_factory.get()) {
+      if (signaling) {
+        *signaling = self->_signal;
+      }
+      
+      if (worker) {
+        *worker = self->_worker;
+      }
+      
+      return self->_factory;
+    }
+  }
+  
+  return 0;
+}
+
+void AudioSource::New(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (info.IsConstructCall()) {
+    AudioSource *source = new AudioSource();
+    source->Wrap(info.This(), "AudioSource");
+    
+    if (!source->_track.get()) {
+      Nan::ThrowError("Internal Source Error");
+    }
+    
+    return info.GetReturnValue().Set(info.This());
+  } else {
+    Local<Function> instance = Nan::New(AudioSource::constructor);
+    return info.GetReturnValue().Set(instance->NewInstance());
+  }
+}
+
+void AudioSource::Push(const Nan::FunctionCallbackInfo<Value> &info) {
+  AudioSource *self = RTCWrap::Unwrap<AudioSource>(info.This(), "AudioSource");
+  int sample_rate = AudioDevice::kSampleRate;
+  int channels = AudioDevice::kChannels;
+  size_t length = 0;
+  size_t retval = 0;
+  
+  if (info.Length() < 1) {
+    Nan::ThrowError("Invalid Arguments");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  if (info.Length() >= 2 && info[1]->IsInt32()) {
+    sample_rate = info[1]->Int32Value();
+  }
+  
+  if (info.Length() >= 3 && info[2]->IsInt32()) {
+    channels = info[2]->Int32Value();
+  }
+  
+  if (sample_rate <= 0 || channels <= 0) {
+    Nan::ThrowError("Invalid Arguments");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  int16_t *data = GetSamples(info[0], &length);
+  
+  if (data && self->_device.get() && self->_track.get()) {
+    retval = self->_device->PushRecording(data, length / channels, sample_rate, channels);
+  }
+  
+  info.GetReturnValue().Set(Nan::New(static_cast<uint32_t>(retval)));
+}
+
+void AudioSource::Pull(const Nan::FunctionCallbackInfo<Value> &info) {
+  AudioSource *self = RTCWrap::Unwrap<AudioSource>(info.This(), "AudioSource");
+  size_t length = 0;
+  size_t retval = 0;
+  
+  if (info.Length() < 1) {
+    Nan::ThrowError("Invalid Arguments");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  int16_t *data = GetSamples(info[0], &length);
+  
+  if (data && self->_device.get()) {
+    retval = self->_device->PullPlayout(data, length);
+  }
+  
+  info.GetReturnValue().Set(Nan::New(static_cast<uint32_t>(retval)));
+}
+
+void AudioSource::Stop(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  AudioSource *self = RTCWrap::Unwrap<AudioSource>(info.This(), "AudioSource");
+  
+  if (self->_track.get()) {
+    self->_track->set_state(webrtc::MediaStreamTrackInterface::kEnded);
+  }
+  
+  info.GetReturnValue().SetUndefined();
+}
+
+void AudioSource::GetTrack(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  AudioSource *self = RTCWrap::Unwrap<AudioSource>(info.Holder(), "AudioSource");
+  info.GetReturnValue().Set(MediaStreamTrack::New(self->_track));
+}
+
+void AudioSource::GetStream(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  AudioSource *self = RTCWrap::Unwrap<AudioSource>(info.Holder(), "AudioSource");
+  info.GetReturnValue().Set(MediaStream::New(self->_stream));
+}
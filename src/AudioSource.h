@@ -0,0 +1,70 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_AUDIOSOURCE_H
+#define WEBRTC_AUDIOSOURCE_H
+
+#include "Common.h"
+#include "Wrap.h"
+#include "AudioDevice.h"
+
+namespace WebRTC {
+  class AudioSource : public RTCWrap {
+   public:
+    static void Init(v8::Handle<v8::Object> exports);
+    
+    // Factory bound to the device of the RTCAudioSource in value, peers created
+    // from it send the pushed audio and play out into the source. Null when
+    // value is not an RTCAudioSource.
+    static rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> GetFactory(v8::Local<v8::Value> value,
+                                                                                rtc::Thread **signaling = 0,
+                                                                                rtc::Thread **worker = 0);
+    
+   private:
+    AudioSource();
+    ~AudioSource() final;
+    
+    static void New(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void Push(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void Pull(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void Stop(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    
+    static void GetTrack(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    static void GetStream(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    
+   protected:
+    rtc::Thread *_signal;
+    rtc::Thread *_worker;
+    rtc::scoped_refptr<AudioDevice> _device;
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> _factory;
+    rtc::scoped_refptr<webrtc::AudioTrackInterface> _track;
+    rtc::scoped_refptr<webrtc::MediaStreamInterface> _stream;
+    rtc::scoped_refptr<webrtc::AudioSourceInterface> _source;
+    
+    static Nan::Persistent<v8::Function> constructor;
+  };
+};
+
+#endif
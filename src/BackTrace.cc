@@ -24,42 +24,382 @@
 */
 
 #ifdef USE_BACKTRACE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 #include "BackTrace.h"
 
 BackTrace BackTrace::landmine;
 
-void BackTrace::Dump(const char *event, int skip) {
-  void *stack[50] = {0};
-  int count = 0, cur = 0;
-  
-  count = backtrace(stack, sizeof(stack));
-  
-  if (count) {
-    for (int index = (count - 1); index > skip && index >= 1; index--) {
-      char addr[128] = {0};
-      Dl_info info;
-     
-      snprintf(addr, sizeof(addr), "%p", stack[index]);
-     
-      if (dladdr(stack[index], &info) && info.dli_sname) {
-        char buffer[128] = {0};
-        size_t len = sizeof(buffer);
-        int status = 0;
-
-        (void) abi::__cxa_demangle(info.dli_sname, buffer, &len, &status);
+// Not used by Node.js itself, SIGUSR1 belongs to the inspector.
+#define kBackTraceSignal SIGUSR2
+#define kBackTraceFrames 64
+
+enum BackTraceCapture {
+  kBackTraceIdle,
+  kBackTraceRequested,
+  kBackTraceRunning,
+  kBackTraceDone,
+};
+
+static pthread_mutex_t capture_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int capture_state = kBackTraceIdle;
+static void *capture_stack[kBackTraceFrames];
+static int capture_count = 0;
+static bool capture_installed = false;
+
+#define kBackTraceEvents 256
+#define kBackTraceRings 128
+
+struct BackTraceEvent {
+  int64_t time;
+  const char *event;
+  const char *object;
+  const void *id;
+  int64_t value;
+};
+
+// Written only by the owning thread, read only while crashing.
+struct BackTraceRing {
+  uint64_t thread;
+  char name[16];
+  volatile uint32_t head;
+  BackTraceEvent events[kBackTraceEvents];
+};
+
+static __thread BackTraceRing *ring = 0;
+static __thread bool ring_full = false;
+static BackTraceRing *volatile rings[kBackTraceRings];
+static volatile int ring_count = 0;
+
+static char crash_path[256] = {0};
+static Dl_info crash_module;
+
+std::string BackTrace::Symbolize(void *address) {
+  Dl_info info;
+  
+  if (dladdr(address, &info) && info.dli_sname) {
+    int status = 0;
+    char *buffer = abi::__cxa_demangle(info.dli_sname, 0, 0, &status);
+    
+    if (buffer) {
+      std::string name(status ? info.dli_sname : buffer);
+      free(buffer);
+      
+      return name;
+    }
+    
+    return info.dli_sname;
+  }
+  
+  return "function()";
+}
+
+bool BackTrace::Capture(pthread_t thread, std::vector<std::string> *stack, int timeout) {
+  bool done = false;
+  
+  pthread_mutex_lock(&capture_lock);
+  
+  if (!capture_installed) {
+    struct sigaction action;
+    
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    
+    action.sa_flags = SA_RESTART;
+    action.sa_handler = BackTrace::OnCapture;
+    
+    // The first backtrace() call loads libgcc, which is not safe to do
+    // from inside the signal handler.
+    backtrace(capture_stack, 1);
+    
+    sigaction(kBackTraceSignal, &action, 0);
+    capture_installed = true;
+  }
+  
+  // A handler given up on by an earlier call still owns capture_stack.
+  if (__sync_fetch_and_add(&capture_state, 0) == kBackTraceRunning) {
+    pthread_mutex_unlock(&capture_lock);
+    return false;
+  }
+  
+  __sync_lock_test_and_set(&capture_state, kBackTraceRequested);
+  
+  if (!pthread_kill(thread, kBackTraceSignal)) {
+    for (int waited = 0; waited < timeout * 10 && !done; waited++) {
+      done = (__sync_fetch_and_add(&capture_state, 0) == kBackTraceDone);
+      
+      if (!done) {
+        usleep(100);
+      }
+    }
+    
+    // A late signal finds the request withdrawn and does nothing, unless the
+    // handler already started, then it gets one more timeout to finish.
+    if (!done && !__sync_bool_compare_and_swap(&capture_state, kBackTraceRequested, kBackTraceIdle)) {
+      for (int waited = 0; waited < timeout * 10 && !done; waited++) {
+        done = (__sync_fetch_and_add(&capture_state, 0) == kBackTraceDone);
         
-        if (!status) {
-          printf("%d: %s [%s] %s\n", cur, event, addr, buffer);
-        } else {
-          printf("%d: %s [%s] %s\n", cur, event, addr, info.dli_sname);
+        if (!done) {
+          usleep(100);
         }
+      }
+      
+      // Still running, leave the state alone so no other capture reuses
+      // the buffer before the handler is done with it.
+      if (!done) {
+        pthread_mutex_unlock(&capture_lock);
+        return false;
+      }
+    }
+  }
+  
+  if (done) {
+    char addr[32] = {0};
+    
+    // Skips OnCapture() and the signal trampoline.
+    for (int index = 2; index < capture_count; index++) {
+      snprintf(addr, sizeof(addr), "%p ", capture_stack[index]);
+      stack->push_back(addr + BackTrace::Symbolize(capture_stack[index]));
+    }
+  }
+  
+  __sync_lock_test_and_set(&capture_state, kBackTraceIdle);
+  pthread_mutex_unlock(&capture_lock);
+  
+  return done;
+}
+
+static BackTraceRing *RegisterRing() {
+  if (ring_full) {
+    return 0;
+  }
+  
+  int index = __sync_fetch_and_add(&ring_count, 1);
+  
+  // Threads are never unregistered, late ones go without a recorder.
+  if (index >= kBackTraceRings) {
+    ring_full = true;
+    return 0;
+  }
+  
+  ring = static_cast<BackTraceRing*>(calloc(1, sizeof(BackTraceRing)));
+  
+  // The slot stays empty, the crash report skips it.
+  if (!ring) {
+    ring_full = true;
+    return 0;
+  }
+  
+#if defined(__linux__)
+  ring->thread = static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  pthread_threadid_np(0, &ring->thread);
+#endif
+  
+  pthread_getname_np(pthread_self(), ring->name, sizeof(ring->name));
+  
+  __sync_synchronize();
+  rings[index] = ring;
+  
+  return ring;
+}
+
+void BackTrace::Record(const char *event, const char *object, const void *id, int64_t value) {
+  BackTraceRing *current = ring ? ring : RegisterRing();
+  
+  if (!current) {
+    return;
+  }
+  
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  
+  uint32_t head = current->head;
+  BackTraceEvent *entry = &current->events[head & (kBackTraceEvents - 1)];
+  
+  entry->time = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  entry->event = event;
+  entry->object = object;
+  entry->id = id;
+  entry->value = value;
+  
+  __sync_synchronize();
+  current->head = head + 1;
+}
+
+// Helpers below run inside signal handlers, nothing may allocate, lock or
+// use stdio.
+
+static void WriteBuffer(int fd, const char *data, size_t length) {
+  while (length) {
+    ssize_t written = write(fd, data, length);
+    
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    
+    if (written <= 0) {
+      return;
+    }
+    
+    data += written;
+    length -= written;
+  }
+}
+
+static void WriteString(int fd, const char *value) {
+  size_t length = 0;
+  
+  if (!value) {
+    value = "-";
+  }
+  
+  while (value[length]) {
+    length++;
+  }
+  
+  WriteBuffer(fd, value, length);
+}
+
+static void WriteNumber(int fd, uint64_t value, int base) {
+  char buffer[24];
+  size_t index = sizeof(buffer);
+  
+  do {
+    buffer[--index] = "0123456789abcdef"[value % base];
+    value /= base;
+  } while (value);
+  
+  if (base == 16) {
+    WriteString(fd, "0x");
+  }
+  
+  WriteBuffer(fd, buffer + index, sizeof(buffer) - index);
+}
+
+static void WriteMaps(int fd) {
+#if defined(__linux__)
+  int maps = open("/proc/self/maps", O_RDONLY);
+  char buffer[1024];
+  ssize_t length;
+  
+  if (maps < 0) {
+    return;
+  }
+  
+  while ((length = read(maps, buffer, sizeof(buffer))) > 0) {
+    WriteBuffer(fd, buffer, length);
+  }
+  
+  close(maps);
+#endif
+}
+
+void BackTrace::Crash(const char *event) {
+  void *stack[kBackTraceFrames];
+  int count = backtrace(stack, kBackTraceFrames);
+  int fd = STDERR_FILENO;
+  
+  if (crash_path[0]) {
+    int file = open(crash_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    
+    if (file >= 0) {
+      fd = file;
+    }
+  }
+  
+  WriteString(fd, "*** webrtc-native crash: ");
+  WriteString(fd, event);
+  WriteString(fd, "\nmodule ");
+  WriteString(fd, crash_module.dli_fname);
+  WriteString(fd, " ");
+  WriteNumber(fd, reinterpret_cast<uintptr_t>(crash_module.dli_fbase), 16);
+  WriteString(fd, "\n");
+  
+  for (int index = 0; index < count; index++) {
+    WriteString(fd, "frame ");
+    WriteNumber(fd, reinterpret_cast<uintptr_t>(stack[index]), 16);
+    WriteString(fd, "\n");
+  }
+  
+  int registered = __sync_fetch_and_add(&ring_count, 0);
+  
+  if (registered > kBackTraceRings) {
+    registered = kBackTraceRings;
+  }
+  
+  for (int index = 0; index < registered; index++) {
+    BackTraceRing *current = rings[index];
+    
+    if (!current) {
+      continue;
+    }
+    
+    uint32_t head = current->head;
+    uint32_t first = (head > kBackTraceEvents) ? (head - kBackTraceEvents) : 0;
+    
+    WriteString(fd, "thread ");
+    WriteNumber(fd, current->thread, 10);
+    WriteString(fd, " ");
+    WriteString(fd, current->name[0] ? current->name : "-");
+    WriteString(fd, "\n");
+    
+    // Oldest first, the owner may still be writing the newest entries.
+    for (uint32_t sequence = first; sequence != head; sequence++) {
+      const BackTraceEvent *entry = &current->events[sequence & (kBackTraceEvents - 1)];
+      
+      if (!entry->event) {
+        continue;
+      }
+      
+      WriteString(fd, "event ");
+      WriteNumber(fd, static_cast<uint64_t>(entry->time), 10);
+      WriteString(fd, " ");
+      WriteString(fd, entry->event);
+      WriteString(fd, " ");
+      WriteString(fd, entry->object);
+      WriteString(fd, " ");
+      WriteNumber(fd, reinterpret_cast<uintptr_t>(entry->id), 16);
+      WriteString(fd, " ");
+      
+      if (entry->value < 0) {
+        WriteString(fd, "-");
+        WriteNumber(fd, static_cast<uint64_t>(-entry->value), 10);
       } else {
-        printf("%d: %s [%s] function()\n", cur, event, addr);
+        WriteNumber(fd, static_cast<uint64_t>(entry->value), 10);
       }
       
-      cur++;
+      WriteString(fd, "\n");
     }
   }
+  
+  WriteString(fd, "maps\n");
+  WriteMaps(fd);
+  WriteString(fd, "*** end\n");
+  
+  if (fd != STDERR_FILENO) {
+    close(fd);
+  }
+}
+
+void BackTrace::OnCapture(int sig) {
+  int error = errno;
+  
+  if (__sync_bool_compare_and_swap(&capture_state, kBackTraceRequested, kBackTraceRunning)) {
+    capture_count = backtrace(capture_stack, kBackTraceFrames);
+    __sync_lock_test_and_set(&capture_state, kBackTraceDone);
+  }
+  
+  errno = error;
 }
 
 void BackTrace::Close() {
@@ -75,26 +415,38 @@ void BackTrace::Close() {
 }
 
 void BackTrace::OnSegv(int sig) {
-  BackTrace::Dump("SIGSEGV", 2);
+  BackTrace::Crash("SIGSEGV");
   landmine.Close();
 }
 
 void BackTrace::OnBus(int sig) {
-  BackTrace::Dump("SIGBUS", 2);
+  BackTrace::Crash("SIGBUS");
   landmine.Close();
 }
 
 void BackTrace::OnAbort(int sig) {
-  BackTrace::Dump("SIGABRT", 2);
+  BackTrace::Crash("SIGABRT");
   landmine.Close();
 }
 
 void BackTrace::OnIll(int sig) {
-  BackTrace::Dump("SIGILL", 2);
+  BackTrace::Crash("SIGILL");
   landmine.Close();
 }
 
 BackTrace::BackTrace() {
+  const char *path = getenv("WEBRTC_CRASH_LOG");
+  
+  if (path) {
+    strncpy(crash_path, path, sizeof(crash_path) - 1);
+  }
+  
+  // Load address of the addon for offline symbolization where no memory
+  // map can be read, and backtrace() primed outside of signal handlers.
+  memset(&crash_module, 0, sizeof(crash_module));
+  dladdr(reinterpret_cast<void*>(BackTrace::Crash), &crash_module);
+  backtrace(capture_stack, 1);
+  
   sigemptyset(&_segv.sa_mask);
   sigemptyset(&_bus.sa_mask);
   sigemptyset(&_abrt.sa_mask);
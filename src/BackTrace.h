@@ -32,10 +32,30 @@
 #include <execinfo.h>
 #include <dlfcn.h>
 #include <cxxabi.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
 
 class BackTrace {
  public:
-  static void Dump(const char *event = "NOEVENT", int skip = 1);
+  static std::string Symbolize(void *address);
+  
+  // Interrupts another thread with a signal and collects its stack, waits
+  // at most timeout milliseconds for the thread to answer and as long again
+  // for a handler that already started.
+  static bool Capture(pthread_t thread, std::vector<std::string> *stack, int timeout = 100);
+  
+  // Flight recorder, appends to a ring of recent events owned by the
+  // calling thread. Names must be string literals, they are written out as
+  // is when the process crashes.
+  static void Record(const char *event, const char *object, const void *id, int64_t value);
+  
+  // Writes the crashing stack as raw addresses, every thread's recent
+  // events and the memory map using write(2) only. Safe in signal handlers,
+  // scripts/symbolize.js turns the addresses into function names.
+  static void Crash(const char *event);
   
  private:
   explicit BackTrace();
@@ -47,6 +67,7 @@ class BackTrace {
   static void OnBus(int sig);
   static void OnAbort(int sig);
   static void OnIll(int sig);
+  static void OnCapture(int sig);
 
  protected:
   struct sigaction _segv;
@@ -57,7 +78,11 @@ class BackTrace {
   static BackTrace landmine;
 };
 
+#define BACKTRACE_RECORD(event, object, id, value) BackTrace::Record(event, object, id, value)
+
 #else
 
+#define BACKTRACE_RECORD(event, object, id, value)
+
 #endif
 #endif
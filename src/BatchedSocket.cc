@@ -0,0 +1,378 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include "BatchedSocket.h"
+
+#if defined(WEBRTC_LINUX)
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "webrtc/base/timeutils.h"
+
+using namespace WebRTC;
+
+#define kBatchSize 32
+#define kBatchPacketSize 2048
+
+enum BatchedSocketMessage {
+  kBatchedSocketFlush,
+};
+
+BatchedUdpSocket::BatchedUdpSocket(rtc::Thread *thread, int fd) :
+  _thread(thread),
+  _fd(fd),
+  _error(0),
+  _flushError(0),
+  _sendErrors(0),
+  _truncated(0),
+  _buffer(kBatchSize * kBatchPacketSize)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  sockaddr_storage address;
+  socklen_t length = sizeof(address);
+  
+  if (!getsockname(_fd, reinterpret_cast<sockaddr*>(&address), &length)) {
+    rtc::SocketAddressFromSockAddrStorage(address, &_address);
+  }
+  
+  fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+  static_cast<rtc::PhysicalSocketServer*>(_thread->socketserver())->Add(this);
+}
+
+BatchedUdpSocket::~BatchedUdpSocket() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  BatchedUdpSocket::Close();
+}
+
+BatchedUdpSocket *BatchedUdpSocket::Create(rtc::Thread *thread, const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  int fd = socket(address.family(), SOCK_DGRAM, 0);
+  
+  if (fd < 0) {
+    return 0;
+  }
+  
+  uint16_t first = min_port, last = max_port;
+  
+  if (!min_port && !max_port) {
+    first = last = address.port();
+  }
+  
+  for (uint32_t port = first; port <= last; port++) {
+    rtc::SocketAddress local(address.ipaddr(), static_cast<int>(port));
+    sockaddr_storage storage;
+    socklen_t length = local.ToSockAddrStorage(&storage);
+    
+    if (!bind(fd, reinterpret_cast<sockaddr*>(&storage), length)) {
+      return new BatchedUdpSocket(thread, fd);
+    }
+  }
+  
+  LOG(LS_WARNING) << "Unable to bind batched UDP socket on " << address.ipaddr().ToString();
+  close(fd);
+  return 0;
+}
+
+BatchedUdpSocket *BatchedUdpSocket::Wrap(rtc::Thread *thread, int fd) {
+  return new BatchedUdpSocket(thread, fd);
+}
+
+rtc::SocketAddress BatchedUdpSocket::GetLocalAddress() const {
+  return _address;
+}
+
+rtc::SocketAddress BatchedUdpSocket::GetRemoteAddress() const {
+  return rtc::SocketAddress();
+}
+
+int BatchedUdpSocket::Send(const void *data, size_t size, const rtc::PacketOptions &options) {
+  _error = ENOTCONN;
+  return -1;
+}
+
+int BatchedUdpSocket::SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) {
+  if (_fd < 0) {
+    _error = EBADF;
+    return -1;
+  }
+  
+  // A batch flushed at the end of the last loop turn failed, report it on
+  // this send so the caller sees the socket is in trouble.
+  if (_flushError) {
+    _error = _flushError;
+    _flushError = 0;
+    return -1;
+  }
+  
+  if (_queue.empty()) {
+    _thread->Post(this, kBatchedSocketFlush);
+  }
+  
+  _queue.push_back(Packet());
+  
+  Packet &packet = _queue.back();
+  
+  packet.data.SetData(static_cast<const uint8_t*>(data), size);
+  packet.address = address;
+  packet.id = options.packet_id;
+  
+  // A full queue is sent right away, this datagram is part of that batch.
+  if (_queue.size() >= kBatchSize) {
+    BatchedUdpSocket::Flush();
+    
+    if (_flushError) {
+      _error = _flushError;
+      _flushError = 0;
+      return -1;
+    }
+  }
+  
+  return static_cast<int>(size);
+}
+
+void BatchedUdpSocket::Flush() {
+  if (_queue.empty()) {
+    return;
+  }
+  
+  size_t count = _queue.size();
+  std::vector<mmsghdr> messages(count);
+  std::vector<iovec> vectors(count);
+  std::vector<sockaddr_storage> addresses(count);
+  std::vector<bool> failed(count, false);
+  
+  for (size_t index = 0; index < count; index++) {
+    vectors[index].iov_base = _queue[index].data.data();
+    vectors[index].iov_len = _queue[index].data.size();
+    
+    memset(&messages[index], 0, sizeof(mmsghdr));
+    messages[index].msg_hdr.msg_name = &addresses[index];
+    messages[index].msg_hdr.msg_namelen = _queue[index].address.ToSockAddrStorage(&addresses[index]);
+    messages[index].msg_hdr.msg_iov = &vectors[index];
+    messages[index].msg_hdr.msg_iovlen = 1;
+  }
+  
+  size_t offset = 0;
+  
+  while (offset < count) {
+    int sent = sendmmsg(_fd, &messages[offset], count - offset, 0);
+    
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    
+    // sendmmsg fails on the first datagram it could not send, skip just
+    // that one and carry on with the rest of the batch.
+    if (sent <= 0) {
+      _error = (sent < 0) ? errno : EIO;
+      _flushError = _error;
+      _sendErrors++;
+      failed[offset] = true;
+      
+      LOG(LS_VERBOSE) << "Dropped datagram to " << _queue[offset].address.ToString() << ", error " << _error << " (" << _sendErrors << " send errors)";
+      
+      offset++;
+      continue;
+    }
+    
+    offset += sent;
+  }
+  
+  int64_t now = rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec;
+  
+  for (size_t index = 0; index < count; index++) {
+    if (!failed[index]) {
+      SignalSentPacket(this, rtc::SentPacket(_queue[index].id, now));
+    }
+  }
+  
+  _queue.clear();
+}
+
+int BatchedUdpSocket::Close() {
+  if (_fd >= 0) {
+    BatchedUdpSocket::Flush();
+    
+    _thread->Clear(this);
+    static_cast<rtc::PhysicalSocketServer*>(_thread->socketserver())->Remove(this);
+    
+    close(_fd);
+    _fd = -1;
+  }
+  
+  return 0;
+}
+
+rtc::AsyncPacketSocket::State BatchedUdpSocket::GetState() const {
+  return (_fd < 0) ? rtc::AsyncPacketSocket::STATE_CLOSED : rtc::AsyncPacketSocket::STATE_BOUND;
+}
+
+static bool GetSocketOption(rtc::Socket::Option option, int family, int *level, int *name) {
+  switch (option) {
+    case rtc::Socket::OPT_RCVBUF:
+      *level = SOL_SOCKET;
+      *name = SO_RCVBUF;
+      return true;
+    case rtc::Socket::OPT_SNDBUF:
+      *level = SOL_SOCKET;
+      *name = SO_SNDBUF;
+      return true;
+    case rtc::Socket::OPT_DSCP:
+      *level = (family == AF_INET6) ? IPPROTO_IPV6 : IPPROTO_IP;
+      *name = (family == AF_INET6) ? IPV6_TCLASS : IP_TOS;
+      return true;
+    case rtc::Socket::OPT_DONTFRAGMENT:
+      *level = IPPROTO_IP;
+      *name = IP_MTU_DISCOVER;
+      return true;
+    default:
+      return false;
+  }
+}
+
+int BatchedUdpSocket::GetOption(rtc::Socket::Option option, int *value) {
+  int level, name;
+  socklen_t length = sizeof(*value);
+  
+  if (!GetSocketOption(option, _address.family(), &level, &name)) {
+    return -1;
+  }
+  
+  int result = getsockopt(_fd, level, name, value, &length);
+  
+  if (!result && option == rtc::Socket::OPT_DSCP) {
+    *value >>= 2;
+  } else if (!result && option == rtc::Socket::OPT_DONTFRAGMENT) {
+    *value = (*value != IP_PMTUDISC_DONT);
+  }
+  
+  return result;
+}
+
+int BatchedUdpSocket::SetOption(rtc::Socket::Option option, int value) {
+  int level, name;
+  
+  if (!GetSocketOption(option, _address.family(), &level, &name)) {
+    return -1;
+  }
+  
+  if (option == rtc::Socket::OPT_DSCP) {
+    value <<= 2;
+  } else if (option == rtc::Socket::OPT_DONTFRAGMENT) {
+    value = value ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT;
+  }
+  
+  return setsockopt(_fd, level, name, &value, sizeof(value));
+}
+
+int BatchedUdpSocket::GetError() const {
+  return _error;
+}
+
+void BatchedUdpSocket::SetError(int error) {
+  _error = error;
+}
+
+uint32_t BatchedUdpSocket::GetRequestedEvents() {
+  return rtc::DE_READ;
+}
+
+void BatchedUdpSocket::OnPreEvent(uint32_t events) {
+}
+
+void BatchedUdpSocket::OnEvent(uint32_t events, int error) {
+  if (!(events & rtc::DE_READ) || _fd < 0) {
+    return;
+  }
+  
+  mmsghdr messages[kBatchSize];
+  iovec vectors[kBatchSize];
+  sockaddr_storage addresses[kBatchSize];
+  int received;
+  
+  do {
+    for (int index = 0; index < kBatchSize; index++) {
+      vectors[index].iov_base = &_buffer[index * kBatchPacketSize];
+      vectors[index].iov_len = kBatchPacketSize;
+      
+      memset(&messages[index], 0, sizeof(mmsghdr));
+      messages[index].msg_hdr.msg_name = &addresses[index];
+      messages[index].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+      messages[index].msg_hdr.msg_iov = &vectors[index];
+      messages[index].msg_hdr.msg_iovlen = 1;
+    }
+    
+    received = recvmmsg(_fd, messages, kBatchSize, MSG_DONTWAIT, 0);
+    
+    if (received < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        _error = errno;
+        LOG(LS_WARNING) << "recvmmsg failed, error " << _error;
+      }
+      
+      return;
+    }
+    
+    rtc::PacketTime time(rtc::TimeNanos() / rtc::kNumNanosecsPerMicrosec, 0);
+    
+    for (int index = 0; index < received && _fd >= 0; index++) {
+      rtc::SocketAddress remote;
+      
+      // Datagrams larger than a slot arrive cut short, never pass them on.
+      if (messages[index].msg_hdr.msg_flags & MSG_TRUNC) {
+        _truncated++;
+        LOG(LS_WARNING) << "Dropped datagram larger than " << kBatchPacketSize << " bytes (" << _truncated << " truncated)";
+        continue;
+      }
+      
+      rtc::SocketAddressFromSockAddrStorage(addresses[index], &remote);
+      SignalReadPacket(this, static_cast<const char*>(vectors[index].iov_base), messages[index].msg_len, remote, time);
+    }
+    
+    // A full batch means more may be waiting, keep draining.
+  } while (received == kBatchSize && _fd >= 0);
+}
+
+int BatchedUdpSocket::GetDescriptor() {
+  return _fd;
+}
+
+bool BatchedUdpSocket::IsDescriptorClosed() {
+  return false;
+}
+
+void BatchedUdpSocket::OnMessage(rtc::Message *msg) {
+  BatchedUdpSocket::Flush();
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_BATCHEDSOCKET_H
+#define WEBRTC_BATCHEDSOCKET_H
+
+#include <vector>
+
+#include "Logging.h"
+
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/thread.h"
+
+namespace WebRTC {
+#if defined(WEBRTC_LINUX)
+  // UDP socket for Platform workers that drains the receive queue with
+  // recvmmsg and coalesces sends made during one message loop turn into a
+  // single sendmmsg.
+  class BatchedUdpSocket : public rtc::AsyncPacketSocket, public rtc::Dispatcher, public rtc::MessageHandler {
+   public:
+    static BatchedUdpSocket *Create(rtc::Thread *thread, const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port);
+    static BatchedUdpSocket *Wrap(rtc::Thread *thread, int fd);
+    
+    ~BatchedUdpSocket() override;
+    
+    rtc::SocketAddress GetLocalAddress() const override;
+    rtc::SocketAddress GetRemoteAddress() const override;
+    
+    int Send(const void *data, size_t size, const rtc::PacketOptions &options) override;
+    int SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) override;
+    int Close() override;
+    
+    State GetState() const override;
+    int GetOption(rtc::Socket::Option option, int *value) override;
+    int SetOption(rtc::Socket::Option option, int value) override;
+    int GetError() const override;
+    void SetError(int error) override;
+    
+    uint32_t GetRequestedEvents() override;
+    void OnPreEvent(uint32_t events) override;
+    void OnEvent(uint32_t events, int error) override;
+    int GetDescriptor() override;
+    bool IsDescriptorClosed() override;
+    
+    void OnMessage(rtc::Message *msg) final;
+    
+   private:
+    BatchedUdpSocket(rtc::Thread *thread, int fd);
+    
+    void Flush();
+    
+   protected:
+    struct Packet {
+      rtc::Buffer data;
+      rtc::SocketAddress address;
+      int id;
+    };
+    
+    rtc::Thread *_thread;
+    int _fd;
+    int _error;
+    int _flushError;
+    uint64_t _sendErrors;
+    uint64_t _truncated;
+    rtc::SocketAddress _address;
+    std::vector<Packet> _queue;
+    std::vector<char> _buffer;
+  };
+#endif
+};
+
+#endif
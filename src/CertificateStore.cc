@@ -0,0 +1,490 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <utility>
+
+#include "Platform.h"
+#include "CertificateStore.h"
+
+using namespace v8;
+using namespace WebRTC;
+
+#define kCertificateName "WebRTC"
+#define kCertificatePoolSize 8
+
+enum CertificateEvent {
+  kCertificateRequestDone,
+};
+
+static uint64_t Now() {
+  return static_cast<uint64_t>(time(NULL)) * 1000;
+}
+
+static bool GetKeyParams(Local<Value> value, rtc::KeyParams *params) {
+  Local<Value> name_value = value;
+  Local<Object> algorithm;
+  
+  if (!value.IsEmpty() && value->IsObject()) {
+    algorithm = Local<Object>::Cast(value);
+    name_value = algorithm->Get(Nan::New("name").ToLocalChecked());
+  }
+  
+  if (name_value.IsEmpty() || !name_value->IsString()) {
+    return false;
+  }
+  
+  String::Utf8Value name_utf8(name_value->ToString());
+  std::string name(*name_utf8);
+  
+  std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+  
+  if (name == "ECDSA") {
+    if (!algorithm.IsEmpty()) {
+      Local<Value> curve = algorithm->Get(Nan::New("namedCurve").ToLocalChecked());
+      
+      if (!curve.IsEmpty() && curve->IsString()) {
+        String::Utf8Value curve_name(curve->ToString());
+        
+        if (strcmp(*curve_name, "P-256")) {
+          return false;
+        }
+      }
+    }
+    
+    *params = rtc::KeyParams::ECDSA(rtc::EC_NIST_P256);
+    return true;
+  }
+  
+  if (name == "RSA" || name == "RSASSA-PKCS1-V1_5") {
+    int modulus = rtc::kRsaDefaultModSize;
+    
+    if (!algorithm.IsEmpty()) {
+      Local<Value> length = algorithm->Get(Nan::New("modulusLength").ToLocalChecked());
+      
+      if (!length.IsEmpty() && length->IsUint32()) {
+        modulus = static_cast<int>(length->Uint32Value());
+      }
+    }
+    
+    *params = rtc::KeyParams::RSA(modulus, rtc::kRsaDefaultExponent);
+    return params->IsValid();
+  }
+  
+  return false;
+}
+
+Nan::Persistent<Function> RTCCertificate::constructor;
+
+void RTCCertificate::Init() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::HandleScope scope;
+  
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(RTCCertificate::New);
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+  tpl->SetClassName(Nan::New("RTCCertificate").ToLocalChecked());
+  
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("expires").ToLocalChecked(), RTCCertificate::GetExpires);
+  
+  constructor.Reset(tpl->GetFunction());
+}
+
+RTCCertificate::~RTCCertificate() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+Local<Value> RTCCertificate::New(const rtc::scoped_refptr<rtc::RTCCertificate> &certificate) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::EscapableHandleScope scope;
+  Local<Function> instance = Nan::New(RTCCertificate::constructor);
+  
+  if (instance.IsEmpty() || !certificate.get()) {
+    return scope.Escape(Nan::Null());
+  }
+  
+  Local<Object> ret = instance->NewInstance();
+  RTCCertificate *self = RTCWrap::Unwrap<RTCCertificate>(ret, "RTCCertificate");
+  
+  if (self) {
+    self->_certificate = certificate;
+  }
+  
+  return scope.Escape(ret);
+}
+
+rtc::scoped_refptr<rtc::RTCCertificate> RTCCertificate::Unwrap(Local<Value> value) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!value.IsEmpty() && value->IsObject()) {
+    RTCCertificate *self = RTCWrap::Unwrap<RTCCertificate>(Local<Object>::Cast(value), "RTCCertificate");
+    
+    if (self) {
+      return self->_certificate;
+    }
+  }
+  
+  return 0;
+}
+
+void RTCCertificate::New(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (info.IsConstructCall()) {
+    RTCCertificate *certificate = new RTCCertificate();
+    certificate->Wrap(info.This(), "RTCCertificate");
+    return info.GetReturnValue().Set(info.This());
+  }
+  
+  Nan::ThrowError("Internal Error");
+  info.GetReturnValue().SetUndefined();
+}
+
+void RTCCertificate::GetExpires(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  RTCCertificate *self = RTCWrap::Unwrap<RTCCertificate>(info.Holder(), "RTCCertificate");
+  
+  if (self && self->_certificate.get()) {
+    return info.GetReturnValue().Set(Nan::New(static_cast<double>(self->_certificate->Expires())));
+  }
+  
+  info.GetReturnValue().SetUndefined();
+}
+
+CertificateRequest::CertificateRequest(const rtc::KeyParams &params,
+                                       Local<Value> onsuccess,
+                                       Local<Value> onerror) :
+  _params(params)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!onsuccess.IsEmpty() && onsuccess->IsFunction()) {
+    _onsuccess.Reset<Function>(Local<Function>::Cast(onsuccess));
+  }
+  
+  if (!onerror.IsEmpty() && onerror->IsFunction()) {
+    _onerror.Reset<Function>(Local<Function>::Cast(onerror));
+  }
+}
+
+CertificateRequest::~CertificateRequest() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _onsuccess.Reset();
+  _onerror.Reset();
+}
+
+void CertificateRequest::OnMessage(rtc::Message *msg) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _certificate = CertificateStore::Generate(_params);
+  CertificateStore::Instance()->Emit<CertificateRequest*>(kCertificateRequestDone, this);
+}
+
+void CertificateRequest::Complete() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::HandleScope scope;
+  Local<Value> argv[1];
+  
+  if (!_certificate.get()) {
+    if (!_onerror.IsEmpty()) {
+      Local<Function> callback = Nan::New<Function>(_onerror);
+      argv[0] = Nan::Error("Certificate generation failed");
+      
+      callback->Call(Nan::GetCurrentContext()->Global(), 1, argv);
+    } else {
+      Nan::TryCatch tryCatch;
+      Nan::ThrowError("Certificate generation failed");
+      Nan::FatalException(tryCatch);
+    }
+    
+    return;
+  }
+  
+  if (!_onsuccess.IsEmpty()) {
+    Local<Function> callback = Nan::New<Function>(_onsuccess);
+    argv[0] = RTCCertificate::New(_certificate);
+    
+    callback->Call(Nan::GetCurrentContext()->Global(), 1, argv);
+  }
+}
+
+CertificateStore::CertificateStore() :
+  _policy(kCertificatePolicyNone),
+  _params(rtc::KeyParams::ECDSA(rtc::EC_NIST_P256)),
+  _size(0),
+  _filling(false),
+  _pending(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  SetEmitterName("CertificateStore");
+}
+
+CertificateStore::~CertificateStore() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+void CertificateStore::Init(Handle<Object> exports) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  RTCCertificate::Init();
+  CertificateStore::Instance()->Configure(kCertificatePolicyPool, rtc::KeyParams::ECDSA(rtc::EC_NIST_P256), kCertificatePoolSize);
+  
+  exports->Set(Nan::New("generateCertificate").ToLocalChecked(), Nan::New<FunctionTemplate>(CertificateStore::GenerateCertificate)->GetFunction());
+  exports->Set(Nan::New("setCertificatePolicy").ToLocalChecked(), Nan::New<FunctionTemplate>(CertificateStore::SetCertificatePolicy)->GetFunction());
+}
+
+void CertificateStore::Dispose() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  CertificateStore *self = CertificateStore::Instance();
+  rtc::CritScope lock(&self->_lock);
+  
+  self->_policy = kCertificatePolicyNone;
+  self->_pool.clear();
+  self->_shared = NULL;
+}
+
+CertificateStore *CertificateStore::Instance() {
+  static CertificateStore *store = new CertificateStore();
+  return store;
+}
+
+rtc::scoped_refptr<rtc::RTCCertificate> CertificateStore::Generate(const rtc::KeyParams &params) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_ptr<rtc::SSLIdentity> identity(rtc::SSLIdentity::Generate(kCertificateName, params));
+  
+  if (!identity.get()) {
+    return NULL;
+  }
+  
+  return rtc::RTCCertificate::Create(std::move(identity));
+}
+
+rtc::scoped_refptr<rtc::RTCCertificate> CertificateStore::Take() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  rtc::scoped_refptr<rtc::RTCCertificate> certificate;
+  uint64_t now = Now();
+  
+  switch (_policy) {
+    case kCertificatePolicyShared:
+      if (_shared.get() && _shared->HasExpired(now)) {
+        _shared = NULL;
+      }
+      
+      certificate = _shared;
+      break;
+    case kCertificatePolicyPool:
+      while (!_pool.empty() && !certificate.get()) {
+        certificate = _pool.back();
+        _pool.pop_back();
+        
+        if (certificate->HasExpired(now)) {
+          certificate = NULL;
+        }
+      }
+      
+      break;
+    default:
+      return NULL;
+  }
+  
+  // An empty pool leaves generation to WebRTC for this peer only.
+  CertificateStore::Fill();
+  return certificate;
+}
+
+void CertificateStore::Queue(CertificateRequest *request) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!_pending++) {
+    EventEmitter::SetReference(true);
+  }
+  
+  Platform::GetWorker()->Post(request);
+}
+
+void CertificateStore::Configure(CertificatePolicy policy, const rtc::KeyParams &params, size_t size) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  
+  if (params != _params) {
+    _pool.clear();
+    _shared = NULL;
+  }
+  
+  if (policy != kCertificatePolicyShared) {
+    _shared = NULL;
+  }
+  
+  if (policy != kCertificatePolicyPool) {
+    _pool.clear();
+  }
+  
+  _policy = policy;
+  _params = params;
+  _size = size;
+  
+  while (_pool.size() > _size) {
+    _pool.pop_back();
+  }
+  
+  CertificateStore::Fill();
+}
+
+void CertificateStore::Fill() {
+  if (_filling) {
+    return;
+  }
+  
+  if ((_policy == kCertificatePolicyPool && _pool.size() < _size) ||
+      (_policy == kCertificatePolicyShared && !_shared.get()))
+  {
+    _filling = true;
+    Platform::GetWorker()->Post(this);
+  }
+}
+
+void CertificateStore::OnMessage(rtc::Message *msg) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::KeyParams params(rtc::KeyParams::ECDSA(rtc::EC_NIST_P256));
+  
+  {
+    rtc::CritScope lock(&_lock);
+    params = _params;
+  }
+  
+  // Generate outside the lock, Take() must never wait on key generation.
+  rtc::scoped_refptr<rtc::RTCCertificate> certificate = CertificateStore::Generate(params);
+  rtc::CritScope lock(&_lock);
+  
+  _filling = false;
+  
+  if (!certificate.get()) {
+    LOG(LS_ERROR) << "Certificate generation failed";
+    return;
+  }
+  
+  if (params == _params) {
+    if (_policy == kCertificatePolicyPool && _pool.size() < _size) {
+      _pool.push_back(certificate);
+    } else if (_policy == kCertificatePolicyShared && !_shared.get()) {
+      _shared = certificate;
+    }
+  }
+  
+  CertificateStore::Fill();
+}
+
+void CertificateStore::On(Event *event) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  CertificateRequest *request = event->Unwrap<CertificateRequest*>();
+  
+  if (request) {
+    request->Complete();
+    delete request;
+  }
+  
+  if (!--_pending) {
+    EventEmitter::SetReference(false);
+  }
+}
+
+void CertificateStore::GenerateCertificate(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::KeyParams params(rtc::KeyParams::ECDSA(rtc::EC_NIST_P256));
+  
+  if (info.Length() >= 1 && !info[0]->IsUndefined() && !GetKeyParams(info[0], &params)) {
+    Local<Value> argv[1] = { Nan::Error("Unsupported keygenAlgorithm") };
+    
+    if (!info[2].IsEmpty() && info[2]->IsFunction()) {
+      Local<Function> onerror = Local<Function>::Cast(info[2]);
+      onerror->Call(info.This(), 1, argv);
+    } else {
+      Nan::ThrowError(argv[0]);
+    }
+    
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  CertificateStore::Instance()->Queue(new CertificateRequest(params, info[1], info[2]));
+  info.GetReturnValue().SetUndefined();
+}
+
+void CertificateStore::SetCertificatePolicy(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  CertificateStore *self = CertificateStore::Instance();
+  CertificatePolicy policy = kCertificatePolicyPool;
+  rtc::KeyParams params(rtc::KeyParams::ECDSA(rtc::EC_NIST_P256));
+  size_t size = kCertificatePoolSize;
+  
+  if (info.Length() < 1 || !info[0]->IsObject()) {
+    Nan::ThrowError("Invalid Argument");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  Local<Object> options = Local<Object>::Cast(info[0]);
+  Local<Value> policy_value = options->Get(Nan::New("policy").ToLocalChecked());
+  Local<Value> key_value = options->Get(Nan::New("keyType").ToLocalChecked());
+  Local<Value> size_value = options->Get(Nan::New("poolSize").ToLocalChecked());
+  
+  if (!policy_value.IsEmpty() && policy_value->IsString()) {
+    String::Utf8Value name(policy_value->ToString());
+    
+    if (!strcmp(*name, "none")) {
+      policy = kCertificatePolicyNone;
+    } else if (!strcmp(*name, "shared")) {
+      policy = kCertificatePolicyShared;
+    } else if (strcmp(*name, "pool")) {
+      Nan::ThrowError("Invalid policy");
+      return info.GetReturnValue().SetUndefined();
+    }
+  }
+  
+  if (!key_value.IsEmpty() && !key_value->IsUndefined() && !GetKeyParams(key_value, &params)) {
+    Nan::ThrowError("Invalid keyType");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  if (!size_value.IsEmpty() && size_value->IsUint32()) {
+    size = size_value->Uint32Value();
+  }
+  
+  self->Configure(policy, params, size);
+  info.GetReturnValue().SetUndefined();
+}
@@ -0,0 +1,120 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_CERTIFICATESTORE_H
+#define WEBRTC_CERTIFICATESTORE_H
+
+#include <vector>
+
+#include "Common.h"
+#include "EventEmitter.h"
+#include "Wrap.h"
+
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/rtccertificate.h"
+#include "webrtc/base/sslidentity.h"
+
+namespace WebRTC {
+  class RTCCertificate : public RTCWrap {
+   public:
+    static void Init();
+    static v8::Local<v8::Value> New(const rtc::scoped_refptr<rtc::RTCCertificate> &certificate);
+    static rtc::scoped_refptr<rtc::RTCCertificate> Unwrap(v8::Local<v8::Value> value);
+    
+   private:
+    ~RTCCertificate() final;
+    
+    static void New(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void GetExpires(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    
+   protected:
+    static Nan::Persistent<v8::Function> constructor;
+    rtc::scoped_refptr<rtc::RTCCertificate> _certificate;
+  };
+  
+  enum CertificatePolicy {
+    kCertificatePolicyNone,
+    kCertificatePolicyPool,
+    kCertificatePolicyShared,
+  };
+  
+  class CertificateRequest : public rtc::MessageHandler {
+   public:
+    CertificateRequest(const rtc::KeyParams &params,
+                       v8::Local<v8::Value> onsuccess,
+                       v8::Local<v8::Value> onerror);
+    
+    ~CertificateRequest() override;
+    
+    void OnMessage(rtc::Message *msg) final;
+    void Complete();
+    
+   protected:
+    rtc::KeyParams _params;
+    rtc::scoped_refptr<rtc::RTCCertificate> _certificate;
+    
+    Nan::Persistent<v8::Function> _onsuccess;
+    Nan::Persistent<v8::Function> _onerror;
+  };
+  
+  // Keeps DTLS certificates generated ahead of time on a Platform worker, so
+  // new peers don't pay for key generation while connecting.
+  class CertificateStore : public EventEmitter, public rtc::MessageHandler {
+   public:
+    static void Init(v8::Handle<v8::Object> exports);
+    static void Dispose();
+    static CertificateStore *Instance();
+    
+    static rtc::scoped_refptr<rtc::RTCCertificate> Generate(const rtc::KeyParams &params);
+    
+    rtc::scoped_refptr<rtc::RTCCertificate> Take();
+    void Queue(CertificateRequest *request);
+    
+    void On(Event *event) final;
+    void OnMessage(rtc::Message *msg) final;
+    
+   private:
+    CertificateStore();
+    ~CertificateStore() final;
+    
+    static void GenerateCertificate(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void SetCertificatePolicy(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    
+    void Configure(CertificatePolicy policy, const rtc::KeyParams &params, size_t size);
+    void Fill();
+    
+   protected:
+    rtc::CriticalSection _lock;
+    CertificatePolicy _policy;
+    rtc::KeyParams _params;
+    size_t _size;
+    bool _filling;
+    int _pending;
+    std::vector<rtc::scoped_refptr<rtc::RTCCertificate> > _pool;
+    rtc::scoped_refptr<rtc::RTCCertificate> _shared;
+  };
+};
+
+#endif
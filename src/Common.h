@@ -59,11 +59,7 @@
 #include "webrtc/media/engine/webrtcvideocapturerfactory.h"
 #include "webrtc/modules/video_capture/video_capture_factory.h"
 
-#ifdef WIN32
-#ifndef __PRETTY_FUNCTION__
-#define __PRETTY_FUNCTION__ __FUNCTION__
-#endif
-#endif
+#include "Logging.h"
 
 #include <queue>
 #include <string>
@@ -24,6 +24,7 @@
 */
 
 #include "DataChannel.h"
+#include "HistogramObject.h"
 
 using namespace v8;
 using namespace WebRTC;
@@ -41,6 +42,7 @@ void DataChannel::Init() {
   
   Nan::SetPrototypeMethod(tpl, "close", DataChannel::Close);
   Nan::SetPrototypeMethod(tpl, "send", DataChannel::Send);
+  Nan::SetPrototypeMethod(tpl, "getLatencyHistogram", DataChannel::GetLatencyHistogram);
   
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("id").ToLocalChecked(), DataChannel::GetId);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("label").ToLocalChecked(), DataChannel::GetLabel);
@@ -64,12 +66,18 @@ void DataChannel::Init() {
 DataChannel::DataChannel() {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  SetEmitterName("DataChannel");
+  
   _observer = new rtc::RefCountedObject<DataChannelObserver>(this);
 }
 
 DataChannel::~DataChannel() {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  if (_probe.get()) {
+    _probe->Stop();
+  }
+  
   if (_socket.get()) {  
     _socket->UnregisterObserver();
     _observer->RemoveListener(this);
@@ -97,7 +105,9 @@ void DataChannel::New(const Nan::FunctionCallbackInfo<Value> &info) {
   info.GetReturnValue().SetUndefined();
 }
 
-Local<Value> DataChannel::New(rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel) {
+Local<Value> DataChannel::New(rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel,
+                              rtc::scoped_refptr<LatencyProbe> probe)
+{
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   Nan::EscapableHandleScope scope;
@@ -112,6 +122,7 @@ Local<Value> DataChannel::New(rtc::scoped_refptr<webrtc::DataChannelInterface> d
 
   self->SetReference(true);
   self->_socket = dataChannel;
+  self->_probe = probe;
   self->_socket->RegisterObserver(self->_observer.get());
   self->Emit(kDataChannelStateChange);
 
@@ -130,8 +141,13 @@ void DataChannel::Close(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   DataChannel *self = RTCWrap::Unwrap<DataChannel>(info.This(), "DataChannel");
+  self->Trace("close");
   webrtc::DataChannelInterface *socket = self->GetSocket();
   
+  if (self->_probe.get()) {
+    self->_probe->Stop();
+  }
+  
   if (socket) {
     webrtc::DataChannelInterface::DataState state(socket->state());
     
@@ -145,10 +161,26 @@ void DataChannel::Close(const Nan::FunctionCallbackInfo<Value> &info) {
   info.GetReturnValue().SetUndefined();
 }
 
+void DataChannel::GetLatencyHistogram(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  DataChannel *self = RTCWrap::Unwrap<DataChannel>(info.This(), "DataChannel");
+  
+  if (!self->_probe.get()) {
+    return info.GetReturnValue().Set(Nan::Null());
+  }
+  
+  Histogram histogram;
+  
+  self->_probe->GetHistogram(&histogram, info.Length() && info[0]->IsTrue());
+  info.GetReturnValue().Set(HistogramToObject(histogram));
+}
+
 void DataChannel::Send(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
 
   DataChannel *self = RTCWrap::Unwrap<DataChannel>(info.This(), "DataChannel");
+  self->Trace("send");
   webrtc::DataChannelInterface *socket = self->GetSocket();
   bool retval = false;
 
@@ -31,6 +31,7 @@
 #include "EventEmitter.h"
 #include "Wrap.h"
 #include "ArrayBuffer.h"
+#include "LatencyProbe.h"
 
 namespace WebRTC {
   enum DataChannelEvent {
@@ -42,7 +43,8 @@ namespace WebRTC {
   class DataChannel : public RTCWrap, public EventEmitter {    
    public:    
     static void Init();
-    static v8::Local<v8::Value> New(rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel);
+    static v8::Local<v8::Value> New(rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel,
+                                   rtc::scoped_refptr<LatencyProbe> probe = rtc::scoped_refptr<LatencyProbe>());
     
    private:
     DataChannel();
@@ -51,6 +53,7 @@ namespace WebRTC {
     static void New(const Nan::FunctionCallbackInfo<v8::Value> &info);
     static void Close(const Nan::FunctionCallbackInfo<v8::Value> &info);
     static void Send(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void GetLatencyHistogram(const Nan::FunctionCallbackInfo<v8::Value> &info);
 
     static void GetId(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
     static void GetLabel(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
@@ -82,6 +85,7 @@ namespace WebRTC {
    protected:
     rtc::scoped_refptr<DataChannelObserver> _observer;
     rtc::scoped_refptr<webrtc::DataChannelInterface> _socket;
+    rtc::scoped_refptr<LatencyProbe> _probe;
     
     Nan::Persistent<v8::String> _binaryType;
     
@@ -0,0 +1,192 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#if defined(WEBRTC_LINUX)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include <string.h>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/timeutils.h"
+
+#include "DeviceCache.h"
+
+using namespace WebRTC;
+
+// Hotplug is only watched on Linux, elsewhere the list expires sooner.
+#if defined(WEBRTC_LINUX)
+static const int64_t kDeviceCacheTtl = 30000;
+#else
+static const int64_t kDeviceCacheTtl = 5000;
+#endif
+
+static rtc::CriticalSection cache_lock;
+static std::vector<SourceInfo> cache_devices;
+static std::unordered_map<std::string, size_t> cache_index;
+static std::unordered_set<std::string> cache_misses;
+static int64_t cache_expires = 0;
+
+#if defined(WEBRTC_LINUX)
+static int cache_watch = -1;
+#endif
+
+void DeviceCache::GetDevices(std::vector<SourceInfo> *list) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&cache_lock);
+  
+  if (!DeviceCache::IsValid()) {
+    DeviceCache::Refresh();
+  }
+  
+  list->insert(list->end(), cache_devices.begin(), cache_devices.end());
+}
+
+bool DeviceCache::Find(const std::string &key, SourceInfo *device) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&cache_lock);
+  bool refreshed = false;
+  
+  if (!DeviceCache::IsValid()) {
+    DeviceCache::Refresh();
+    refreshed = true;
+  }
+  
+  std::unordered_map<std::string, size_t>::iterator index = cache_index.find(key);
+  
+  // A miss may be a device plugged in since the last refresh, probe once
+  // more. Keys still missing are remembered until the list is refreshed.
+  if (index == cache_index.end() && !refreshed && !cache_misses.count(key)) {
+    DeviceCache::Refresh();
+    index = cache_index.find(key);
+  }
+  
+  if (index == cache_index.end()) {
+    cache_misses.insert(key);
+    return false;
+  }
+  
+  *device = cache_devices[index->second];
+  return true;
+}
+
+void DeviceCache::Invalidate() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&cache_lock);
+  cache_expires = 0;
+}
+
+bool DeviceCache::IsValid() {
+  bool valid = ((rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec) < cache_expires);
+  
+#if defined(WEBRTC_LINUX)
+  if (cache_watch >= 0) {
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+    
+    // Drain pending /dev notifications without blocking, any video node change invalidates the list.
+    while ((length = read(cache_watch, buffer, sizeof(buffer))) > 0) {
+      for (char *ptr = buffer; ptr < buffer + length; ) {
+        struct inotify_event *event = reinterpret_cast<struct inotify_event*>(ptr);
+        
+        if (event->len && !strncmp(event->name, "video", 5)) {
+          valid = false;
+        }
+        
+        ptr += sizeof(struct inotify_event) + event->len;
+      }
+    }
+  }
+#endif
+  
+  return valid;
+}
+
+void DeviceCache::Refresh() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+#if defined(WEBRTC_LINUX)
+  if (cache_watch < 0) {
+    cache_watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    
+    if (cache_watch >= 0 && inotify_add_watch(cache_watch, "/dev", IN_CREATE | IN_DELETE) < 0) {
+      close(cache_watch);
+      cache_watch = -1;
+    }
+  }
+#endif
+  
+  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> video_info(webrtc::VideoCaptureFactory::CreateDeviceInfo(0));
+  
+  cache_devices.clear();
+  cache_index.clear();
+  cache_misses.clear();
+
+  if (video_info) {
+    int num_devices = video_info->NumberOfDevices();
+    
+    for (int i = 0; i < num_devices; ++i) {
+      const uint32_t kSize = 256;
+      char name[kSize] = {0};
+      char id[kSize] = {0};
+      
+      if (video_info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
+        SourceInfo device;
+        int num_caps = video_info->NumberOfCapabilities(id);
+        
+        device.kind = "video";
+        device.label = name;
+        device.id = id;
+        
+        for (int cap = 0; cap < num_caps; cap++) {
+          webrtc::VideoCaptureCapability capability;
+          
+          if (!video_info->GetCapability(id, cap, capability)) {
+            SourceCapability format;
+            
+            format.width = capability.width;
+            format.height = capability.height;
+            format.frameRate = capability.maxFPS;
+            
+            device.capabilities.push_back(format);
+          }
+        }
+        
+        cache_index.insert(std::make_pair(device.id, cache_devices.size()));
+        cache_index.insert(std::make_pair(device.label, cache_devices.size()));
+        cache_devices.push_back(device);
+      }
+    }
+  }
+  
+  cache_expires = (rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec) + kDeviceCacheTtl;
+}
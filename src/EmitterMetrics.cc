@@ -0,0 +1,208 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+
+#include "EmitterMetrics.h"
+#include "HistogramObject.h"
+
+#include "webrtc/base/timeutils.h"
+
+using namespace v8;
+using namespace WebRTC;
+
+volatile int EmitterMetrics::_enabled = 0;
+
+static rtc::CriticalSection registry_lock;
+static std::map<std::string, EmitterMetrics*> registry;
+
+void EmitterMetrics::Init(Handle<Object> exports) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  const char *env = getenv("WEBRTC_EMITTER_METRICS");
+  
+  if (env && *env && strcmp(env, "0")) {
+    EmitterMetrics::SetEnabled(true);
+  }
+  
+  exports->Set(Nan::New("getEmitterMetrics").ToLocalChecked(), Nan::New<FunctionTemplate>(EmitterMetrics::GetEmitterMetrics)->GetFunction());
+  exports->Set(Nan::New("setEmitterMetrics").ToLocalChecked(), Nan::New<FunctionTemplate>(EmitterMetrics::SetEmitterMetrics)->GetFunction());
+}
+
+EmitterMetrics *EmitterMetrics::Get(const char *name) {
+  rtc::CritScope lock(&registry_lock);
+  std::map<std::string, EmitterMetrics*>::iterator index = registry.find(name);
+  
+  if (index != registry.end()) {
+    return index->second;
+  }
+  
+  // Lives as long as the process, emitters keep plain pointers to it.
+  EmitterMetrics *metrics = new EmitterMetrics(name);
+  registry[name] = metrics;
+  
+  return metrics;
+}
+
+void EmitterMetrics::SetEnabled(bool enabled) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::AtomicOps::ReleaseStore(&_enabled, enabled ? 1 : 0);
+}
+
+void EmitterMetrics::ResetAll() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&registry_lock);
+  std::map<std::string, EmitterMetrics*>::iterator index;
+  
+  for (index = registry.begin(); index != registry.end(); index++) {
+    index->second->Reset();
+  }
+}
+
+EmitterMetrics::EmitterMetrics(const std::string &name) : _name(name) {
+  EmitterMetrics::Reset();
+}
+
+void EmitterMetrics::Reset() {
+  rtc::CritScope lock(&_crit);
+  
+  _emitted = 0;
+  _dispatched = 0;
+  _asyncSends = 0;
+  _wakeups = 0;
+  _queueHighWater = 0;
+  
+  _latency.Reset();
+  _batch.Reset();
+  _lock = LockTime();
+  _list = LockTime();
+}
+
+void EmitterMetrics::OnEmit(size_t depth, bool async, int64_t locked, int64_t listed) {
+  rtc::CritScope lock(&_crit);
+  
+  _emitted++;
+  
+  if (async) {
+    _asyncSends++;
+    _lock.Record(locked);
+    
+    if (depth > _queueHighWater) {
+      _queueHighWater = depth;
+    }
+  }
+  
+  _list.Record(listed);
+}
+
+void EmitterMetrics::OnWakeup() {
+  rtc::CritScope lock(&_crit);
+  _wakeups++;
+}
+
+void EmitterMetrics::OnDispatch(int64_t queued, int64_t locked) {
+  rtc::CritScope lock(&_crit);
+  
+  _dispatched++;
+  _lock.Record(locked);
+  
+  // Events queued while recording was off carry no timestamp.
+  if (queued) {
+    _latency.Record((rtc::TimeNanos() - queued) / rtc::kNumNanosecsPerMicrosec);
+  }
+}
+
+void EmitterMetrics::OnPass(size_t events, int64_t locked) {
+  rtc::CritScope lock(&_crit);
+  
+  _lock.Record(locked);
+  _batch.Record(static_cast<int64_t>(events));
+}
+
+Local<Object> EmitterMetrics::ToObject() {
+  Nan::EscapableHandleScope scope;
+  Local<Object> retval = Nan::New<Object>();
+  Local<Object> lockTime = Nan::New<Object>();
+  Local<Object> listTime = Nan::New<Object>();
+  
+  rtc::CritScope lock(&_crit);
+  
+  lockTime->Set(Nan::New("count").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_lock.count)));
+  lockTime->Set(Nan::New("total").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_lock.total) / rtc::kNumNanosecsPerMicrosec));
+  lockTime->Set(Nan::New("max").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_lock.max) / rtc::kNumNanosecsPerMicrosec));
+  
+  listTime->Set(Nan::New("count").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_list.count)));
+  listTime->Set(Nan::New("total").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_list.total) / rtc::kNumNanosecsPerMicrosec));
+  listTime->Set(Nan::New("max").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_list.max) / rtc::kNumNanosecsPerMicrosec));
+  
+  retval->Set(Nan::New("emitted").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_emitted)));
+  retval->Set(Nan::New("dispatched").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_dispatched)));
+  retval->Set(Nan::New("asyncSends").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_asyncSends)));
+  retval->Set(Nan::New("wakeups").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_wakeups)));
+  retval->Set(Nan::New("queueHighWater").ToLocalChecked(), Nan::New<Number>(static_cast<double>(_queueHighWater)));
+  retval->Set(Nan::New("latency").ToLocalChecked(), HistogramToObject(_latency));
+  retval->Set(Nan::New("eventsPerPass").ToLocalChecked(), HistogramToObject(_batch));
+  retval->Set(Nan::New("lockTime").ToLocalChecked(), lockTime);
+  retval->Set(Nan::New("listTime").ToLocalChecked(), listTime);
+  
+  return scope.Escape(retval);
+}
+
+void EmitterMetrics::GetEmitterMetrics(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Local<Object> retval = Nan::New<Object>();
+  std::map<std::string, EmitterMetrics*> metrics;
+  
+  {
+    rtc::CritScope lock(&registry_lock);
+    metrics = registry;
+  }
+  
+  std::map<std::string, EmitterMetrics*>::iterator index;
+  
+  for (index = metrics.begin(); index != metrics.end(); index++) {
+    retval->Set(Nan::New(index->first.c_str()).ToLocalChecked(), index->second->ToObject());
+  }
+  
+  info.GetReturnValue().Set(retval);
+}
+
+void EmitterMetrics::SetEmitterMetrics(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (info.Length() && !info[0].IsEmpty()) {
+    EmitterMetrics::SetEnabled(info[0]->IsTrue());
+  }
+  
+  if (info.Length() > 1 && info[1]->IsTrue()) {
+    EmitterMetrics::ResetAll();
+  }
+  
+  info.GetReturnValue().SetUndefined();
+}
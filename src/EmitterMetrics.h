@@ -0,0 +1,101 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_EMITTERMETRICS_H
+#define WEBRTC_EMITTERMETRICS_H
+
+#include <string>
+
+#include "Common.h"
+#include "Histogram.h"
+
+#include "webrtc/base/criticalsection.h"
+
+namespace WebRTC {
+  // Event queue statistics shared by every emitter of one class. Recording is
+  // off by default and then costs EventEmitter a single atomic load per
+  // Emit() / dispatch pass.
+  class EmitterMetrics {
+   public:
+    static void Init(v8::Handle<v8::Object> exports);
+    static EmitterMetrics *Get(const char *name);
+    
+    static inline bool IsEnabled() {
+      return rtc::AtomicOps::AcquireLoad(&_enabled) != 0;
+    }
+    
+    static void SetEnabled(bool enabled);
+    static void ResetAll();
+    
+    void OnEmit(size_t depth, bool async, int64_t locked, int64_t listed);
+    void OnWakeup();
+    void OnDispatch(int64_t queued, int64_t locked);
+    void OnPass(size_t events, int64_t locked);
+    
+   private:
+    explicit EmitterMetrics(const std::string &name);
+    
+    static void GetEmitterMetrics(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void SetEmitterMetrics(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    
+    void Reset();
+    v8::Local<v8::Object> ToObject();
+    
+   protected:
+    struct LockTime {
+      LockTime() : count(0), total(0), max(0) { }
+      
+      void Record(int64_t held) {
+        count++;
+        total += held;
+        
+        if (held > max) {
+          max = held;
+        }
+      }
+      
+      uint64_t count;
+      int64_t total;
+      int64_t max;
+    };
+    
+    static volatile int _enabled;
+    
+    std::string _name;
+    rtc::CriticalSection _crit;
+    
+    uint64_t _emitted;
+    uint64_t _dispatched;
+    uint64_t _asyncSends;
+    uint64_t _wakeups;
+    size_t _queueHighWater;
+    
+    Histogram _latency;
+    Histogram _batch;
+    LockTime _lock;
+    LockTime _list;
+  };
+};
+
+#endif
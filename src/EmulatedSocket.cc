@@ -0,0 +1,215 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include <algorithm>
+
+#include "EmulatedSocket.h"
+
+#include "webrtc/base/timeutils.h"
+
+using namespace WebRTC;
+
+enum EmulatedSocketMessage {
+  kEmulatedSocketSend,
+};
+
+struct EmulatedPacket : public rtc::MessageData {
+  EmulatedPacket(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) :
+    data(static_cast<const uint8_t*>(data), size),
+    address(address),
+    options(options)
+  { }
+  
+  rtc::Buffer data;
+  rtc::SocketAddress address;
+  rtc::PacketOptions options;
+};
+
+static int64_t Now() {
+  return rtc::TimeNanos() / rtc::kNumNanosecsPerMicrosec;
+}
+
+EmulatedSocket::EmulatedSocket(rtc::Thread *thread, rtc::AsyncPacketSocket *socket, const EmulationOptions &options) :
+  _thread(thread),
+  _socket(socket),
+  _options(options),
+  _random(options.seed ? options.seed : std::random_device()()),
+  _bursting(false),
+  _linkFree(0),
+  _lastDelivery(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _socket->SignalReadPacket.connect(this, &EmulatedSocket::OnReadPacket);
+  _socket->SignalSentPacket.connect(this, &EmulatedSocket::OnSentPacket);
+  _socket->SignalReadyToSend.connect(this, &EmulatedSocket::OnReadyToSend);
+  _socket->SignalAddressReady.connect(this, &EmulatedSocket::OnAddressReady);
+  _socket->SignalClose.connect(this, &EmulatedSocket::OnClose);
+}
+
+EmulatedSocket::~EmulatedSocket() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _thread->Clear(this);
+}
+
+rtc::SocketAddress EmulatedSocket::GetLocalAddress() const {
+  return _socket->GetLocalAddress();
+}
+
+rtc::SocketAddress EmulatedSocket::GetRemoteAddress() const {
+  return _socket->GetRemoteAddress();
+}
+
+int EmulatedSocket::Send(const void *data, size_t size, const rtc::PacketOptions &options) {
+  return EmulatedSocket::SendTo(data, size, _socket->GetRemoteAddress(), options);
+}
+
+int EmulatedSocket::SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) {
+  int64_t now = Now();
+  int64_t departure = now;
+  
+  // Token bucket: the link drains at bandwidth bits/s and may run up to
+  // burst bytes ahead, anything beyond queue bytes of backlog is tail dropped.
+  if (_options.bandwidth > 0) {
+    int64_t credit = static_cast<int64_t>(_options.burst) * 8000000 / _options.bandwidth;
+    int64_t transmit = static_cast<int64_t>(size) * 8000000 / _options.bandwidth;
+    
+    _linkFree = std::max(_linkFree, now - credit);
+    
+    if (_options.queue > 0 && (_linkFree - now) * _options.bandwidth / 8000000 > _options.queue) {
+      SignalSentPacket(this, rtc::SentPacket(options.packet_id, now / 1000));
+      return static_cast<int>(size);
+    }
+    
+    _linkFree += transmit;
+    departure = std::max(now, _linkFree);
+  }
+  
+  if (EmulatedSocket::Drop()) {
+    SignalSentPacket(this, rtc::SentPacket(options.packet_id, now / 1000));
+    return static_cast<int>(size);
+  }
+  
+  int64_t delivery = departure;
+  
+  // Reordered packets skip the delay line and overtake the ones queued in it.
+  if (_options.reorder <= 0 || std::uniform_real_distribution<double>(0, 1)(_random) >= _options.reorder) {
+    delivery = std::max(departure + EmulatedSocket::Delay(), _lastDelivery);
+    _lastDelivery = delivery;
+  }
+  
+  if (delivery <= now) {
+    return _socket->SendTo(data, size, address, options);
+  }
+  
+  _thread->PostDelayed(static_cast<int>((delivery - now + 999) / 1000), this, kEmulatedSocketSend, new EmulatedPacket(data, size, address, options));
+  return static_cast<int>(size);
+}
+
+bool EmulatedSocket::Drop() {
+  std::uniform_real_distribution<double> chance(0, 1);
+  
+  // Gilbert-Elliott: burstEnter / burstExit move between the good and the
+  // bad state, where packets are lost with burstLoss instead of loss.
+  if (_options.burstEnter > 0) {
+    if (_bursting) {
+      _bursting = chance(_random) >= _options.burstExit;
+    } else {
+      _bursting = chance(_random) < _options.burstEnter;
+    }
+  }
+  
+  double loss = _bursting ? _options.burstLoss : _options.loss;
+  return loss > 0 && chance(_random) < loss;
+}
+
+int64_t EmulatedSocket::Delay() {
+  double delay = _options.delay;
+  
+  if (_options.jitter > 0) {
+    if (_options.distribution == kEmulationNormal) {
+      delay += std::normal_distribution<double>(0, _options.jitter)(_random);
+    } else {
+      delay += std::uniform_real_distribution<double>(-_options.jitter, _options.jitter)(_random);
+    }
+  }
+  
+  return static_cast<int64_t>(std::max(delay, 0.0) * 1000);
+}
+
+int EmulatedSocket::Close() {
+  _thread->Clear(this);
+  return _socket->Close();
+}
+
+rtc::AsyncPacketSocket::State EmulatedSocket::GetState() const {
+  return _socket->GetState();
+}
+
+int EmulatedSocket::GetOption(rtc::Socket::Option option, int *value) {
+  return _socket->GetOption(option, value);
+}
+
+int EmulatedSocket::SetOption(rtc::Socket::Option option, int value) {
+  return _socket->SetOption(option, value);
+}
+
+int EmulatedSocket::GetError() const {
+  return _socket->GetError();
+}
+
+void EmulatedSocket::SetError(int error) {
+  _socket->SetError(error);
+}
+
+void EmulatedSocket::OnMessage(rtc::Message *msg) {
+  EmulatedPacket *packet = static_cast<EmulatedPacket*>(msg->pdata);
+  
+  if (msg->message_id == kEmulatedSocketSend) {
+    _socket->SendTo(packet->data.data(), packet->data.size(), packet->address, packet->options);
+  }
+  
+  delete packet;
+}
+
+void EmulatedSocket::OnReadPacket(rtc::AsyncPacketSocket *socket, const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time) {
+  SignalReadPacket(this, data, size, address, time);
+}
+
+void EmulatedSocket::OnSentPacket(rtc::AsyncPacketSocket *socket, const rtc::SentPacket &packet) {
+  SignalSentPacket(this, packet);
+}
+
+void EmulatedSocket::OnReadyToSend(rtc::AsyncPacketSocket *socket) {
+  SignalReadyToSend(this);
+}
+
+void EmulatedSocket::OnAddressReady(rtc::AsyncPacketSocket *socket, const rtc::SocketAddress &address) {
+  SignalAddressReady(this, address);
+}
+
+void EmulatedSocket::OnClose(rtc::AsyncPacketSocket *socket, int error) {
+  SignalClose(this, error);
+}
@@ -0,0 +1,131 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_EMULATEDSOCKET_H
+#define WEBRTC_EMULATEDSOCKET_H
+
+#include <random>
+
+#include "Logging.h"
+
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/thread.h"
+
+namespace WebRTC {
+  enum EmulationDistribution {
+    kEmulationUniform,
+    kEmulationNormal,
+  };
+  
+  // Conditions applied to everything a peer sends, see
+  // configuration.networkEmulation in README.md.
+  struct EmulationOptions {
+    EmulationOptions() :
+      delay(0),
+      jitter(0),
+      distribution(kEmulationUniform),
+      loss(0),
+      burstEnter(0),
+      burstExit(1),
+      burstLoss(1),
+      reorder(0),
+      bandwidth(0),
+      burst(0),
+      queue(0),
+      seed(0)
+    { }
+    
+    bool IsDefault() const {
+      return !delay && !jitter && !loss && !burstEnter && !reorder && !bandwidth;
+    }
+    
+    bool Equals(const EmulationOptions &other) const {
+      return delay == other.delay && jitter == other.jitter && distribution == other.distribution &&
+             loss == other.loss && burstEnter == other.burstEnter && burstExit == other.burstExit &&
+             burstLoss == other.burstLoss && reorder == other.reorder && bandwidth == other.bandwidth &&
+             burst == other.burst && queue == other.queue && seed == other.seed;
+    }
+    
+    int delay;
+    int jitter;
+    EmulationDistribution distribution;
+    double loss;
+    double burstEnter;
+    double burstExit;
+    double burstLoss;
+    double reorder;
+    int64_t bandwidth;
+    int burst;
+    int queue;
+    uint32_t seed;
+  };
+  
+  // Wraps a socket owned by a Platform worker and delays, drops, reorders and
+  // rate limits outgoing packets on that worker before handing them to the
+  // real socket.
+  class EmulatedSocket : public rtc::AsyncPacketSocket, public rtc::MessageHandler {
+   public:
+    EmulatedSocket(rtc::Thread *thread, rtc::AsyncPacketSocket *socket, const EmulationOptions &options);
+    ~EmulatedSocket() override;
+    
+    rtc::SocketAddress GetLocalAddress() const override;
+    rtc::SocketAddress GetRemoteAddress() const override;
+    
+    int Send(const void *data, size_t size, const rtc::PacketOptions &options) override;
+    int SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) override;
+    int Close() override;
+    
+    State GetState() const override;
+    int GetOption(rtc::Socket::Option option, int *value) override;
+    int SetOption(rtc::Socket::Option option, int value) override;
+    int GetError() const override;
+    void SetError(int error) override;
+    
+    void OnMessage(rtc::Message *msg) final;
+    
+   private:
+    bool Drop();
+    int64_t Delay();
+    
+    void OnReadPacket(rtc::AsyncPacketSocket *socket, const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time);
+    void OnSentPacket(rtc::AsyncPacketSocket *socket, const rtc::SentPacket &packet);
+    void OnReadyToSend(rtc::AsyncPacketSocket *socket);
+    void OnAddressReady(rtc::AsyncPacketSocket *socket, const rtc::SocketAddress &address);
+    void OnClose(rtc::AsyncPacketSocket *socket, int error);
+    
+   protected:
+    rtc::Thread *_thread;
+    rtc::scoped_ptr<rtc::AsyncPacketSocket> _socket;
+    EmulationOptions _options;
+    std::mt19937 _random;
+    bool _bursting;
+    int64_t _linkFree;
+    int64_t _lastDelivery;
+  };
+};
+
+#endif
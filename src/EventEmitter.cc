@@ -25,9 +25,15 @@
 
 #include "EventEmitter.h"
 
+#include "webrtc/base/timeutils.h"
+
 using namespace WebRTC;
 
-EventEmitter::EventEmitter(uv_loop_t *loop, bool notify) : _notify(notify) {
+EventEmitter::EventEmitter(uv_loop_t *loop, bool notify) :
+  _notify(notify),
+  _name(notify ? "NotifyEmitter" : "EventEmitter"),
+  _metrics(EmitterMetrics::Get(_name))
+{
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
 
   uv_mutex_init(&_list);
@@ -155,28 +161,67 @@ void EventEmitter::Emit(int event) {
   EventEmitter::Emit(new rtc::RefCountedObject<Event>(event));
 }
 
+void EventEmitter::SetEmitterName(const char *name) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _name = name;
+  _metrics = EmitterMetrics::Get(name);
+}
+
 void EventEmitter::Emit(rtc::scoped_refptr<Event> event) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  bool metrics = EmitterMetrics::IsEnabled();
+  int64_t locked = 0, listed = 0;
+  size_t depth = 0;
+  
   if (event.get()) {
+    EventEmitter::Trace("emit", event->_event);
+    
     if (!_notify) {
       uv_mutex_lock(&_lock);
       
+      if (metrics) {
+        locked = rtc::TimeNanos();
+        
+        // Forwarded events keep the time of their first enqueue.
+        if (!event->_queued) {
+          event->_queued = locked;
+        }
+      }
+      
       _events.push(event);  
       uv_async_send(_async);
+      depth = _events.size();
+      
+      if (metrics) {
+        locked = rtc::TimeNanos() - locked;
+      }
   
       uv_mutex_unlock(&_lock);
     }
     
     uv_mutex_lock(&_list);
     
+    if (metrics) {
+      listed = rtc::TimeNanos();
+    }
+    
     std::vector<EventEmitter*>::iterator index;
     
     for (index = _listeners.begin(); index < _listeners.end(); index++) {
       (*index)->Emit(event);
     }
     
+    if (metrics) {
+      listed = rtc::TimeNanos() - listed;
+    }
+    
     uv_mutex_unlock(&_list);
+    
+    if (metrics) {
+      _metrics->OnEmit(depth, !_notify, locked, listed);
+    }
   }
 }
 
@@ -210,6 +255,10 @@ void EventEmitter::onAsync(uv_async_t *handle, int status) {
   EventEmitter *self = static_cast<EventEmitter*>(handle->data);
     
   if (self) {
+    if (EmitterMetrics::IsEnabled()) {
+      self->_metrics->OnWakeup();
+    }
+    
     self->DispatchEvents();
   }
 }
@@ -227,22 +276,52 @@ void EventEmitter::onEnded(uv_handle_t *handle) {
 void EventEmitter::DispatchEvents() {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  bool metrics = EmitterMetrics::IsEnabled();
+  int64_t locked = 0;
+  size_t events = 0;
+  
   uv_mutex_lock(&_lock);
+  
+  if (metrics) {
+    locked = rtc::TimeNanos();
+  }
 
   while (!_events.empty()) {
     rtc::scoped_refptr<Event> event = _events.front();
     _events.pop();
     
+    if (metrics) {
+      locked = rtc::TimeNanos() - locked;
+    }
+    
     uv_mutex_unlock(&_lock);
+    
+    if (metrics) {
+      _metrics->OnDispatch(event.get() ? event->_queued : 0, locked);
+    }
 
     if (event.get()) {
+      EventEmitter::Trace("dispatch", event->_event);
       On(event);
     }
     
+    events++;
     uv_mutex_lock(&_lock);
+    
+    if (metrics) {
+      locked = rtc::TimeNanos();
+    }
+  }
+  
+  if (metrics) {
+    locked = rtc::TimeNanos() - locked;
   }
   
   uv_mutex_unlock(&_lock);
+  
+  if (metrics) {
+    _metrics->OnPass(events, locked);
+  }
 }
 
 NotifyEmitter::NotifyEmitter(EventEmitter *listener) : EventEmitter(0, true) {
@@ -27,6 +27,8 @@
 #define WEBRTC_EVENTEMITTER_H
 
 #include "Common.h"
+#include "EmitterMetrics.h"
+#include "BackTrace.h"
 
 namespace WebRTC { 
   template<class T> class EventWrapper;
@@ -66,7 +68,8 @@ namespace WebRTC {
    private: 
     explicit Event(int event = 0) :
       _event(event),
-      _wrap(false)
+      _wrap(false),
+      _queued(0)
     {
       LOG(LS_INFO) << __PRETTY_FUNCTION__;
     }
@@ -78,6 +81,7 @@ namespace WebRTC {
    protected:
     int _event;
     bool _wrap;
+    int64_t _queued;
   };
   
   template<class T> class EventWrapper : public Event {
@@ -122,6 +126,15 @@ namespace WebRTC {
     
     virtual void On(Event *event) = 0;
     
+    // Groups this emitter's metrics with every other emitter of the same
+    // name, expected to be a string literal.
+    void SetEmitterName(const char *name);
+    
+    // Flight recorder entry for this emitter, see BackTrace::Record().
+    inline void Trace(const char *event, int64_t value = 0) const {
+      BACKTRACE_RECORD(event, _name, this, value);
+    }
+    
    private:
     static void onAsync(uv_async_t *handle, int status);
     static void onEnded(uv_handle_t *handle);
@@ -137,6 +150,8 @@ namespace WebRTC {
     uv_mutex_t _lock;
     uv_mutex_t _list;
     uv_async_t* _async;
+    const char *_name;
+    EmitterMetrics *_metrics;
     std::queue<rtc::scoped_refptr<Event> > _events;
     std::vector<EventEmitter*> _listeners;
     std::vector<EventEmitter*> _parents;
@@ -0,0 +1,717 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#if !defined(WEBRTC_WIN)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "webrtc/base/timeutils.h"
+
+#include "Platform.h"
+#include "FileSource.h"
+
+using namespace WebRTC;
+
+static const char kFilePrefix[] = "file:";
+static const int64_t kResyncNanos = 100 * rtc::kNumNanosecsPerMillisec;
+static const int kRemoveWaitMs = 10;
+
+typedef std::map<webrtc::MediaStreamTrackInterface*, FileAudioSource*> FileAudioSources;
+
+// Live file audio tracks. The track holds its source, an entry goes away
+// when the track ends or its source is destroyed.
+static rtc::CriticalSection audio_lock;
+static FileAudioSources audio_sources;
+
+static uint16_t ReadLE16(const uint8_t *data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+static uint32_t ReadLE32(const uint8_t *data) {
+  return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+MappedFile::MappedFile() : _data(0), _size(0), _mapped(false) { }
+
+MappedFile::~MappedFile() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+#if defined(WEBRTC_WIN)
+  delete [] _data;
+#else
+  if (_mapped && _data) {
+    munmap(_data, _size);
+  }
+#endif
+}
+
+MappedFile *MappedFile::Open(const std::string &path) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MappedFile *file = 0;
+  
+#if defined(WEBRTC_WIN)
+  FILE *fd = fopen(path.c_str(), "rb");
+  
+  if (!fd) {
+    return 0;
+  }
+  
+  if (!fseek(fd, 0, SEEK_END)) {
+    long size = ftell(fd);
+    
+    if (size > 0 && !fseek(fd, 0, SEEK_SET)) {
+      file = new MappedFile();
+      file->_data = new uint8_t[size];
+      file->_size = static_cast<size_t>(size);
+      
+      if (fread(file->_data, 1, file->_size, fd) != file->_size) {
+        delete file;
+        file = 0;
+      }
+    }
+  }
+  
+  fclose(fd);
+#else
+  struct stat info;
+  int fd = open(path.c_str(), O_RDONLY);
+  
+  if (fd < 0) {
+    return 0;
+  }
+  
+  if (!fstat(fd, &info) && info.st_size > 0) {
+    void *data = mmap(0, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    
+    if (data != MAP_FAILED) {
+      madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+      
+      file = new MappedFile();
+      file->_data = static_cast<uint8_t*>(data);
+      file->_size = static_cast<size_t>(info.st_size);
+      file->_mapped = true;
+    }
+  }
+  
+  close(fd);
+#endif
+  
+  if (!file) {
+    LOG(LS_ERROR) << "Unable to open " << path;
+  }
+  
+  return file;
+}
+
+const uint8_t *MappedFile::Data() const {
+  return _data;
+}
+
+size_t MappedFile::Size() const {
+  return _size;
+}
+
+FileTimer::FileTimer() :
+  _finished(false, false),
+  _current(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _thread.SetName("FileTimer", this);
+  _thread.Start();
+}
+
+FileTimer::~FileTimer() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _thread.Clear(this);
+  _thread.Stop();
+}
+
+FileTimer *FileTimer::Instance() {
+  static FileTimer *timer = new FileTimer();
+  return timer;
+}
+
+void FileTimer::Add(FileTimerTask *task) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  int64_t now = rtc::TimeNanos();
+  
+  if (std::find(_tasks.begin(), _tasks.end(), task) == _tasks.end()) {
+    task->_due = now;
+    _tasks.push_back(task);
+  }
+  
+  FileTimer::Schedule(now);
+}
+
+void FileTimer::Remove(FileTimerTask *task) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  // Tasks are called without the lock held, so wait for a running call
+  // to return before the task can be destroyed.
+  for (;;) {
+    {
+      rtc::CritScope lock(&_lock);
+      std::vector<FileTimerTask*>::iterator index = std::find(_tasks.begin(), _tasks.end(), task);
+      
+      if (index != _tasks.end()) {
+        _tasks.erase(index);
+      }
+      
+      if (_current != task || _thread.IsCurrent()) {
+        return;
+      }
+    }
+    
+    _finished.Wait(kRemoveWaitMs);
+  }
+}
+
+void FileTimer::OnMessage(rtc::Message *msg) {
+  int64_t now = rtc::TimeNanos();
+  std::vector<FileTimerTask*> due;
+  std::vector<FileTimerTask*>::iterator index;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    for (index = _tasks.begin(); index != _tasks.end(); index++) {
+      if ((*index)->_due <= now) {
+        due.push_back(*index);
+      }
+    }
+  }
+  
+  for (index = due.begin(); index != due.end(); index++) {
+    FileTimerTask *task = *index;
+    
+    {
+      rtc::CritScope lock(&_lock);
+      
+      if (std::find(_tasks.begin(), _tasks.end(), task) == _tasks.end()) {
+        continue;
+      }
+      
+      _current = task;
+    }
+    
+    int64_t next = task->OnTimer(now);
+    
+    {
+      rtc::CritScope lock(&_lock);
+      
+      if (std::find(_tasks.begin(), _tasks.end(), task) != _tasks.end()) {
+        task->_due = (now - next > kResyncNanos) ? now : next;
+      }
+      
+      _current = 0;
+    }
+    
+    _finished.Set();
+  }
+  
+  rtc::CritScope lock(&_lock);
+  FileTimer::Schedule(now);
+}
+
+void FileTimer::Schedule(int64_t now) {
+  if (_tasks.empty()) {
+    return;
+  }
+  
+  int64_t due = _tasks.front()->_due;
+  std::vector<FileTimerTask*>::iterator index;
+  
+  for (index = _tasks.begin(); index != _tasks.end(); index++) {
+    due = std::min(due, (*index)->_due);
+  }
+  
+  int64_t delay = (std::max<int64_t>(due - now, 0) + rtc::kNumNanosecsPerMillisec - 1) / rtc::kNumNanosecsPerMillisec;
+  
+  // One pending wakeup serves every registered source.
+  _thread.Clear(this);
+  _thread.PostDelayed(static_cast<int>(delay), this);
+}
+
+Y4MCapturer::Y4MCapturer(MappedFile *file, int width, int height, int fps_num, int fps_den, const std::vector<size_t> &frames) :
+  FrameCapturer(width, height, (fps_num + fps_den / 2) / fps_den),
+  _file(file),
+  _width(width),
+  _height(height),
+  _interval(rtc::kNumNanosecsPerSec * fps_den / fps_num),
+  _position(0),
+  _frames(frames)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  size_t chroma = static_cast<size_t>((width + 1) / 2) * static_cast<size_t>((height + 1) / 2);
+  _frameSize = static_cast<size_t>(width) * height + chroma * 2;
+}
+
+Y4MCapturer::~Y4MCapturer() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  FileTimer::Instance()->Remove(this);
+  delete _file;
+}
+
+Y4MCapturer *Y4MCapturer::Open(const std::string &path) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MappedFile *file = MappedFile::Open(path);
+  
+  if (!file) {
+    return 0;
+  }
+  
+  const char *data = reinterpret_cast<const char*>(file->Data());
+  size_t size = file->Size();
+  const char *end = static_cast<const char*>(memchr(data, '\n', size));
+  int width = 0;
+  int height = 0;
+  int fps_num = 30;
+  int fps_den = 1;
+  bool supported = true;
+  
+  if (!end || size < 10 || memcmp(data, "YUV4MPEG2 ", 10)) {
+    LOG(LS_ERROR) << "Invalid Y4M header in " << path;
+    
+    delete file;
+    return 0;
+  }
+  
+  std::string header(data + 10, end);
+  std::vector<std::string> tokens;
+  
+  rtc::split(header, ' ', &tokens);
+  
+  for (size_t index = 0; index < tokens.size(); index++) {
+    const std::string &token = tokens[index];
+    
+    if (token.empty()) {
+      continue;
+    }
+    
+    switch (token[0]) {
+      case 'W':
+        width = atoi(token.c_str() + 1);
+        break;
+      case 'H':
+        height = atoi(token.c_str() + 1);
+        break;
+      case 'F':
+        if (sscanf(token.c_str() + 1, "%d:%d", &fps_num, &fps_den) != 2) {
+          supported = false;
+        }
+        
+        break;
+      case 'C':
+        // 8-bit 4:2:0 only, the variants differ in chroma siting alone.
+        supported = supported && (token == "C420" || token == "C420jpeg" || token == "C420paldv" || token == "C420mpeg2");
+        break;
+    }
+  }
+  
+  if (!supported || width <= 0 || height <= 0 || fps_num <= 0 || fps_den <= 0) {
+    LOG(LS_ERROR) << "Unsupported Y4M format in " << path;
+    
+    delete file;
+    return 0;
+  }
+  
+  size_t chroma = static_cast<size_t>((width + 1) / 2) * static_cast<size_t>((height + 1) / 2);
+  size_t frame_size = static_cast<size_t>(width) * height + chroma * 2;
+  size_t offset = (end - data) + 1;
+  std::vector<size_t> frames;
+  
+  while (offset + 5 < size && !memcmp(data + offset, "FRAME", 5)) {
+    end = static_cast<const char*>(memchr(data + offset, '\n', size - offset));
+    
+    if (!end) {
+      break;
+    }
+    
+    offset = (end - data) + 1;
+    
+    if (offset + frame_size > size) {
+      break;
+    }
+    
+    frames.push_back(offset);
+    offset += frame_size;
+  }
+  
+  if (frames.empty()) {
+    LOG(LS_ERROR) << "No frames in " << path;
+    
+    delete file;
+    return 0;
+  }
+  
+  return new Y4MCapturer(file, width, height, fps_num, fps_den, frames);
+}
+
+cricket::CaptureState Y4MCapturer::Start(const cricket::VideoFormat &format) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  cricket::CaptureState state = FrameCapturer::Start(format);
+  FileTimer::Instance()->Add(this);
+  return state;
+}
+
+void Y4MCapturer::Stop() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  FileTimer::Instance()->Remove(this);
+  FrameCapturer::Stop();
+}
+
+int64_t Y4MCapturer::OnTimer(int64_t now) {
+  FrameCapturer::PushFrame(_file->Data() + _frames[_position], _frameSize, _width, _height, cricket::FOURCC_I420);
+  _position = (_position + 1) % _frames.size();
+  
+  return _due + _interval;
+}
+
+WavReader::WavReader(MappedFile *file, const int16_t *samples, size_t frames, int sample_rate, size_t channels) :
+  _file(file),
+  _samples(samples),
+  _frames(frames),
+  _channels(channels),
+  _step(static_cast<double>(sample_rate) / AudioDevice::kSampleRate),
+  _position(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+WavReader::~WavReader() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  delete _file;
+}
+
+WavReader *WavReader::Open(const std::string &path) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MappedFile *file = MappedFile::Open(path);
+  
+  if (!file) {
+    return 0;
+  }
+  
+  const uint8_t *data = file->Data();
+  size_t size = file->Size();
+  size_t offset = 12;
+  uint16_t format = 0;
+  uint16_t channels = 0;
+  uint32_t sample_rate = 0;
+  uint16_t bits = 0;
+  const int16_t *samples = 0;
+  size_t length = 0;
+  
+  if (size < 12 || memcmp(data, "RIFF", 4) || memcmp(data + 8, "WAVE", 4)) {
+    LOG(LS_ERROR) << "Invalid WAV header in " << path;
+    
+    delete file;
+    return 0;
+  }
+  
+  while (offset + 8 <= size) {
+    const uint8_t *chunk = data + offset;
+    size_t chunk_size = std::min<size_t>(ReadLE32(chunk + 4), size - offset - 8);
+    
+    if (!memcmp(chunk, "fmt ", 4) && chunk_size >= 16) {
+      format = ReadLE16(chunk + 8);
+      channels = ReadLE16(chunk + 10);
+      sample_rate = ReadLE32(chunk + 12);
+      bits = ReadLE16(chunk + 22);
+    } else if (!memcmp(chunk, "data", 4)) {
+      samples = reinterpret_cast<const int16_t*>(chunk + 8);
+      length = chunk_size;
+      break;
+    }
+    
+    offset += 8 + chunk_size + (chunk_size & 1);
+  }
+  
+  // Only 16-bit PCM (plain or WAVE_FORMAT_EXTENSIBLE) is supported.
+  if ((format != 1 && format != 0xFFFE) || bits != 16 || !channels || !sample_rate || !samples || length < channels * sizeof(int16_t)) {
+    LOG(LS_ERROR) << "Unsupported WAV format in " << path;
+    
+    delete file;
+    return 0;
+  }
+  
+  return new WavReader(file, samples, length / (channels * sizeof(int16_t)), sample_rate, channels);
+}
+
+void WavReader::Read(int16_t *data, size_t samples) {
+  for (size_t index = 0; index < samples; index++) {
+    size_t left = static_cast<size_t>(_position);
+    size_t right = (left + 1 < _frames) ? left + 1 : 0;
+    double fraction = _position - left;
+    int32_t a = 0;
+    int32_t b = 0;
+    
+    for (size_t channel = 0; channel < _channels; channel++) {
+      a += _samples[left * _channels + channel];
+      b += _samples[right * _channels + channel];
+    }
+    
+    data[index] = static_cast<int16_t>((a + (b - a) * fraction) / static_cast<int32_t>(_channels));
+    
+    _position += _step;
+    
+    if (_position >= _frames) {
+      _position -= _frames;
+    }
+  }
+}
+
+FileAudioSource::FileAudioSource(WavReader *reader,
+                                 const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory,
+                                 rtc::Thread *signaling,
+                                 rtc::Thread *worker) :
+  _reader(reader),
+  _track(0),
+  _factory(factory),
+  _signal(signaling),
+  _worker(worker)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  memset(_frame, 0, sizeof(_frame));
+}
+
+FileAudioSource::~FileAudioSource() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  FileTimer::Instance()->Remove(this);
+  
+  {
+    rtc::CritScope lock(&audio_lock);
+    FileAudioSources::iterator index;
+    
+    for (index = audio_sources.begin(); index != audio_sources.end(); index++) {
+      if (index->second == this) {
+        audio_sources.erase(index);
+        break;
+      }
+    }
+  }
+  
+  delete _reader;
+}
+
+void FileAudioSource::Attach(webrtc::AudioTrackInterface *track) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  // The track holds this source, so it is never dereferenced once gone.
+  _track = track;
+  _track->RegisterObserver(this);
+}
+
+webrtc::MediaSourceInterface::SourceState FileAudioSource::state() const {
+  return kLive;
+}
+
+bool FileAudioSource::remote() const {
+  return false;
+}
+
+void FileAudioSource::AddSink(webrtc::AudioTrackSinkInterface *sink) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  bool start = false;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    if (!_reader || std::find(_sinks.begin(), _sinks.end(), sink) != _sinks.end()) {
+      return;
+    }
+    
+    start = _sinks.empty();
+    _sinks.push_back(sink);
+  }
+  
+  // Outside the lock, the timer may be waiting for it in OnTimer().
+  if (start) {
+    FileTimer::Instance()->Add(this);
+  }
+}
+
+void FileAudioSource::RemoveSink(webrtc::AudioTrackSinkInterface *sink) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  std::vector<webrtc::AudioTrackSinkInterface*>::iterator index = std::find(_sinks.begin(), _sinks.end(), sink);
+  
+  // Sinks are only called under the lock, so the caller may destroy the
+  // sink as soon as this returns. An idle source stays on the timer and
+  // skips its turns.
+  if (index != _sinks.end()) {
+    _sinks.erase(index);
+  }
+}
+
+void FileAudioSource::OnChanged() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (_track->state() != webrtc::MediaStreamTrackInterface::kEnded) {
+    return;
+  }
+  
+  {
+    rtc::CritScope lock(&audio_lock);
+    audio_sources.erase(_track);
+  }
+  
+  FileTimer::Instance()->Remove(this);
+  
+  // Stopping the track releases the file.
+  rtc::CritScope lock(&_lock);
+  
+  delete _reader;
+  _reader = 0;
+  _sinks.clear();
+}
+
+int64_t FileAudioSource::OnTimer(int64_t now) {
+  rtc::CritScope lock(&_lock);
+  
+  if (_reader && !_sinks.empty()) {
+    _reader->Read(_frame, AudioDevice::kFrameSamples * AudioDevice::kChannels);
+    
+    std::vector<webrtc::AudioTrackSinkInterface*>::iterator index;
+    
+    for (index = _sinks.begin(); index != _sinks.end(); index++) {
+      (*index)->OnData(_frame, 16, AudioDevice::kSampleRate, AudioDevice::kChannels, AudioDevice::kFrameSamples);
+    }
+  }
+  
+  return _due + AudioDevice::kFrameMs * rtc::kNumNanosecsPerMillisec;
+}
+
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> FileAudioSource::Factory(rtc::Thread **signaling, rtc::Thread **worker) const {
+  if (signaling) {
+    *signaling = _signal;
+  }
+  
+  if (worker) {
+    *worker = _worker;
+  }
+  
+  return _factory;
+}
+
+bool FileSource::IsFile(const std::string &id) {
+  return !id.compare(0, sizeof(kFilePrefix) - 1, kFilePrefix);
+}
+
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> FileSource::GetFactory(const rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> &track,
+                                                                                 rtc::Thread **signaling,
+                                                                                 rtc::Thread **worker)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&audio_lock);
+  FileAudioSources::iterator index = audio_sources.find(track.get());
+  
+  if (!track.get() || index == audio_sources.end()) {
+    return 0;
+  }
+  
+  return index->second->Factory(signaling, worker);
+}
+
+rtc::scoped_refptr<webrtc::AudioTrackInterface> FileSource::GetAudioSource(const std::string &id, const rtc::scoped_refptr<MediaConstraints> &constraints) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<webrtc::AudioTrackInterface> track;
+  WavReader *reader = WavReader::Open(id.substr(sizeof(kFilePrefix) - 1));
+  
+  if (!reader) {
+    return track;
+  }
+  
+  // Every file track is paced by the shared FileTimer. The shard factory is
+  // only needed by the senders, its device accepts recording without sound
+  // hardware and leaves the voice channels to the track sinks.
+  rtc::Thread *signaling = 0;
+  rtc::Thread *worker = 0;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::GetHeadlessFactory(&signaling, &worker);
+  
+  if (!factory.get()) {
+    delete reader;
+    return track;
+  }
+  
+  rtc::scoped_refptr<FileAudioSource> source = new rtc::RefCountedObject<FileAudioSource>(reader, factory, signaling, worker);
+  track = factory->CreateAudioTrack("file", source);
+  
+  if (track.get()) {
+    source->Attach(track.get());
+    
+    rtc::CritScope lock(&audio_lock);
+    audio_sources[track.get()] = source.get();
+  }
+  
+  return track;
+}
+
+rtc::scoped_refptr<webrtc::VideoTrackInterface> FileSource::GetVideoSource(const std::string &id, const rtc::scoped_refptr<MediaConstraints> &constraints) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<webrtc::VideoTrackInterface> track;
+  Y4MCapturer *capturer = Y4MCapturer::Open(id.substr(sizeof(kFilePrefix) - 1));
+  
+  if (!capturer) {
+    return track;
+  }
+  
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::CreateFactory();
+  
+  if (factory.get()) {
+    track = factory->CreateVideoTrack("file", factory->CreateVideoSource(capturer, constraints->ToConstraints()));
+  } else {
+    delete capturer;
+  }
+  
+  return track;
+}
@@ -0,0 +1,194 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_FILESOURCE_H
+#define WEBRTC_FILESOURCE_H
+
+#include <map>
+#include <vector>
+
+#include "Common.h"
+#include "AudioDevice.h"
+#include "VideoSource.h"
+#include "MediaConstraints.h"
+
+#include "webrtc/api/notifier.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/messagehandler.h"
+
+namespace WebRTC {
+  class MappedFile {
+   public:
+    static MappedFile *Open(const std::string &path);
+    ~MappedFile();
+    
+    const uint8_t *Data() const;
+    size_t Size() const;
+    
+   private:
+    MappedFile();
+    
+   protected:
+    uint8_t *_data;
+    size_t _size;
+    bool _mapped;
+  };
+  
+  class FileTimerTask {
+   public:
+    virtual ~FileTimerTask() {}
+    
+    // Called on the timer thread when due, returns the next due time in nanoseconds.
+    virtual int64_t OnTimer(int64_t now) = 0;
+    
+   protected:
+    friend class FileTimer;
+    int64_t _due;
+  };
+  
+  class FileTimer : public rtc::MessageHandler {
+   public:
+    static FileTimer *Instance();
+    
+    void Add(FileTimerTask *task);
+    void Remove(FileTimerTask *task);
+    
+    void OnMessage(rtc::Message *msg) final;
+    
+   private:
+    FileTimer();
+    ~FileTimer() override;
+    
+    void Schedule(int64_t now);
+    
+   protected:
+    rtc::CriticalSection _lock;
+    rtc::Event _finished;
+    rtc::Thread _thread;
+    FileTimerTask *_current;
+    std::vector<FileTimerTask*> _tasks;
+  };
+  
+  class Y4MCapturer : public FrameCapturer, public FileTimerTask {
+   public:
+    static Y4MCapturer *Open(const std::string &path);
+    ~Y4MCapturer() override;
+    
+    cricket::CaptureState Start(const cricket::VideoFormat &format) override;
+    void Stop() override;
+    
+    int64_t OnTimer(int64_t now) final;
+    
+   private:
+    Y4MCapturer(MappedFile *file, int width, int height, int fps_num, int fps_den, const std::vector<size_t> &frames);
+    
+   protected:
+    MappedFile *_file;
+    int _width;
+    int _height;
+    int64_t _interval;
+    size_t _frameSize;
+    size_t _position;
+    std::vector<size_t> _frames;
+  };
+  
+  class WavReader {
+   public:
+    static WavReader *Open(const std::string &path);
+    ~WavReader();
+    
+    // Fills samples with mono audio at AudioDevice::kSampleRate, looping.
+    void Read(int16_t *data, size_t samples);
+    
+   private:
+    WavReader(MappedFile *file, const int16_t *samples, size_t frames, int sample_rate, size_t channels);
+    
+   protected:
+    MappedFile *_file;
+    const int16_t *_samples;
+    size_t _frames;
+    size_t _channels;
+    double _step;
+    double _position;
+  };
+  
+  // Audio source of a file track. The shared FileTimer hands every 10ms
+  // frame straight to the sinks of the track, which feed the voice channels
+  // of the senders, so no audio device or thread is needed per file.
+  class FileAudioSource : public webrtc::Notifier<webrtc::AudioSourceInterface>,
+                          public webrtc::ObserverInterface,
+                          public FileTimerTask
+  {
+   public:
+    FileAudioSource(WavReader *reader,
+                    const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory,
+                    rtc::Thread *signaling,
+                    rtc::Thread *worker);
+    
+    void Attach(webrtc::AudioTrackInterface *track);
+    
+    SourceState state() const final;
+    bool remote() const final;
+    
+    void AddSink(webrtc::AudioTrackSinkInterface *sink) final;
+    void RemoveSink(webrtc::AudioTrackSinkInterface *sink) final;
+    
+    void OnChanged() final;
+    int64_t OnTimer(int64_t now) final;
+    
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> Factory(rtc::Thread **signaling, rtc::Thread **worker) const;
+    
+   protected:
+    ~FileAudioSource() override;
+    
+    rtc::CriticalSection _lock;
+    WavReader *_reader;
+    webrtc::AudioTrackInterface *_track;
+    std::vector<webrtc::AudioTrackSinkInterface*> _sinks;
+    int16_t _frame[AudioDevice::kFrameSamples * AudioDevice::kChannels];
+    
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> _factory;
+    rtc::Thread *_signal;
+    rtc::Thread *_worker;
+  };
+  
+  class FileSource {
+   public:
+    static bool IsFile(const std::string &id);
+    
+    // Factory on the shard of the file behind track, its peers record from a
+    // virtual device that adds nothing to the file audio. Null for other
+    // tracks or once the track has ended.
+    static rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> GetFactory(const rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> &track,
+                                                                                rtc::Thread **signaling = 0,
+                                                                                rtc::Thread **worker = 0);
+    
+    static rtc::scoped_refptr<webrtc::AudioTrackInterface> GetAudioSource(const std::string &id, const rtc::scoped_refptr<MediaConstraints> &constraints);
+    static rtc::scoped_refptr<webrtc::VideoTrackInterface> GetVideoSource(const std::string &id, const rtc::scoped_refptr<MediaConstraints> &constraints);
+  };
+};
+
+#endif
@@ -23,10 +23,13 @@
 *
 */
 
-#include <ctype.h>
 #include "Platform.h"
 #include "MediaStreamTrack.h"
 #include "GetSources.h"
+#include "FileSource.h"
+#include "DeviceCache.h"
+#include "SharedSource.h"
+#include "MediaRequest.h"
 using namespace v8;
 using namespace WebRTC;
 
@@ -41,7 +44,7 @@ rtc::scoped_refptr<webrtc::AudioTrackInterface> GetSources::GetAudioSource(const
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
 
   rtc::scoped_refptr<webrtc::AudioTrackInterface> track;  
-  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = webrtc::CreatePeerConnectionFactory(rtc::Thread::Current(), Platform::GetWorker(), 0, 0, 0);
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::CreateFactory();
   
   if (factory.get()) {
     track = factory->CreateAudioTrack("audio", factory->CreateAudioSource(constraints->ToConstraints()));
@@ -52,41 +55,27 @@ rtc::scoped_refptr<webrtc::AudioTrackInterface> GetSources::GetAudioSource(const
 
 rtc::scoped_refptr<webrtc::AudioTrackInterface> GetSources::GetAudioSource(const std::string id, const rtc::scoped_refptr<MediaConstraints> &constraints) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (FileSource::IsFile(id)) {
+    return FileSource::GetAudioSource(id, constraints);
+  }
+  
   return GetSources::GetAudioSource(constraints);
 }
 
 rtc::scoped_refptr<webrtc::VideoTrackInterface> GetSources::GetVideoSource(const rtc::scoped_refptr<MediaConstraints> &constraints) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
-  cricket::VideoCapturer* capturer = nullptr;
   rtc::scoped_refptr<webrtc::VideoTrackInterface> track;
-  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = webrtc::CreatePeerConnectionFactory(rtc::Thread::Current(), Platform::GetWorker(), 0, 0, 0);
-  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> video_info(webrtc::VideoCaptureFactory::CreateDeviceInfo(0));
-  cricket::WebRtcVideoDeviceCapturerFactory device_factory;
-
+  rtc::Thread *worker = 0;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::CreateFactory(0, &worker);
+  std::vector<SourceInfo> devices;
+  
   if (factory.get()) {
-    if (video_info) {
-      int num_devices = video_info->NumberOfDevices();
-      
-      for (int i = 0; i < num_devices; ++i) {
-        const uint32_t kSize = 256;
-        char name[kSize] = {0};
-        char id[kSize] = {0};
-        
-        if (video_info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
-          capturer = device_factory.Create(cricket::Device(name, 0));
-          
-          if (capturer) {
-            
-            for(int i = 0; name[i]; i++){
-              if (name[i]==' ') name[i] = '_';
-              name[i] = tolower(name[i]);
-            }
-            track = factory->CreateVideoTrack(name, factory->CreateVideoSource(capturer, constraints->ToConstraints()));
-            return track;
-          }
-        }
-      }
+    DeviceCache::GetDevices(&devices);
+    
+    for (size_t index = 0; index < devices.size() && !track.get(); index++) {
+      track = SharedSource::CreateTrack(factory, worker, devices[index], constraints);
     }
   }
   
@@ -96,73 +85,63 @@ rtc::scoped_refptr<webrtc::VideoTrackInterface> GetSources::GetVideoSource(const
 rtc::scoped_refptr<webrtc::VideoTrackInterface> GetSources::GetVideoSource(const std::string id_name, const rtc::scoped_refptr<MediaConstraints> &constraints) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
-  cricket::VideoCapturer* capturer = nullptr;
+  if (FileSource::IsFile(id_name)) {
+    return FileSource::GetVideoSource(id_name, constraints);
+  }
+  
+  if (id_name.empty()) {
+    return GetSources::GetVideoSource(constraints);
+  }
+  
   rtc::scoped_refptr<webrtc::VideoTrackInterface> track;
-  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = webrtc::CreatePeerConnectionFactory(rtc::Thread::Current(), Platform::GetWorker(), 0, 0, 0);
-  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> video_info(webrtc::VideoCaptureFactory::CreateDeviceInfo(0));
-  cricket::WebRtcVideoDeviceCapturerFactory device_factory;
-
-  if (factory.get()) {
-    if (video_info) {
-      int num_devices = video_info->NumberOfDevices();
-      
-      for (int i = 0; i < num_devices; ++i) {
-        const uint32_t kSize = 256;
-        char name[kSize] = {0};
-        char id[kSize] = {0};
-        
-        if (video_info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
-          if (id_name.empty() || id_name.compare(name) == 0) {
-            capturer = device_factory.Create(cricket::Device(name, 0));
-            
-            if (capturer) {
-              for(int i = 0; name[i]; i++){
-                if (name[i]==' ') name[i] = '_';
-                name[i] = tolower(name[i]);
-              }
-              track = factory->CreateVideoTrack(name, factory->CreateVideoSource(capturer, constraints->ToConstraints()));
-              return track;
-            }
-          }
-        }
-      }
-    }
+  rtc::Thread *worker = 0;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::CreateFactory(0, &worker);
+  SourceInfo device;
+  
+  if (factory.get() && DeviceCache::Find(id_name, &device)) {
+    track = SharedSource::CreateTrack(factory, worker, device, constraints);
   }
 
   return track;
 }
 
-Local<Value> GetSources::GetDevices() {
+void GetSources::GetDeviceList(std::vector<SourceInfo> *list) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
-  Nan::EscapableHandleScope scope;
-  Local<Array> list = Nan::New<Array>();
-  uint32_t index = 0;
+  DeviceCache::GetDevices(list);
+}
 
-  std::unique_ptr<webrtc::VideoCaptureModule::DeviceInfo> video_info(webrtc::VideoCaptureFactory::CreateDeviceInfo(0));
+Local<Value> GetSources::GetDevices(const std::vector<SourceInfo> &list) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::EscapableHandleScope scope;
+  Local<Array> retval = Nan::New<Array>();
+  
+  for (size_t index = 0; index < list.size(); index++) {
+    Local<Object> device = Nan::New<Object>();
 
-  if (video_info) {
-    int num_devices = video_info->NumberOfDevices();
+    device->Set(Nan::New("kind").ToLocalChecked(), Nan::New(list[index].kind.c_str()).ToLocalChecked());
+    device->Set(Nan::New("label").ToLocalChecked(), Nan::New(list[index].label.c_str()).ToLocalChecked());
+    device->Set(Nan::New("id").ToLocalChecked(), Nan::New(list[index].id.c_str()).ToLocalChecked());
     
-    for (int i = 0; i < num_devices; ++i) {
-      const uint32_t kSize = 256;
-      char name[kSize] = {0};
-      char id[kSize] = {0};
+    Local<Array> capabilities = Nan::New<Array>();
+    
+    for (size_t cap = 0; cap < list[index].capabilities.size(); cap++) {
+      Local<Object> format = Nan::New<Object>();
       
-      if (video_info->GetDeviceName(i, name, kSize, id, kSize) != -1) {
-        Local<Object> device = Nan::New<Object>();
-
-        device->Set(Nan::New("kind").ToLocalChecked(), Nan::New("video").ToLocalChecked());
-        device->Set(Nan::New("label").ToLocalChecked(), Nan::New(name).ToLocalChecked());
-        device->Set(Nan::New("id").ToLocalChecked(), Nan::New(id).ToLocalChecked());
-
-        list->Set(index, device);
-        index++;
-      }
+      format->Set(Nan::New("width").ToLocalChecked(), Nan::New(list[index].capabilities[cap].width));
+      format->Set(Nan::New("height").ToLocalChecked(), Nan::New(list[index].capabilities[cap].height));
+      format->Set(Nan::New("frameRate").ToLocalChecked(), Nan::New(list[index].capabilities[cap].frameRate));
+      
+      capabilities->Set(cap, format);
     }
+    
+    device->Set(Nan::New("capabilities").ToLocalChecked(), capabilities);
+
+    retval->Set(index, device);
   }
 
-  return scope.Escape(list);
+  return scope.Escape(retval);
 }
 
 
@@ -181,16 +160,8 @@ void GetSources::GetVideoSource2(const Nan::FunctionCallbackInfo<Value> &info) {
 void GetSources::GetDevices(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
-  if (info.Length() == 1 && info[0]->IsFunction()) {
-    Local<Function> callback = Local<Function>::Cast(info[0]);
-
-    Local<Value> argv[1] = { 
-      GetSources::GetDevices()
-    };
-
-    if (!callback.IsEmpty()) {
-      callback->Call(info.This(), 1, argv);
-    }
+  if (info.Length() >= 1 && info[0]->IsFunction()) {
+    MediaRequest::Queue(new MediaRequest(MediaRequest::kGetSources, 0, info.This(), Local<Function>::Cast(info[0]), info[1]));
   }
   
   info.GetReturnValue().SetUndefined();
@@ -30,6 +30,19 @@
 #include "MediaConstraints.h"
 
 namespace WebRTC {
+  struct SourceCapability {
+    int width;
+    int height;
+    int frameRate;
+  };
+  
+  struct SourceInfo {
+    std::string kind;
+    std::string label;
+    std::string id;
+    std::vector<SourceCapability> capabilities;
+  };
+  
   class GetSources {
    public:
     static void Init(v8::Handle<v8::Object> exports);
@@ -39,7 +52,8 @@ namespace WebRTC {
 
     static rtc::scoped_refptr<webrtc::VideoTrackInterface> GetVideoSource(const rtc::scoped_refptr<MediaConstraints> &constraints);
     static rtc::scoped_refptr<webrtc::VideoTrackInterface> GetVideoSource(const std::string id, const rtc::scoped_refptr<MediaConstraints> &constraints);
-    static v8::Local<v8::Value> GetDevices();
+    static void GetDeviceList(std::vector<SourceInfo> *list);
+    static v8::Local<v8::Value> GetDevices(const std::vector<SourceInfo> &list);
 
    private:
     static void GetVideoSource2(const Nan::FunctionCallbackInfo<v8::Value> &info);
@@ -28,6 +28,7 @@
 #include "GetSources.h"
 #include "MediaStream.h"
 #include "MediaConstraints.h"
+#include "MediaRequest.h"
 
 using namespace v8;
 using namespace WebRTC;
@@ -38,19 +39,19 @@ void GetUserMedia::Init(Handle<Object> exports) {
   exports->Set(Nan::New("getUserMedia").ToLocalChecked(), Nan::New<FunctionTemplate>(GetUserMedia::GetMediaStream)->GetFunction());
 }
 
-void GetUserMedia::GetMediaStream(const Nan::FunctionCallbackInfo<Value> &info) {
+rtc::scoped_refptr<webrtc::MediaStreamInterface> GetUserMedia::CreateStream(const rtc::scoped_refptr<MediaConstraints> &constraints, const char **error) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   rtc::scoped_refptr<webrtc::MediaStreamInterface> stream;
-  rtc::scoped_refptr<MediaConstraints> constraints = MediaConstraints::New(info[0]);
-  const char *error = 0;
   bool have_source = false;
 
   std::string audioId = constraints->AudioId();
   std::string videoId = constraints->VideoId();
+  
+  *error = 0;
 
   if (constraints->UseAudio() || constraints->UseVideo()) {
-    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = webrtc::CreatePeerConnectionFactory(rtc::Thread::Current(), Platform::GetWorker(), 0, 0, 0);
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::CreateFactory();
     
     if (factory.get()) {
       stream = factory->CreateLocalMediaStream("stream");
@@ -67,13 +68,13 @@ void GetUserMedia::GetMediaStream(const Nan::FunctionCallbackInfo<Value> &info)
 
           if (audio_track.get()) {
             if (!stream->AddTrack(audio_track)) {
-              error = "Invalid Audio Input";
+              *error = "Invalid Audio Input";
             } else {
               have_source = true;
             }
           } else {
             if (!audioId.empty()) {
-              error = "Invalid Audio Input";
+              *error = "Invalid Audio Input";
             }
           }
         } 
@@ -89,51 +90,41 @@ void GetUserMedia::GetMediaStream(const Nan::FunctionCallbackInfo<Value> &info)
 
           if (video_track.get()) {
             if (!stream->AddTrack(video_track)) {
-              error = "Invalid Video Input";
+              *error = "Invalid Video Input";
             } else {
               have_source = true;
             }
           } else {
             if (!videoId.empty()) {
-              error = "Invalid Video Input";
+              *error = "Invalid Video Input";
             }
           }
         }
       } else {
-        error = "Internal Error";
+        *error = "Internal Error";
       }
     }
   }
   
   if (!have_source) {
-    error = "No available inputs";
+    *error = "No available inputs";
   }
-
-  Handle<Value> argv[1];
-
-  if (!error) {   
-    if (stream.get()) {
-      argv[0] = MediaStream::New(stream);
-    } else {
-      error = "Invalid MediaStream";
-    }
+  
+  if (!*error && !stream.get()) {
+    *error = "Invalid MediaStream";
   }
+  
+  return stream;
+}
 
-  if (error) {
-    if (!info[2].IsEmpty() && info[2]->IsFunction()) {
-      Local<Function> onerror = Local<Function>::Cast(info[2]);
-      argv[0] = Nan::Error(error);
-
-      onerror->Call(info.This(), 1, argv);
-    } else {
-      Nan::ThrowError(error);
-    }
-  } else {
-    if (!info[1].IsEmpty() && info[1]->IsFunction()) {
-      Local<Function> onsuccess = Local<Function>::Cast(info[1]);
-      onsuccess->Call(info.This(), 1, argv);
-    }
-  }
+void GetUserMedia::GetMediaStream(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<MediaConstraints> constraints = MediaConstraints::New(info[0]);
+  
+  // Opening capture devices can block for hundreds of milliseconds, so the
+  // stream is created on the device worker and completed on the JS thread.
+  MediaRequest::Queue(new MediaRequest(MediaRequest::kGetUserMedia, constraints, info.This(), info[1], info[2]));
   
   info.GetReturnValue().SetUndefined();
 }
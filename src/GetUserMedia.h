@@ -27,11 +27,14 @@
 #define WEBRTC_GETUSERMEDIA_H
 
 #include "Common.h"
+#include "MediaConstraints.h"
 
 namespace WebRTC {
   class GetUserMedia {
    public:
     static void Init(v8::Handle<v8::Object> exports);
+    
+    static rtc::scoped_refptr<webrtc::MediaStreamInterface> CreateStream(const rtc::scoped_refptr<MediaConstraints> &constraints, const char **error);
 
    private:
     static void GetMediaStream(const Nan::FunctionCallbackInfo<v8::Value> &info);
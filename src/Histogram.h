@@ -0,0 +1,199 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_HISTOGRAM_H
+#define WEBRTC_HISTOGRAM_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "webrtc/base/json.h"
+
+namespace WebRTC {
+  // Log-linear histogram for non-negative integer samples (usually
+  // microseconds). Values below 64 are exact, above that every power of two is
+  // split into 32 buckets, so percentiles are within ~3% of the real value.
+  // Fixed size and allocation free; callers serialize access themselves.
+  class Histogram {
+   public:
+    enum {
+      kExact = 64,
+      kSubBuckets = 32,
+      kBuckets = kExact + 58 * kSubBuckets,
+    };
+    
+    Histogram() {
+      Histogram::Reset();
+    }
+    
+    void Reset() {
+      memset(_buckets, 0, sizeof(_buckets));
+      
+      _count = 0;
+      _sum = 0;
+      _min = 0;
+      _max = 0;
+    }
+    
+    void Record(int64_t value) {
+      if (value < 0) {
+        value = 0;
+      }
+      
+      _buckets[Histogram::Index(value)]++;
+      
+      if (!_count || value < _min) {
+        _min = value;
+      }
+      
+      if (value > _max) {
+        _max = value;
+      }
+      
+      _count++;
+      _sum += value;
+    }
+    
+    void Merge(const Histogram &other) {
+      if (!other._count) {
+        return;
+      }
+      
+      for (int index = 0; index < kBuckets; index++) {
+        _buckets[index] += other._buckets[index];
+      }
+      
+      if (!_count || other._min < _min) {
+        _min = other._min;
+      }
+      
+      if (other._max > _max) {
+        _max = other._max;
+      }
+      
+      _count += other._count;
+      _sum += other._sum;
+    }
+    
+    uint64_t Count() const {
+      return _count;
+    }
+    
+    int64_t Min() const {
+      return _min;
+    }
+    
+    int64_t Max() const {
+      return _max;
+    }
+    
+    double Mean() const {
+      return _count ? static_cast<double>(_sum) / _count : 0;
+    }
+    
+    // Upper bound of the bucket holding the given percentile (0 - 100).
+    int64_t Percentile(double percentile) const {
+      if (!_count) {
+        return 0;
+      }
+      
+      uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * _count + 0.5);
+      uint64_t seen = 0;
+      
+      if (rank < 1) {
+        rank = 1;
+      }
+      
+      for (int index = 0; index < kBuckets; index++) {
+        seen += _buckets[index];
+        
+        if (seen >= rank) {
+          int64_t value = Histogram::Upper(index);
+          return (value > _max) ? _max : value;
+        }
+      }
+      
+      return _max;
+    }
+    
+    Json::Value ToJson() const {
+      Json::Value result(Json::objectValue);
+      
+      result["count"] = Json::Value::UInt64(_count);
+      result["min"] = Json::Value::Int64(_min);
+      result["max"] = Json::Value::Int64(_max);
+      result["mean"] = Histogram::Mean();
+      result["p50"] = Json::Value::Int64(Histogram::Percentile(50));
+      result["p90"] = Json::Value::Int64(Histogram::Percentile(90));
+      result["p99"] = Json::Value::Int64(Histogram::Percentile(99));
+      result["p999"] = Json::Value::Int64(Histogram::Percentile(99.9));
+      
+      return result;
+    }
+    
+   private:
+    static int HighestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+      return 63 - __builtin_clzll(value);
+#else
+      int bit = 0;
+      
+      while (value >>= 1) {
+        bit++;
+      }
+      
+      return bit;
+#endif
+    }
+    
+    static int Index(int64_t value) {
+      if (value < kExact) {
+        return static_cast<int>(value);
+      }
+      
+      int shift = Histogram::HighestBit(static_cast<uint64_t>(value)) - 5;
+      return kExact + (shift - 1) * kSubBuckets + static_cast<int>((value >> shift) - kSubBuckets);
+    }
+    
+    static int64_t Upper(int index) {
+      if (index < kExact) {
+        return index;
+      }
+      
+      int shift = (index - kExact) / kSubBuckets + 1;
+      int64_t sub = (index - kExact) % kSubBuckets + kSubBuckets;
+      
+      return ((sub + 1) << shift) - 1;
+    }
+    
+   protected:
+    uint64_t _buckets[kBuckets];
+    uint64_t _count;
+    int64_t _sum;
+    int64_t _min;
+    int64_t _max;
+  };
+};
+
+#endif
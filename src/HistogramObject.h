@@ -0,0 +1,51 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_HISTOGRAMOBJECT_H
+#define WEBRTC_HISTOGRAMOBJECT_H
+
+#include "Common.h"
+#include "Histogram.h"
+
+namespace WebRTC {
+  // JavaScript view of a Histogram, shared by every API that reports one.
+  inline v8::Local<v8::Object> HistogramToObject(const Histogram &histogram) {
+    Nan::EscapableHandleScope scope;
+    v8::Local<v8::Object> retval = Nan::New<v8::Object>();
+    
+    retval->Set(Nan::New("count").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(histogram.Count())));
+    retval->Set(Nan::New("min").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(histogram.Min())));
+    retval->Set(Nan::New("max").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(histogram.Max())));
+    retval->Set(Nan::New("mean").ToLocalChecked(), Nan::New<v8::Number>(histogram.Mean()));
+    retval->Set(Nan::New("p50").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(histogram.Percentile(50))));
+    retval->Set(Nan::New("p90").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(histogram.Percentile(90))));
+    retval->Set(Nan::New("p99").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(histogram.Percentile(99))));
+    retval->Set(Nan::New("p999").ToLocalChecked(), Nan::New<v8::Number>(static_cast<double>(histogram.Percentile(99.9))));
+    
+    return scope.Escape(retval);
+  }
+};
+
+#endif
@@ -0,0 +1,208 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include <string.h>
+
+#include "LatencyProbe.h"
+
+#include "webrtc/base/timeutils.h"
+
+using namespace WebRTC;
+
+const char WebRTC::kLatencyProbeProtocol[] = "webrtc-native-latency";
+
+// "WNLP" | type | 3 bytes padding | sequence | rtc::TimeNanos() of the ping.
+// The responder only flips the type, so byte order never matters.
+#define kLatencyFrameSize 20
+#define kLatencyFrameType 4
+#define kLatencyFrameSequence 8
+#define kLatencyFrameTime 12
+
+enum LatencyFrameType {
+  kLatencyPing = 1,
+  kLatencyPong = 2,
+};
+
+enum LatencyProbeMessage {
+  kLatencyProbePing,
+};
+
+static const char kLatencyMagic[4] = { 'W', 'N', 'L', 'P' };
+
+static bool IsFrame(const webrtc::DataBuffer &buffer, uint8_t type) {
+  return buffer.binary &&
+         buffer.data.size() == kLatencyFrameSize &&
+         !memcmp(buffer.data.data(), kLatencyMagic, sizeof(kLatencyMagic)) &&
+         buffer.data.data()[kLatencyFrameType] == type;
+}
+
+namespace WebRTC {
+  class LatencyDispatcher : public rtc::MessageHandler {
+   public:
+    void OnMessage(rtc::Message *msg) final {
+      rtc::ScopedRefMessageData<LatencyProbe> *data = static_cast<rtc::ScopedRefMessageData<LatencyProbe>*>(msg->pdata);
+      LatencyProbe *probe = data->data().get();
+      
+      if (msg->message_id == kLatencyProbePing && rtc::AtomicOps::AcquireLoad(&probe->_running)) {
+        probe->Ping();
+        probe->Schedule(probe->_interval);
+      }
+      
+      delete data;
+    }
+  };
+};
+
+// Messages keep the probe alive, so the handler itself never goes away.
+static LatencyDispatcher dispatcher;
+
+LatencyProbe::LatencyProbe(rtc::Thread *thread, rtc::scoped_refptr<webrtc::DataChannelInterface> channel, int interval) :
+  _thread(thread),
+  _channel(channel),
+  _interval(interval),
+  _sequence(0),
+  _running(1),
+  _started(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+LatencyProbe::~LatencyProbe() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+rtc::scoped_refptr<LatencyProbe> LatencyProbe::Create(rtc::Thread *thread, rtc::scoped_refptr<webrtc::DataChannelInterface> channel, int interval) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<LatencyProbe> probe(new rtc::RefCountedObject<LatencyProbe>(thread, channel, interval));
+  
+  channel->RegisterObserver(probe.get());
+  probe->OnStateChange();
+  
+  return probe;
+}
+
+void LatencyProbe::Stop() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (rtc::AtomicOps::CompareAndSwap(&_running, 1, 0) == 1) {
+    _channel->UnregisterObserver();
+    _channel->Close();
+  }
+}
+
+void LatencyProbe::GetHistogram(Histogram *histogram, bool reset) {
+  rtc::CritScope lock(&_lock);
+  
+  *histogram = _histogram;
+  
+  if (reset) {
+    _histogram.Reset();
+  }
+}
+
+void LatencyProbe::Schedule(int delay) {
+  _thread->PostDelayed(delay, &dispatcher, kLatencyProbePing, new rtc::ScopedRefMessageData<LatencyProbe>(this));
+}
+
+void LatencyProbe::Ping() {
+  if (_channel->state() != webrtc::DataChannelInterface::kOpen) {
+    return;
+  }
+  
+  uint8_t frame[kLatencyFrameSize] = { 0 };
+  uint32_t sequence = _sequence++;
+  int64_t now = rtc::TimeNanos();
+  
+  memcpy(frame, kLatencyMagic, sizeof(kLatencyMagic));
+  frame[kLatencyFrameType] = kLatencyPing;
+  memcpy(frame + kLatencyFrameSequence, &sequence, sizeof(sequence));
+  memcpy(frame + kLatencyFrameTime, &now, sizeof(now));
+  
+  _channel->Send(webrtc::DataBuffer(rtc::Buffer(frame, sizeof(frame)), true));
+}
+
+void LatencyProbe::OnStateChange() {
+  if (_channel->state() == webrtc::DataChannelInterface::kOpen && 
+      rtc::AtomicOps::CompareAndSwap(&_started, 0, 1) == 0)
+  {
+    LatencyProbe::Schedule(0);
+  }
+}
+
+void LatencyProbe::OnMessage(const webrtc::DataBuffer& buffer) {
+  if (!IsFrame(buffer, kLatencyPong)) {
+    return;
+  }
+  
+  int64_t sent = 0;
+  memcpy(&sent, buffer.data.data() + kLatencyFrameTime, sizeof(sent));
+  
+  rtc::CritScope lock(&_lock);
+  _histogram.Record((rtc::TimeNanos() - sent) / rtc::kNumNanosecsPerMicrosec);
+}
+
+LatencyResponder::LatencyResponder(rtc::scoped_refptr<webrtc::DataChannelInterface> channel) :
+  _channel(channel)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+LatencyResponder::~LatencyResponder() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _channel->UnregisterObserver();
+  _channel->Close();
+}
+
+bool LatencyResponder::IsProbe(webrtc::DataChannelInterface *channel) {
+  return channel && channel->protocol() == kLatencyProbeProtocol;
+}
+
+rtc::scoped_refptr<LatencyResponder> LatencyResponder::Create(rtc::scoped_refptr<webrtc::DataChannelInterface> channel) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<LatencyResponder> responder(new rtc::RefCountedObject<LatencyResponder>(channel));
+  channel->RegisterObserver(responder.get());
+  
+  return responder;
+}
+
+bool LatencyResponder::IsClosed() const {
+  return _channel->state() == webrtc::DataChannelInterface::kClosed;
+}
+
+void LatencyResponder::OnStateChange() {
+}
+
+void LatencyResponder::OnMessage(const webrtc::DataBuffer& buffer) {
+  if (!IsFrame(buffer, kLatencyPing)) {
+    return;
+  }
+  
+  rtc::Buffer frame(buffer.data.data(), buffer.data.size());
+  frame.data()[kLatencyFrameType] = kLatencyPong;
+  
+  _channel->Send(webrtc::DataBuffer(frame, true));
+}
@@ -0,0 +1,90 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_LATENCYPROBE_H
+#define WEBRTC_LATENCYPROBE_H
+
+#include "Common.h"
+#include "Histogram.h"
+
+#include "webrtc/base/criticalsection.h"
+
+namespace WebRTC {
+  // Probe frames travel on a companion data channel opened with this
+  // protocol, the remote peer answers them natively and never exposes the
+  // channel to JavaScript.
+  extern const char kLatencyProbeProtocol[];
+  
+  // Sends timestamped pings on the signaling thread and records the round
+  // trip time of every answer in microseconds.
+  class LatencyProbe : public webrtc::DataChannelObserver, public rtc::RefCountInterface {
+    friend class LatencyDispatcher;
+    
+   public:
+    static rtc::scoped_refptr<LatencyProbe> Create(rtc::Thread *thread, rtc::scoped_refptr<webrtc::DataChannelInterface> channel, int interval);
+    
+    void Stop();
+    void GetHistogram(Histogram *histogram, bool reset);
+    
+    void OnStateChange() final;
+    void OnMessage(const webrtc::DataBuffer& buffer) final;
+    
+   protected:
+    LatencyProbe(rtc::Thread *thread, rtc::scoped_refptr<webrtc::DataChannelInterface> channel, int interval);
+    ~LatencyProbe() override;
+    
+    void Schedule(int delay);
+    void Ping();
+    
+    rtc::Thread *_thread;
+    rtc::scoped_refptr<webrtc::DataChannelInterface> _channel;
+    int _interval;
+    uint32_t _sequence;
+    volatile int _running;
+    volatile int _started;
+    
+    rtc::CriticalSection _lock;
+    Histogram _histogram;
+  };
+  
+  // Remote end of a probe channel, echoes pings back as pongs.
+  class LatencyResponder : public webrtc::DataChannelObserver, public rtc::RefCountInterface {
+   public:
+    static bool IsProbe(webrtc::DataChannelInterface *channel);
+    static rtc::scoped_refptr<LatencyResponder> Create(rtc::scoped_refptr<webrtc::DataChannelInterface> channel);
+    
+    bool IsClosed() const;
+    
+    void OnStateChange() final;
+    void OnMessage(const webrtc::DataBuffer& buffer) final;
+    
+   protected:
+    explicit LatencyResponder(rtc::scoped_refptr<webrtc::DataChannelInterface> channel);
+    ~LatencyResponder() override;
+    
+    rtc::scoped_refptr<webrtc::DataChannelInterface> _channel;
+  };
+};
+
+#endif
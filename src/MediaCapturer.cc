@@ -102,6 +102,8 @@ Local<Value> MediaCapturer::New(webrtc::VideoSourceInterface *track) {
 MediaCapturer::MediaCapturer() {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  SetEmitterName("MediaCapturer");
+  
   _observer = new rtc::RefCountedObject<MediaStreamTrackObserver>(this);
 }
 
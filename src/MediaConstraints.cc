@@ -168,7 +168,7 @@ rtc::scoped_refptr<MediaConstraints> MediaConstraints::New(const Local<Object> &
     if (video_value->IsTrue() || video_value->IsFalse()) {
       self->_video = true;
     } else if (video_value->IsObject()) {
-      Local<Object> video = Local<Object>::Cast(audio_value);
+      Local<Object> video = Local<Object>::Cast(video_value);
       optional_value = video->Get(Nan::New("optional").ToLocalChecked());
 
       if (!optional_value.IsEmpty() && optional_value->IsArray()) {
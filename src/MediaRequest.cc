@@ -0,0 +1,165 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include "Platform.h"
+#include "MediaRequest.h"
+#include "MediaStream.h"
+#include "GetUserMedia.h"
+
+using namespace v8;
+using namespace WebRTC;
+
+enum MediaRequestEvent {
+  kMediaRequestDone,
+};
+
+MediaRequest::MediaRequest(MediaRequestType type,
+                           const rtc::scoped_refptr<MediaConstraints> &constraints,
+                           Local<Object> self,
+                           Local<Value> onsuccess,
+                           Local<Value> onerror) :
+  _type(type),
+  _constraints(constraints),
+  _error(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _self.Reset<Object>(self);
+  
+  if (!onsuccess.IsEmpty() && onsuccess->IsFunction()) {
+    _onsuccess.Reset<Function>(Local<Function>::Cast(onsuccess));
+  }
+  
+  if (!onerror.IsEmpty() && onerror->IsFunction()) {
+    _onerror.Reset<Function>(Local<Function>::Cast(onerror));
+  }
+}
+
+MediaRequest::~MediaRequest() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _self.Reset();
+  _onsuccess.Reset();
+  _onerror.Reset();
+}
+
+void MediaRequest::Queue(MediaRequest *request) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaDispatcher::Instance()->Queue(request);
+}
+
+void MediaRequest::OnMessage(rtc::Message *msg) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  switch (_type) {
+    case kGetUserMedia:
+      _stream = GetUserMedia::CreateStream(_constraints, &_error);
+      break;
+    case kGetSources:
+      GetSources::GetDeviceList(&_sources);
+      break;
+  }
+  
+  MediaDispatcher::Instance()->Emit<MediaRequest*>(kMediaRequestDone, this);
+}
+
+void MediaRequest::Complete() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::HandleScope scope;
+  Local<Object> self = Nan::New<Object>(_self);
+  Local<Value> argv[1];
+  
+  if (_error) {
+    if (!_onerror.IsEmpty()) {
+      Local<Function> callback = Nan::New<Function>(_onerror);
+      argv[0] = Nan::Error(_error);
+      
+      callback->Call(self, 1, argv);
+    } else {
+      // Without an error callback the request fails like the synchronous
+      // call used to, as an exception on the JS thread.
+      Nan::TryCatch tryCatch;
+      Nan::ThrowError(_error);
+      Nan::FatalException(tryCatch);
+    }
+    
+    return;
+  }
+  
+  if (!_onsuccess.IsEmpty()) {
+    Local<Function> callback = Nan::New<Function>(_onsuccess);
+    
+    if (_type == kGetUserMedia) {
+      argv[0] = MediaStream::New(_stream);
+    } else {
+      argv[0] = GetSources::GetDevices(_sources);
+    }
+    
+    callback->Call(self, 1, argv);
+  }
+}
+
+MediaDispatcher::MediaDispatcher() : _pending(0) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  SetEmitterName("MediaDispatcher");
+}
+
+MediaDispatcher::~MediaDispatcher() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+MediaDispatcher *MediaDispatcher::Instance() {
+  static MediaDispatcher *dispatcher = new MediaDispatcher();
+  return dispatcher;
+}
+
+void MediaDispatcher::Queue(MediaRequest *request) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  // Keep the event loop alive until every pending request has completed.
+  if (!_pending++) {
+    EventEmitter::SetReference(true);
+  }
+  
+  Platform::GetDeviceWorker()->Post(request);
+}
+
+void MediaDispatcher::On(Event *event) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaRequest *request = event->Unwrap<MediaRequest*>();
+  
+  if (request) {
+    request->Complete();
+    delete request;
+  }
+  
+  if (!--_pending) {
+    EventEmitter::SetReference(false);
+  }
+}
@@ -0,0 +1,85 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_MEDIAREQUEST_H
+#define WEBRTC_MEDIAREQUEST_H
+
+#include "Common.h"
+#include "EventEmitter.h"
+#include "GetSources.h"
+#include "MediaConstraints.h"
+
+#include "webrtc/base/messagehandler.h"
+
+namespace WebRTC {
+  class MediaRequest : public rtc::MessageHandler {
+   public:
+    enum MediaRequestType {
+      kGetUserMedia,
+      kGetSources,
+    };
+    
+    MediaRequest(MediaRequestType type,
+                 const rtc::scoped_refptr<MediaConstraints> &constraints,
+                 v8::Local<v8::Object> self,
+                 v8::Local<v8::Value> onsuccess,
+                 v8::Local<v8::Value> onerror);
+    
+    ~MediaRequest() override;
+    
+    static void Queue(MediaRequest *request);
+    
+    void OnMessage(rtc::Message *msg) final;
+    void Complete();
+    
+   protected:
+    MediaRequestType _type;
+    rtc::scoped_refptr<MediaConstraints> _constraints;
+    rtc::scoped_refptr<webrtc::MediaStreamInterface> _stream;
+    std::vector<SourceInfo> _sources;
+    const char *_error;
+    
+    Nan::Persistent<v8::Object> _self;
+    Nan::Persistent<v8::Function> _onsuccess;
+    Nan::Persistent<v8::Function> _onerror;
+  };
+  
+  class MediaDispatcher : public EventEmitter {
+   public:
+    static MediaDispatcher *Instance();
+    
+    void Queue(MediaRequest *request);
+    void On(Event *event) final;
+    
+   private:
+    MediaDispatcher();
+    ~MediaDispatcher() final;
+    
+   protected:
+    int _pending;
+  };
+};
+
+#endif
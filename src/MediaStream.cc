@@ -23,6 +23,7 @@
 *
 */
 
+#include "Platform.h"
 #include "MediaStream.h"
 #include "MediaStreamTrack.h"
 
@@ -91,6 +92,8 @@ MediaStream::MediaStream() :
 {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  SetEmitterName("MediaStream");
+  
   _observer = new rtc::RefCountedObject<MediaStreamObserver>(this);
 }
 
@@ -206,7 +209,7 @@ void MediaStream::Clone(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   rtc::scoped_refptr<webrtc::MediaStreamInterface> self = MediaStream::Unwrap(info.This());
-  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = webrtc::CreatePeerConnectionFactory();
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::CreateFactory();
   rtc::scoped_refptr<webrtc::MediaStreamInterface> stream;
 
   if (self.get() && factory.get()) {
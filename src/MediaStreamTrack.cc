@@ -59,6 +59,9 @@ void MediaStreamTrack::Init() {
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onunmute").ToLocalChecked(), MediaStreamTrack::GetOnUnMute, MediaStreamTrack::SetOnUnMute);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onoverconstrained").ToLocalChecked(), MediaStreamTrack::GetOnOverConstrained, MediaStreamTrack::SetOnOverConstrained);
   Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onended").ToLocalChecked(), MediaStreamTrack::GetOnEnded, MediaStreamTrack::SetOnEnded);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onlevel").ToLocalChecked(), MediaStreamTrack::GetOnLevel, MediaStreamTrack::SetOnLevel);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("onspeakingchange").ToLocalChecked(), MediaStreamTrack::GetOnSpeakingChange, MediaStreamTrack::SetOnSpeakingChange);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("levelInterval").ToLocalChecked(), MediaStreamTrack::GetLevelInterval, MediaStreamTrack::SetLevelInterval);
 
   constructor.Reset<Function>(tpl->GetFunction());
 }
@@ -79,6 +82,7 @@ Local<Value> MediaStreamTrack::New(rtc::scoped_refptr<webrtc::AudioTrackInterfac
   MediaStreamTrack *self = RTCWrap::Unwrap<MediaStreamTrack>(ret, "MediaStreamTrack");
 
   self->isAudioTrack = true;
+  self->_analyzer = new rtc::RefCountedObject<AudioAnalyzer>(self);
   self->_track = audioTrack;
   self->_source = audioTrack->GetSource();
   self->_track_state = self->_track->state();
@@ -117,9 +121,15 @@ Local<Value> MediaStreamTrack::New(rtc::scoped_refptr<webrtc::VideoTrackInterfac
   return scope.Escape(ret);
 }
 
-MediaStreamTrack::MediaStreamTrack() {
+MediaStreamTrack::MediaStreamTrack() :
+  isAudioTrack(false),
+  isVideoTrack(false),
+  _analyzing(false)
+{
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  SetEmitterName("MediaStreamTrack");
+  
   _observer = new rtc::RefCountedObject<MediaStreamTrackObserver>(this);
 }
 
@@ -134,7 +144,16 @@ MediaStreamTrack::~MediaStreamTrack() {
     _source->UnregisterObserver(_observer.get());
   }
   
+  _onlevel.Reset();
+  _onspeakingchange.Reset();
+  
+  MediaStreamTrack::CheckAnalyzer();
+  
   _observer->RemoveListener(this);
+  
+  if (_analyzer.get()) {
+    _analyzer->RemoveListener(this);
+  }
 }
 
 void MediaStreamTrack::New(const Nan::FunctionCallbackInfo<Value> &info) {
@@ -318,6 +337,32 @@ void MediaStreamTrack::GetOnEnded(Local<String> property, const Nan::PropertyCal
 }
 
 
+void MediaStreamTrack::GetOnLevel(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaStreamTrack *self = RTCWrap::Unwrap<MediaStreamTrack>(info.Holder(), "MediaStreamTrack");
+  return info.GetReturnValue().Set(Nan::New<Function>(self->_onlevel));
+}
+
+void MediaStreamTrack::GetOnSpeakingChange(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaStreamTrack *self = RTCWrap::Unwrap<MediaStreamTrack>(info.Holder(), "MediaStreamTrack");
+  return info.GetReturnValue().Set(Nan::New<Function>(self->_onspeakingchange));
+}
+
+void MediaStreamTrack::GetLevelInterval(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaStreamTrack *self = RTCWrap::Unwrap<MediaStreamTrack>(info.Holder(), "MediaStreamTrack");
+  
+  if (!self->_analyzer.get()) {
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  return info.GetReturnValue().Set(Nan::New(self->_analyzer->Interval()));
+}
+
 void MediaStreamTrack::ReadOnly(Local<String> property, Local<Value> value, const Nan::PropertyCallbackInfo<void> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
 
@@ -396,6 +441,63 @@ void MediaStreamTrack::SetOnEnded(Local<String> property, Local<Value> value, co
   }
 }
 
+void MediaStreamTrack::SetOnLevel(Local<String> property, Local<Value> value, const Nan::PropertyCallbackInfo<void> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaStreamTrack *self = RTCWrap::Unwrap<MediaStreamTrack>(info.Holder(), "MediaStreamTrack");
+
+  if (!value.IsEmpty() && value->IsFunction()) {
+    self->_onlevel.Reset<Function>(Local<Function>::Cast(value));
+  } else {
+    self->_onlevel.Reset();
+  }
+  
+  self->CheckAnalyzer();
+}
+
+void MediaStreamTrack::SetOnSpeakingChange(Local<String> property, Local<Value> value, const Nan::PropertyCallbackInfo<void> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaStreamTrack *self = RTCWrap::Unwrap<MediaStreamTrack>(info.Holder(), "MediaStreamTrack");
+
+  if (!value.IsEmpty() && value->IsFunction()) {
+    self->_onspeakingchange.Reset<Function>(Local<Function>::Cast(value));
+  } else {
+    self->_onspeakingchange.Reset();
+  }
+  
+  self->CheckAnalyzer();
+}
+
+void MediaStreamTrack::SetLevelInterval(Local<String> property, Local<Value> value, const Nan::PropertyCallbackInfo<void> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  MediaStreamTrack *self = RTCWrap::Unwrap<MediaStreamTrack>(info.Holder(), "MediaStreamTrack");
+  
+  if (self->_analyzer.get() && !value.IsEmpty() && value->IsNumber()) {
+    self->_analyzer->SetInterval(value->Int32Value());
+  }
+}
+
+void MediaStreamTrack::CheckAnalyzer() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!isAudioTrack || !_track.get()) {
+    return;
+  }
+  
+  webrtc::AudioTrackInterface *track = static_cast<webrtc::AudioTrackInterface*>(_track.get());
+  bool active = !_onlevel.IsEmpty() || !_onspeakingchange.IsEmpty();
+  
+  if (active && !_analyzing) {
+    track->AddSink(_analyzer.get());
+  } else if (!active && _analyzing) {
+    track->RemoveSink(_analyzer.get());
+  }
+  
+  _analyzing = active;
+}
+
 void MediaStreamTrack::CheckState() {
   webrtc::MediaStreamTrackInterface::TrackState new_state = _track->state();
   webrtc::MediaSourceInterface::SourceState new_source = _source->state();
@@ -445,10 +547,39 @@ void MediaStreamTrack::On(Event *event) {
   
   Nan::HandleScope scope;
   MediaStreamTrackEvent type = event->Type<MediaStreamTrackEvent>();
-
-  if (type != kMediaStreamTrackChanged) {
-    return;
+  Local<Function> callback;
+  Local<Object> container;
+  Local<Value> argv[1];
+  AudioLevel level;
+  
+  switch (type) {
+    case kMediaStreamTrackChanged:
+      MediaStreamTrack::CheckState();
+      
+      break;
+    case kMediaStreamTrackLevel:
+      callback = Nan::New<Function>(_onlevel);
+      level = event->Unwrap<AudioLevel>();
+      
+      container = Nan::New<Object>();
+      container->Set(Nan::New("level").ToLocalChecked(), Nan::New(level.level));
+      container->Set(Nan::New("peak").ToLocalChecked(), Nan::New(level.peak));
+      container->Set(Nan::New("speaking").ToLocalChecked(), Nan::New(level.speaking));
+      argv[0] = container;
+      
+      break;
+    case kMediaStreamTrackSpeaking:
+      callback = Nan::New<Function>(_onspeakingchange);
+      level = event->Unwrap<AudioLevel>();
+      
+      container = Nan::New<Object>();
+      container->Set(Nan::New("speaking").ToLocalChecked(), Nan::New(level.speaking));
+      argv[0] = container;
+      
+      break;
   }
   
-  MediaStreamTrack::CheckState();
+  if (!callback.IsEmpty() && callback->IsFunction()) {
+    callback->Call(RTCWrap::This(), 1, argv);
+  }
 }
@@ -29,11 +29,14 @@
 #include "Common.h"
 #include "Observers.h" 
 #include "EventEmitter.h"
+#include "AudioAnalyzer.h"
 #include "Wrap.h"
 
 namespace WebRTC {
   enum MediaStreamTrackEvent {
-    kMediaStreamTrackChanged
+    kMediaStreamTrackChanged,
+    kMediaStreamTrackLevel,
+    kMediaStreamTrackSpeaking
   };  
   
   class MediaStreamTrack : public RTCWrap, public EventEmitter {
@@ -71,6 +74,9 @@ namespace WebRTC {
     static void GetOnUnMute(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
     static void GetOnOverConstrained(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
     static void GetOnEnded(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    static void GetOnLevel(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    static void GetOnSpeakingChange(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    static void GetLevelInterval(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
 
     static void ReadOnly(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
     static void SetEnabled(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
@@ -79,17 +85,23 @@ namespace WebRTC {
     static void SetOnUnMute(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
     static void SetOnOverConstrained(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
     static void SetOnEnded(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
+    static void SetOnLevel(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
+    static void SetOnSpeakingChange(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
+    static void SetLevelInterval(v8::Local<v8::String> property, v8::Local<v8::Value> value, const Nan::PropertyCallbackInfo<void> &info);
     
     void CheckState();
+    void CheckAnalyzer();
     void On(Event *event) final;
 
    protected:
     bool isAudioTrack;
     bool isVideoTrack;
+    bool _analyzing;
     
     rtc::scoped_refptr<webrtc::MediaStreamTrackInterface> _track;
     rtc::scoped_refptr<webrtc::MediaSourceInterface> _source;
     rtc::scoped_refptr<MediaStreamTrackObserver> _observer;
+    rtc::scoped_refptr<AudioAnalyzer> _analyzer;
  
     webrtc::MediaStreamTrackInterface::TrackState _track_state;
     webrtc::MediaSourceInterface::SourceState _source_state;
@@ -99,6 +111,8 @@ namespace WebRTC {
     Nan::Persistent<v8::Function> _onunmute;
     Nan::Persistent<v8::Function> _onoverconstrained;
     Nan::Persistent<v8::Function> _onended;
+    Nan::Persistent<v8::Function> _onlevel;
+    Nan::Persistent<v8::Function> _onspeakingchange;
 
     static Nan::Persistent<v8::Function> constructor;
   };
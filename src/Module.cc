@@ -23,6 +23,10 @@
 *
 */
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "Common.h"
 
 #include "Global.h"
@@ -31,10 +35,18 @@
 #include "PeerConnection.h"
 #include "DataChannel.h"
 #include "BackTrace.h"
+#include "EmitterMetrics.h"
 #include "GetSources.h"
 #include "GetUserMedia.h"
 #include "MediaStream.h"
 #include "MediaStreamTrack.h"
+#include "VideoSource.h"
+#include "AudioSource.h"
+#include "CertificateStore.h"
+#include "PeerConnectionPool.h"
+#include "Watchdog.h"
+
+#include "webrtc/base/timeutils.h"
 
 using namespace v8;
 
@@ -52,6 +64,16 @@ void SetDebug(const Nan::FunctionCallbackInfo<Value> &info) {
   info.GetReturnValue().SetUndefined();
 }
 
+void SetHeadless(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (info.Length() && !info[0].IsEmpty()) {
+    WebRTC::Platform::SetHeadless(info[0]->IsTrue());
+  }
+
+  info.GetReturnValue().SetUndefined();
+}
+
 void RTCGarbageCollect(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
@@ -92,9 +114,91 @@ void RTCSessionDescription(const Nan::FunctionCallbackInfo<Value> &info) {
   }
 }
 
+struct LoopHandles {
+  LoopHandles() : total(0), active(0) { }
+  
+  int total;
+  int active;
+  std::map<std::string, int> types;
+};
+
+static void CountLoopHandle(uv_handle_t *handle, void *arg) {
+  LoopHandles *handles = static_cast<LoopHandles*>(arg);
+  const char *type = "unknown";
+  
+  switch (handle->type) {
+#define XX(uc, lc) case UV_##uc: type = #lc; break;
+    UV_HANDLE_TYPE_MAP(XX)
+#undef XX
+    default:
+      break;
+  }
+  
+  handles->total++;
+  handles->types[type]++;
+  
+  if (uv_is_active(handle)) {
+    handles->active++;
+  }
+}
+
+void GetLoopHandles(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  LoopHandles handles;
+  Local<Object> retval = Nan::New<Object>();
+  Local<Object> types = Nan::New<Object>();
+  
+  uv_walk(uv_default_loop(), CountLoopHandle, &handles);
+  
+  for (std::map<std::string, int>::iterator it = handles.types.begin(); it != handles.types.end(); ++it) {
+    types->Set(Nan::New(it->first.c_str()).ToLocalChecked(), Nan::New(it->second));
+  }
+  
+  retval->Set(Nan::New("total").ToLocalChecked(), Nan::New(handles.total));
+  retval->Set(Nan::New("active").ToLocalChecked(), Nan::New(handles.active));
+  retval->Set(Nan::New("types").ToLocalChecked(), types);
+  
+  info.GetReturnValue().Set(retval);
+}
+
+void GetThreadMetrics(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  std::vector<WebRTC::ThreadMetrics> metrics;
+  Local<Array> retval = Nan::New<Array>();
+  
+  WebRTC::Platform::GetThreadMetrics(&metrics, info.Length() && info[0]->IsTrue());
+  
+  for (size_t index = 0; index < metrics.size(); index++) {
+    Local<Object> thread = Nan::New<Object>();
+    
+    thread->Set(Nan::New("name").ToLocalChecked(), Nan::New(metrics[index].name.c_str()).ToLocalChecked());
+    
+    if (metrics[index].cpu < 0) {
+      thread->Set(Nan::New("cpu").ToLocalChecked(), Nan::Null());
+    } else {
+      thread->Set(Nan::New("cpu").ToLocalChecked(), Nan::New(metrics[index].cpu));
+    }
+    
+    thread->Set(Nan::New("pending").ToLocalChecked(), Nan::New(static_cast<double>(metrics[index].pending)));
+    thread->Set(Nan::New("handled").ToLocalChecked(), Nan::New(static_cast<double>(metrics[index].handled)));
+    thread->Set(Nan::New("busy").ToLocalChecked(), Nan::New(static_cast<double>(metrics[index].busy) / rtc::kNumNanosecsPerMillisec));
+    thread->Set(Nan::New("maxLatency").ToLocalChecked(), Nan::New(static_cast<double>(metrics[index].maxLatency) / rtc::kNumNanosecsPerMillisec));
+    thread->Set(Nan::New("peers").ToLocalChecked(), Nan::New(metrics[index].peers));
+    
+    retval->Set(index, thread);
+  }
+  
+  info.GetReturnValue().Set(retval);
+}
+
 void WebrtcModuleDispose(void *arg) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  WebRTC::Watchdog::Dispose();
+  WebRTC::PeerConnectionPool::Dispose();
+  WebRTC::CertificateStore::Dispose();
   WebRTC::Platform::Dispose();
 }
 
@@ -113,11 +217,20 @@ void WebrtcModuleInit(Handle<Object> exports) {
   WebRTC::GetUserMedia::Init(exports);
   WebRTC::MediaStream::Init();
   WebRTC::MediaStreamTrack::Init();
+  WebRTC::VideoSource::Init(exports);
+  WebRTC::AudioSource::Init(exports);
+  WebRTC::CertificateStore::Init(exports);
+  WebRTC::PeerConnectionPool::Init(exports);
+  WebRTC::EmitterMetrics::Init(exports);
+  WebRTC::Watchdog::Init(exports);
   
   exports->Set(Nan::New("RTCGarbageCollect").ToLocalChecked(), Nan::New<FunctionTemplate>(RTCGarbageCollect)->GetFunction()); 
   exports->Set(Nan::New("RTCIceCandidate").ToLocalChecked(), Nan::New<FunctionTemplate>(RTCIceCandidate)->GetFunction());
   exports->Set(Nan::New("RTCSessionDescription").ToLocalChecked(), Nan::New<FunctionTemplate>(RTCSessionDescription)->GetFunction());
   exports->Set(Nan::New("setDebug").ToLocalChecked(), Nan::New<FunctionTemplate>(SetDebug)->GetFunction());
+  exports->Set(Nan::New("setHeadless").ToLocalChecked(), Nan::New<FunctionTemplate>(SetHeadless)->GetFunction());
+  exports->Set(Nan::New("getLoopHandles").ToLocalChecked(), Nan::New<FunctionTemplate>(GetLoopHandles)->GetFunction());
+  exports->Set(Nan::New("getThreadMetrics").ToLocalChecked(), Nan::New<FunctionTemplate>(GetThreadMetrics)->GetFunction());
 
   node::AtExit(WebrtcModuleDispose);
 }
@@ -110,11 +110,28 @@ void RemoteDescriptionObserver::OnFailure(const std::string &error) {
 }
 
 PeerConnectionObserver::PeerConnectionObserver(EventEmitter *listener) : 
-  NotifyEmitter(listener) { }
+  NotifyEmitter(listener),
+  _signalingState(webrtc::PeerConnectionInterface::kStable),
+  _iceConnectionState(webrtc::PeerConnectionInterface::kIceConnectionNew),
+  _iceGatheringState(webrtc::PeerConnectionInterface::kIceGatheringNew)
+{ }
+
+webrtc::PeerConnectionInterface::SignalingState PeerConnectionObserver::GetSignalingState() const {
+  return static_cast<webrtc::PeerConnectionInterface::SignalingState>(rtc::AtomicOps::AcquireLoad(&_signalingState));
+}
+
+webrtc::PeerConnectionInterface::IceConnectionState PeerConnectionObserver::GetIceConnectionState() const {
+  return static_cast<webrtc::PeerConnectionInterface::IceConnectionState>(rtc::AtomicOps::AcquireLoad(&_iceConnectionState));
+}
+
+webrtc::PeerConnectionInterface::IceGatheringState PeerConnectionObserver::GetIceGatheringState() const {
+  return static_cast<webrtc::PeerConnectionInterface::IceGatheringState>(rtc::AtomicOps::AcquireLoad(&_iceGatheringState));
+}
 
 void PeerConnectionObserver::OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState state) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  rtc::AtomicOps::ReleaseStore(&_signalingState, state);
   Emit(kPeerConnectionSignalChange);
   
   if (state == webrtc::PeerConnectionInterface::kClosed) {
@@ -125,12 +142,14 @@ void PeerConnectionObserver::OnSignalingChange(webrtc::PeerConnectionInterface::
 void PeerConnectionObserver::OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState state) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  rtc::AtomicOps::ReleaseStore(&_iceConnectionState, state);
   Emit(kPeerConnectionIceChange);
 }
 
 void PeerConnectionObserver::OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState state) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  rtc::AtomicOps::ReleaseStore(&_iceGatheringState, state);
   Emit(kPeerConnectionIceGathering);
   
   if (state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
@@ -147,6 +166,21 @@ void PeerConnectionObserver::OnDataChannel(webrtc::DataChannelInterface *channel
   
   rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel = channel;
   
+  if (LatencyResponder::IsProbe(channel)) {
+    std::vector<rtc::scoped_refptr<LatencyResponder> >::iterator it = _responders.begin();
+    
+    while (it != _responders.end()) {
+      if ((*it)->IsClosed()) {
+        it = _responders.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    
+    _responders.push_back(LatencyResponder::Create(dataChannel));
+    return;
+  }
+  
   if (dataChannel.get()) {
     Emit(kPeerConnectionDataChannel, dataChannel);
   }
@@ -26,7 +26,10 @@
 #ifndef WEBRTC_OBSERVERS_H
 #define WEBRTC_OBSERVERS_H
 
+#include <vector>
+
 #include "EventEmitter.h"
+#include "LatencyProbe.h"
 
 namespace WebRTC {  
   class OfferObserver : public webrtc::CreateSessionDescriptionObserver, public NotifyEmitter {
@@ -79,6 +82,17 @@ namespace WebRTC {
 
     void OnAddStream(webrtc::MediaStreamInterface* stream) final;
     void OnRemoveStream(webrtc::MediaStreamInterface* stream) final;
+    
+    webrtc::PeerConnectionInterface::SignalingState GetSignalingState() const;
+    webrtc::PeerConnectionInterface::IceConnectionState GetIceConnectionState() const;
+    webrtc::PeerConnectionInterface::IceGatheringState GetIceGatheringState() const;
+    
+   protected:
+    volatile int _signalingState;
+    volatile int _iceConnectionState;
+    volatile int _iceGatheringState;
+    
+    std::vector<rtc::scoped_refptr<LatencyResponder> > _responders;
   };
   
   class DataChannelObserver : 
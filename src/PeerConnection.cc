@@ -23,17 +23,210 @@
 *
 */
 
+#include <algorithm>
+#include <utility>
 #include <nan.h>
 #include "Global.h"
 #include "Platform.h"
 #include "PeerConnection.h"
 #include "DataChannel.h"
 #include "MediaStream.h"
+#include "AudioSource.h"
+#include "FileSource.h"
+#include "MediaStreamTrack.h"
 #include "Stats.h"
+#include "CertificateStore.h"
+#include "PeerConnectionPool.h"
+#include "PortAllocator.h"
+#include "webrtc/base/event.h"
 
 using namespace v8;
 using namespace WebRTC;
 
+enum PeerConnectionMessage {
+  kPeerConnectionCallCreate,
+  kPeerConnectionCallCreateOffer,
+  kPeerConnectionCallCreateAnswer,
+  kPeerConnectionCallSetLocalDescription,
+  kPeerConnectionCallSetRemoteDescription,
+  kPeerConnectionCallAddIceCandidate,
+  kPeerConnectionCallAddStream,
+  kPeerConnectionCallRemoveStream,
+  kPeerConnectionCallCreateDataChannel,
+  kPeerConnectionCallGetStats,
+  kPeerConnectionCallClose,
+};
+
+namespace WebRTC {
+  // Native connection of an RTCPeerConnection. It is created by the first call
+  // posted to the signaling thread and only used there, so the JS thread never
+  // waits for CreatePeerConnection.
+  struct PeerConnectionSocket : public rtc::RefCountInterface {
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> socket;
+  };
+  
+  struct PeerConnectionCall : public rtc::MessageData {
+    PeerConnectionCall(PeerConnectionSocket *socket, PeerConnectionObserver *peer) :
+      id(0),
+      socket(socket),
+      peer(peer),
+      desc(0),
+      worker(0),
+      init(0),
+      channel(0),
+      probeChannel(0),
+      done(0)
+    { }
+    
+    ~PeerConnectionCall() override {
+      delete desc;
+    }
+    
+    uint32_t id;
+    rtc::scoped_refptr<PeerConnectionSocket> socket;
+    rtc::scoped_refptr<PeerConnectionObserver> peer;
+    rtc::scoped_refptr<MediaConstraints> constraints;
+    rtc::scoped_refptr<webrtc::CreateSessionDescriptionObserver> create;
+    rtc::scoped_refptr<webrtc::SetSessionDescriptionObserver> set;
+    rtc::scoped_refptr<webrtc::StatsObserver> stats;
+    rtc::scoped_refptr<webrtc::MediaStreamInterface> stream;
+    rtc::scoped_ptr<webrtc::IceCandidateInterface> candidate;
+    webrtc::SessionDescriptionInterface *desc;
+    
+    // kPeerConnectionCallCreate
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory;
+    webrtc::PeerConnectionInterface::RTCConfiguration config;
+    TransportOptions transport;
+    rtc::Thread *worker;
+    
+    // kPeerConnectionCallCreateDataChannel, the caller waits on done.
+    std::string label;
+    webrtc::DataChannelInit *init;
+    rtc::scoped_refptr<webrtc::DataChannelInterface> *channel;
+    rtc::scoped_refptr<webrtc::DataChannelInterface> *probeChannel;
+    rtc::Event *done;
+  };
+};
+
+// Runs PeerConnectionInterface calls on the connection's signaling thread,
+// where the proxy calls them directly instead of blocking the JS thread.
+// Calls run in the order they were posted, so every call finds the connection
+// created by kPeerConnectionCallCreate.
+class PeerConnectionDispatcher : public rtc::MessageHandler {
+ public:
+  void OnMessage(rtc::Message *msg) final {
+    LOG(LS_INFO) << __PRETTY_FUNCTION__;
+    
+    PeerConnectionCall *call = static_cast<PeerConnectionCall*>(msg->pdata);
+    webrtc::PeerConnectionInterface *socket = call->socket->socket.get();
+    PeerConnectionCallResult result;
+    
+    result.id = call->id;
+    result.success = true;
+    
+    if (msg->message_id == kPeerConnectionCallCreate) {
+      rtc::scoped_ptr<cricket::PortAllocator> allocator(PortAllocator::Create(call->worker, call->transport));
+      
+      call->socket->socket = call->factory->CreatePeerConnection(call->config, call->constraints->ToConstraints(), std::move(allocator), NULL, call->peer.get());
+      
+      if (!call->socket->socket.get()) {
+        LOG(LS_ERROR) << "Internal Socket Error";
+      }
+    } else if (!socket) {
+      switch (msg->message_id) {
+        case kPeerConnectionCallCreateOffer:
+        case kPeerConnectionCallCreateAnswer:
+          call->create->OnFailure("Internal Socket Error");
+          break;
+        case kPeerConnectionCallSetLocalDescription:
+        case kPeerConnectionCallSetRemoteDescription:
+          call->set->OnFailure("Internal Socket Error");
+          break;
+        case kPeerConnectionCallCreateDataChannel:
+          call->done->Set();
+          break;
+        case kPeerConnectionCallGetStats:
+          call->peer->Emit(kPeerConnectionStatsError);
+          break;
+      }
+      
+      result.success = false;
+      result.error = "Internal Socket Error";
+    } else {
+      switch (msg->message_id) {
+        case kPeerConnectionCallCreateOffer:
+          socket->CreateOffer(call->create.get(), call->constraints->ToConstraints());
+          break;
+        case kPeerConnectionCallCreateAnswer:
+          socket->CreateAnswer(call->create.get(), call->constraints->ToConstraints());
+          break;
+        case kPeerConnectionCallSetLocalDescription:
+          socket->SetLocalDescription(call->set.get(), call->desc);
+          call->desc = 0;
+          break;
+        case kPeerConnectionCallSetRemoteDescription:
+          socket->SetRemoteDescription(call->set.get(), call->desc);
+          call->desc = 0;
+          break;
+        case kPeerConnectionCallAddIceCandidate:
+          if (!socket->AddIceCandidate(call->candidate.get())) {
+            result.success = false;
+            result.error = "Failed to add ICECandidate";
+          }
+          
+          break;
+        case kPeerConnectionCallAddStream:
+          if (!socket->AddStream(call->stream)) {
+            result.success = false;
+            result.error = "AddStream Failed";
+          }
+          
+          break;
+        case kPeerConnectionCallRemoveStream:
+          socket->RemoveStream(call->stream);
+          break;
+        case kPeerConnectionCallCreateDataChannel:
+          *call->channel = socket->CreateDataChannel(call->label, call->init);
+          
+          // The probe channel shares the reliability settings of the channel it
+          // measures but is always negotiated in-band.
+          if (call->channel->get() && call->probeChannel) {
+            webrtc::DataChannelInit probeConfig(*call->init);
+            
+            probeConfig.negotiated = false;
+            probeConfig.id = -1;
+            probeConfig.protocol = kLatencyProbeProtocol;
+            
+            *call->probeChannel = socket->CreateDataChannel(call->label, &probeConfig);
+          }
+          
+          call->done->Set();
+          break;
+        case kPeerConnectionCallGetStats:
+          if (!socket->GetStats(call->stats.get(), 0, webrtc::PeerConnectionInterface::kStatsOutputLevelStandard)) {
+            call->peer->Emit(kPeerConnectionStatsError);
+          }
+          
+          break;
+        case kPeerConnectionCallClose:
+          if (socket->signaling_state() != webrtc::PeerConnectionInterface::kClosed) {
+            socket->Close();
+          }
+          
+          break;
+      }
+    }
+    
+    if (result.id) {
+      call->peer->Emit(kPeerConnectionCallComplete, result);
+    }
+    
+    delete call;
+  }
+};
+
+static PeerConnectionDispatcher dispatcher;
+
 void PeerConnection::Init(Handle<Object> exports) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
@@ -77,11 +270,362 @@ void PeerConnection::Init(Handle<Object> exports) {
 Nan::Persistent<Function> PeerConnection::constructor;
 
 PeerConnection::PeerConnection(const Local<Object> &configuration,
-                               const Local<Object> &constraints)
+                               const Local<Object> &constraints) :
+  _signal(0),
+  _worker(0),
+  _callId(0)
 { 
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  SetEmitterName("PeerConnection");
+  
+  PooledPeerConnection pooled;
+  Local<Value> audioSource;
+  bool usePool = false;
+  
+  if (!configuration.IsEmpty()) {
+    audioSource = configuration->Get(Nan::New("audioSource").ToLocalChecked());
+    usePool = configuration->Get(Nan::New("pool").ToLocalChecked())->IsTrue();
+  }
+  
+  // Peers bound to an RTCAudioSource or a file audio track share its factory,
+  // pooled connections never do.
+  if (!audioSource.IsEmpty() && !audioSource->IsUndefined()) {
+    _factory = AudioSource::GetFactory(audioSource, &_signal, &_worker);
     
+    if (!_factory.get()) {
+      _factory = FileSource::GetFactory(MediaStreamTrack::Unwrap(audioSource), &_signal, &_worker);
+    }
+    
+    usePool = false;
+  }
+
+  _stats = new rtc::RefCountedObject<StatsObserver>(this);
+  _offer = new rtc::RefCountedObject<OfferObserver>(this);
+  _answer = new rtc::RefCountedObject<AnswerObserver>(this);
+  _local = new rtc::RefCountedObject<LocalDescriptionObserver>(this);
+  _remote = new rtc::RefCountedObject<RemoteDescriptionObserver>(this);
+  
+  PeerConnection::GetConfiguration(configuration, &_config, &_transport);
+  _constraints = PeerConnection::GetConstraints(constraints);
+  
+  if (usePool && PeerConnectionPool::Instance()->Take(_config, _transport, _constraints, &pooled)) {
+    _config = pooled.config;
+    _worker = pooled.worker;
+    _factory = pooled.factory;
+    _signal = pooled.signal;
+    _socket = new rtc::RefCountedObject<PeerConnectionSocket>();
+    _socket->socket = pooled.socket;
+    _peer = pooled.observer;
+    _peer->AddListener(this);
+    
+    Platform::AddPeer(_signal);
+    EventEmitter::SetReference(true);
+    return;
+  }
+  
+  if (_config.certificates.empty()) {
+    rtc::scoped_refptr<rtc::RTCCertificate> certificate = CertificateStore::Instance()->Take();
+    
+    if (certificate.get()) {
+      _config.certificates.push_back(certificate);
+    }
+  }
+
+  _peer = new rtc::RefCountedObject<PeerConnectionObserver>(this);
+  
+  if (!_factory.get()) {
+    _factory = Platform::CreateFactory(&_signal, &_worker);
+  }
+  
+  Platform::AddPeer(_signal);
+}
+
+PeerConnection::~PeerConnection() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Platform::RemovePeer(_signal);
+  
+  if (_socket.get() && _peer->GetSignalingState() != webrtc::PeerConnectionInterface::kClosed) {
+    _signal->Post(&dispatcher, kPeerConnectionCallClose, new PeerConnectionCall(_socket.get(), _peer.get()));
+  }
+  
+  std::map<uint32_t, PendingCall*>::iterator index;
+  
+  for (index = _calls.begin(); index != _calls.end(); index++) {
+    delete index->second;
+  }
+  
+  _calls.clear();
+  _stats->RemoveListener(this);
+  _offer->RemoveListener(this);
+  _answer->RemoveListener(this);
+  _local->RemoveListener(this);
+  _remote->RemoveListener(this);
+  _peer->RemoveListener(this);
+}
+
+// Lite peers only keep the selected pair alive, backup pairs are pinged
+// rarely instead of every couple of seconds.
+#define kIceLiteBackupPingInterval 25000
+
+// Default ping interval of createDataChannel({ latencyProbe: true }).
+#define kLatencyProbeInterval 1000
+
+// Marks a local answer as coming from an ICE-lite agent (RFC 5245
+// section 15.3). Only answers are marked: as answerer the agent already is
+// controlled, while an offerer stays controlling and would conflict with
+// a remote side that takes the controlling role for a lite peer.
+static void SetIceLite(Local<Value> value) {
+  if (value.IsEmpty() || !value->IsObject()) {
+    return;
+  }
+  
+  Local<Object> desc = Local<Object>::Cast(value);
+  Local<Value> sdp_value = desc->Get(Nan::New("sdp").ToLocalChecked());
+  
+  if (sdp_value.IsEmpty() || !sdp_value->IsString()) {
+    return;
+  }
+  
+  String::Utf8Value sdp_utf8(sdp_value->ToString());
+  std::string sdp(*sdp_utf8);
+  size_t timing = sdp.find("\r\nt=");
+  
+  if (sdp.find("a=ice-lite") != std::string::npos || timing == std::string::npos) {
+    return;
+  }
+  
+  size_t end = sdp.find("\r\n", timing + 2);
+  
+  if (end != std::string::npos) {
+    sdp.insert(end + 2, "a=ice-lite\r\n");
+    desc->Set(Nan::New("sdp").ToLocalChecked(), Nan::New(sdp.c_str()).ToLocalChecked());
+  }
+}
+
+static bool GetString(const Local<Object> &object, const char *key, std::string *value) {
+  Local<Value> entry = object->Get(Nan::New(key).ToLocalChecked());
+  
+  if (!entry.IsEmpty() && entry->IsString()) {
+    String::Utf8Value data(entry->ToString());
+    *value = *data;
+    return true;
+  }
+  
+  return false;
+}
+
+static bool GetInteger(const Local<Object> &object, const char *key, int *value) {
+  Local<Value> entry = object->Get(Nan::New(key).ToLocalChecked());
+  
+  if (!entry.IsEmpty() && entry->IsUint32()) {
+    *value = static_cast<int>(entry->Uint32Value());
+    return true;
+  }
+  
+  return false;
+}
+
+static bool GetNumber(const Local<Object> &object, const char *key, double *value) {
+  Local<Value> entry = object->Get(Nan::New(key).ToLocalChecked());
+  
+  if (!entry.IsEmpty() && entry->IsNumber()) {
+    *value = entry->NumberValue();
+    return true;
+  }
+  
+  return false;
+}
+
+static bool GetProbability(const Local<Object> &object, const char *key, double *value) {
+  double probability = 0;
+  
+  if (GetNumber(object, key, &probability)) {
+    *value = std::min(std::max(probability, 0.0), 1.0);
+    return true;
+  }
+  
+  return false;
+}
+
+static void GetEmulation(const Local<Object> &emulation, EmulationOptions *options) {
+  std::string distribution;
+  double bandwidth = 0;
+  int seed = 0;
+  
+  GetInteger(emulation, "delay", &options->delay);
+  GetInteger(emulation, "jitter", &options->jitter);
+  
+  if (GetString(emulation, "distribution", &distribution)) {
+    if (distribution == "normal") {
+      options->distribution = kEmulationNormal;
+    } else if (distribution == "uniform") {
+      options->distribution = kEmulationUniform;
+    } else {
+      LOG(LS_WARNING) << "Invalid networkEmulation.distribution: " << distribution;
+    }
+  }
+  
+  GetProbability(emulation, "loss", &options->loss);
+  GetProbability(emulation, "reorder", &options->reorder);
+  
+  Local<Value> burst_value = emulation->Get(Nan::New("burstLoss").ToLocalChecked());
+  
+  if (!burst_value.IsEmpty() && burst_value->IsObject()) {
+    Local<Object> burst = Local<Object>::Cast(burst_value);
+    
+    GetProbability(burst, "enter", &options->burstEnter);
+    GetProbability(burst, "exit", &options->burstExit);
+    GetProbability(burst, "loss", &options->burstLoss);
+  }
+  
+  if (GetNumber(emulation, "bandwidth", &bandwidth) && bandwidth > 0) {
+    options->bandwidth = static_cast<int64_t>(bandwidth);
+  }
+  
+  GetInteger(emulation, "burst", &options->burst);
+  GetInteger(emulation, "queue", &options->queue);
+  
+  if (GetInteger(emulation, "seed", &seed)) {
+    options->seed = static_cast<uint32_t>(seed);
+  }
+}
+
+void PeerConnection::GetConfiguration(const Local<Object> &configuration,
+                                      webrtc::PeerConnectionInterface::RTCConfiguration *config,
+                                      TransportOptions *transport)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
   if (!configuration.IsEmpty()) {
+    std::string policy;
+    
+    if (GetString(configuration, "bundlePolicy", &policy)) {
+      if (policy == "balanced") {
+        config->bundle_policy = webrtc::PeerConnectionInterface::kBundlePolicyBalanced;
+      } else if (policy == "max-bundle") {
+        config->bundle_policy = webrtc::PeerConnectionInterface::kBundlePolicyMaxBundle;
+      } else if (policy == "max-compat") {
+        config->bundle_policy = webrtc::PeerConnectionInterface::kBundlePolicyMaxCompat;
+      } else {
+        LOG(LS_WARNING) << "Unknown bundlePolicy " << policy;
+      }
+    }
+    
+    if (GetString(configuration, "rtcpMuxPolicy", &policy)) {
+      if (policy == "negotiate") {
+        config->rtcp_mux_policy = webrtc::PeerConnectionInterface::kRtcpMuxPolicyNegotiate;
+      } else if (policy == "require") {
+        config->rtcp_mux_policy = webrtc::PeerConnectionInterface::kRtcpMuxPolicyRequire;
+      } else {
+        LOG(LS_WARNING) << "Unknown rtcpMuxPolicy " << policy;
+      }
+    }
+    
+    if (GetString(configuration, "iceTransportPolicy", &policy)) {
+      if (policy == "all") {
+        config->type = webrtc::PeerConnectionInterface::kAll;
+      } else if (policy == "relay") {
+        config->type = webrtc::PeerConnectionInterface::kRelay;
+      } else if (policy == "nohost") {
+        config->type = webrtc::PeerConnectionInterface::kNoHost;
+      } else if (policy == "none") {
+        config->type = webrtc::PeerConnectionInterface::kNone;
+      } else {
+        LOG(LS_WARNING) << "Unknown iceTransportPolicy " << policy;
+      }
+    }
+    
+    if (GetString(configuration, "tcpCandidatePolicy", &policy)) {
+      if (policy == "enabled") {
+        config->tcp_candidate_policy = webrtc::PeerConnectionInterface::kTcpCandidatePolicyEnabled;
+      } else if (policy == "disabled") {
+        config->tcp_candidate_policy = webrtc::PeerConnectionInterface::kTcpCandidatePolicyDisabled;
+      } else {
+        LOG(LS_WARNING) << "Unknown tcpCandidatePolicy " << policy;
+      }
+    }
+    
+    if (GetString(configuration, "continualGatheringPolicy", &policy)) {
+      if (policy == "gather_once") {
+        config->continual_gathering_policy = webrtc::PeerConnectionInterface::GATHER_ONCE;
+      } else if (policy == "gather_continually") {
+        config->continual_gathering_policy = webrtc::PeerConnectionInterface::GATHER_CONTINUALLY;
+      } else {
+        LOG(LS_WARNING) << "Unknown continualGatheringPolicy " << policy;
+      }
+    }
+    
+    Local<Value> ignore_value = configuration->Get(Nan::New("networkIgnore").ToLocalChecked());
+    
+    if (!ignore_value.IsEmpty() && ignore_value->IsArray()) {
+      Local<Array> list = Local<Array>::Cast(ignore_value);
+      
+      for (unsigned int index = 0; index < list->Length(); index++) {
+        String::Utf8Value type_value(list->Get(index)->ToString());
+        std::string type(*type_value);
+        
+        if (type == "ethernet") {
+          transport->networkIgnoreMask |= rtc::ADAPTER_TYPE_ETHERNET;
+        } else if (type == "wifi") {
+          transport->networkIgnoreMask |= rtc::ADAPTER_TYPE_WIFI;
+        } else if (type == "cellular") {
+          transport->networkIgnoreMask |= rtc::ADAPTER_TYPE_CELLULAR;
+        } else if (type == "vpn") {
+          transport->networkIgnoreMask |= rtc::ADAPTER_TYPE_VPN;
+        } else if (type == "loopback") {
+          transport->networkIgnoreMask |= rtc::ADAPTER_TYPE_LOOPBACK;
+        } else {
+          LOG(LS_WARNING) << "Unknown network type " << type;
+        }
+      }
+    }
+    
+    Local<Value> range_value = configuration->Get(Nan::New("portRange").ToLocalChecked());
+    
+    if (!range_value.IsEmpty() && range_value->IsObject()) {
+      Local<Object> range = Local<Object>::Cast(range_value);
+      int minPort = 0, maxPort = 0;
+      
+      if (GetInteger(range, "min", &minPort) && GetInteger(range, "max", &maxPort) &&
+          minPort > 0 && minPort <= maxPort && maxPort <= 65535)
+      {
+        transport->minPort = minPort;
+        transport->maxPort = maxPort;
+      } else {
+        LOG(LS_WARNING) << "Invalid portRange";
+      }
+    }
+    
+    GetInteger(configuration, "udpReceiveBufferSize", &transport->receiveBuffer);
+    GetInteger(configuration, "udpSendBufferSize", &transport->sendBuffer);
+    GetInteger(configuration, "udpMuxPort", &transport->muxPort);
+    
+    transport->batching = configuration->Get(Nan::New("udpBatching").ToLocalChecked())->IsTrue();
+    transport->iceLite = configuration->Get(Nan::New("iceLite").ToLocalChecked())->IsTrue();
+    transport->virtualNetwork = configuration->Get(Nan::New("virtualNetwork").ToLocalChecked())->IsTrue();
+    
+    Local<Value> emulation_value = configuration->Get(Nan::New("networkEmulation").ToLocalChecked());
+    
+    if (!emulation_value.IsEmpty() && emulation_value->IsObject()) {
+      GetEmulation(Local<Object>::Cast(emulation_value), &transport->emulation);
+    }
+    
+    // Every transport and component of a session shares one ufrag, so the
+    // shared port can only route a session that has a single one of them.
+    if (transport->muxPort && (config->bundle_policy != webrtc::PeerConnectionInterface::kBundlePolicyMaxBundle ||
+                               config->rtcp_mux_policy != webrtc::PeerConnectionInterface::kRtcpMuxPolicyRequire))
+    {
+      LOG(LS_WARNING) << "udpMuxPort needs bundlePolicy 'max-bundle' and rtcpMuxPolicy 'require', using dedicated UDP sockets";
+      transport->muxPort = 0;
+    }
+    
+    if (transport->iceLite) {
+      config->continual_gathering_policy = webrtc::PeerConnectionInterface::GATHER_ONCE;
+      config->ice_backup_candidate_pair_ping_interval = kIceLiteBackupPingInterval;
+    }
+    
     Local<Value> iceservers_value = configuration->Get(Nan::New("iceServers").ToLocalChecked());
     
     if (!iceservers_value.IsEmpty() && iceservers_value->IsArray()) {
@@ -112,60 +656,61 @@ PeerConnection::PeerConnection(const Local<Object> &configuration,
               entry.password = *credential;
             }
 
-            _config.servers.push_back(entry);
+            config->servers.push_back(entry);
           }
         }        
       }
     }
-  }
-
-  _constraints = MediaConstraints::New(constraints);
-
-  if (!_constraints->GetOptional("RtpDataChannels")) {
-    if (!_constraints->IsOptional("DtlsSrtpKeyAgreement")) {
-      _constraints->SetOptional("DtlsSrtpKeyAgreement", "true");
+    
+    Local<Value> certificates_value = configuration->Get(Nan::New("certificates").ToLocalChecked());
+    
+    if (!certificates_value.IsEmpty() && certificates_value->IsArray()) {
+      Local<Array> list = Local<Array>::Cast(certificates_value);
+      
+      for (unsigned int index = 0; index < list->Length(); index++) {
+        rtc::scoped_refptr<rtc::RTCCertificate> certificate = RTCCertificate::Unwrap(list->Get(index));
+        
+        if (certificate.get()) {
+          config->certificates.push_back(certificate);
+        }
+      }
     }
   }
-
-  _stats = new rtc::RefCountedObject<StatsObserver>(this);
-  _offer = new rtc::RefCountedObject<OfferObserver>(this);
-  _answer = new rtc::RefCountedObject<AnswerObserver>(this);
-  _local = new rtc::RefCountedObject<LocalDescriptionObserver>(this);
-  _remote = new rtc::RefCountedObject<RemoteDescriptionObserver>(this);
-  _peer = new rtc::RefCountedObject<PeerConnectionObserver>(this);
-  _factory = webrtc::CreatePeerConnectionFactory(rtc::Thread::Current(), Platform::GetWorker(), 0, 0, 0);
 }
 
-PeerConnection::~PeerConnection() {
+rtc::scoped_refptr<MediaConstraints> PeerConnection::GetConstraints(const Local<Object> &constraints) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
-  if (_socket.get()) {
-    webrtc::PeerConnectionInterface::SignalingState state(_socket->signaling_state());
+  rtc::scoped_refptr<MediaConstraints> retval = MediaConstraints::New(constraints);
 
-    if (state != webrtc::PeerConnectionInterface::kClosed) {
-      _socket->Close();
+  if (!retval->GetOptional("RtpDataChannels")) {
+    if (!retval->IsOptional("DtlsSrtpKeyAgreement")) {
+      retval->SetOptional("DtlsSrtpKeyAgreement", "true");
     }
   }
   
-  _stats->RemoveListener(this);
-  _offer->RemoveListener(this);
-  _answer->RemoveListener(this);
-  _local->RemoveListener(this);
-  _remote->RemoveListener(this);
-  _peer->RemoveListener(this);
+  return retval;
 }
 
-webrtc::PeerConnectionInterface *PeerConnection::GetSocket() {
+PeerConnectionSocket *PeerConnection::GetSocket() {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
+  // The connection is created on the signaling thread ahead of the call that
+  // needs it, calls posted meanwhile queue behind it.
   if (!_socket.get()) {
     if (_factory.get()) {
       EventEmitter::SetReference(true);
-      _socket = _factory->CreatePeerConnection(_config, _constraints->ToConstraints(), NULL, NULL, _peer.get());
+      _socket = new rtc::RefCountedObject<PeerConnectionSocket>();
       
-      if (!_socket.get()) {
-        Nan::ThrowError("Internal Socket Error");
-      }
+      PeerConnectionCall *call = new PeerConnectionCall(_socket.get(), _peer.get());
+      
+      call->factory = _factory;
+      call->config = _config;
+      call->constraints = _constraints;
+      call->transport = _transport;
+      call->worker = _worker;
+      
+      _signal->Post(&dispatcher, kPeerConnectionCallCreate, call);
     } else {
       Nan::ThrowError("Internal Factory Error");
     }
@@ -174,6 +719,55 @@ webrtc::PeerConnectionInterface *PeerConnection::GetSocket() {
   return _socket.get();
 }
 
+void PeerConnection::Post(uint32_t message, PeerConnectionCall *call, Local<Value> onsuccess, Local<Value> onerror) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  PendingCall *pending = new PendingCall();
+  
+  if (!onsuccess.IsEmpty() && onsuccess->IsFunction()) {
+    pending->onsuccess.Reset<Function>(Local<Function>::Cast(onsuccess));
+  }
+  
+  if (!onerror.IsEmpty() && onerror->IsFunction()) {
+    pending->onerror.Reset<Function>(Local<Function>::Cast(onerror));
+  }
+  
+  if (message == kPeerConnectionCallAddStream) {
+    pending->stream = call->stream;
+  }
+  
+  if (!++_callId) {
+    _callId++;
+  }
+  
+  call->id = _callId;
+  _calls[call->id] = pending;
+  
+  _signal->Post(&dispatcher, message, call);
+}
+
+void PeerConnection::RemoveLocalStream(const rtc::scoped_refptr<webrtc::MediaStreamInterface> &stream) {
+  std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface> >::iterator index;
+  
+  for (index = _localStreams.begin(); index != _localStreams.end(); index++) {
+    if (index->get() == stream.get()) {
+      _localStreams.erase(index);
+      break;
+    }
+  }
+}
+
+void PeerConnection::RemoveRemoteStream(const rtc::scoped_refptr<webrtc::MediaStreamInterface> &stream) {
+  std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface> >::iterator index;
+  
+  for (index = _remoteStreams.begin(); index != _remoteStreams.end(); index++) {
+    if (index->get() == stream.get()) {
+      _remoteStreams.erase(index);
+      break;
+    }
+  }
+}
+
 void PeerConnection::New(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
@@ -208,7 +802,8 @@ void PeerConnection::CreateOffer(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("createOffer");
+  PeerConnectionSocket *socket = self->GetSocket();
   
   if (!info[0].IsEmpty() && info[0]->IsFunction()) {
     self->_offerCallback.Reset<Function>(Local<Function>::Cast(info[0]));
@@ -223,7 +818,12 @@ void PeerConnection::CreateOffer(const Nan::FunctionCallbackInfo<Value> &info) {
   }
   
   if (socket) {
-    socket->CreateOffer(self->_offer.get(), self->_constraints->ToConstraints());
+    PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+    
+    call->create = self->_offer.get();
+    call->constraints = self->_constraints;
+    
+    self->Post(kPeerConnectionCallCreateOffer, call);
   } else {
     Nan::ThrowError("Internal Error");
   }
@@ -235,7 +835,8 @@ void PeerConnection::CreateAnswer(const Nan::FunctionCallbackInfo<Value> &info)
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("createAnswer");
+  PeerConnectionSocket *socket = self->GetSocket();
   
   if (!info[0].IsEmpty() && info[0]->IsFunction()) {
     self->_answerCallback.Reset<Function>(Local<Function>::Cast(info[0]));
@@ -250,7 +851,12 @@ void PeerConnection::CreateAnswer(const Nan::FunctionCallbackInfo<Value> &info)
   }
   
   if (socket) {
-    socket->CreateAnswer(self->_answer.get(), self->_constraints->ToConstraints());
+    PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+    
+    call->create = self->_answer.get();
+    call->constraints = self->_constraints;
+    
+    self->Post(kPeerConnectionCallCreateAnswer, call);
   } else {
     Nan::ThrowError("Internal Error");
   }
@@ -262,7 +868,8 @@ void PeerConnection::SetLocalDescription(const Nan::FunctionCallbackInfo<Value>
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("setLocalDescription");
+  PeerConnectionSocket *socket = self->GetSocket();
   const char *error = "Invalid SessionDescription";
 
   if (!info[0].IsEmpty() && info[0]->IsObject()) {
@@ -291,8 +898,13 @@ void PeerConnection::SetLocalDescription(const Nan::FunctionCallbackInfo<Value>
         
         if (desc) {
           if (socket) {
+            PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+            
+            call->set = self->_local.get();
+            call->desc = desc;
+            
             self->_localsdp.Reset<Object>(desc_obj);
-            socket->SetLocalDescription(self->_local.get(), desc);
+            self->Post(kPeerConnectionCallSetLocalDescription, call);
             error = 0;
           } else {
             error = "Internal Error";
@@ -322,7 +934,8 @@ void PeerConnection::SetRemoteDescription(const Nan::FunctionCallbackInfo<Value>
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("setRemoteDescription");
+  PeerConnectionSocket *socket = self->GetSocket();
   const char *error = "Invalid SessionDescription";
   
   if (!info[0].IsEmpty() && info[0]->IsObject()) {
@@ -351,8 +964,13 @@ void PeerConnection::SetRemoteDescription(const Nan::FunctionCallbackInfo<Value>
         
         if (desc) {
           if (socket) {
+            PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+            
+            call->set = self->_remote.get();
+            call->desc = desc;
+            
             self->_remotesdp.Reset<Object>(desc_obj);
-            socket->SetRemoteDescription(self->_remote.get(), desc);
+            self->Post(kPeerConnectionCallSetRemoteDescription, call);
             error = 0;
           } else {
             error = "Internal Error";
@@ -382,7 +1000,8 @@ void PeerConnection::AddIceCandidate(const Nan::FunctionCallbackInfo<Value> &inf
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("addIceCandidate");
+  PeerConnectionSocket *socket = self->GetSocket();
   
   const char *error = 0;
   Local<Value> argv[1];
@@ -404,14 +1023,10 @@ void PeerConnection::AddIceCandidate(const Nan::FunctionCallbackInfo<Value> &inf
   
           if (candidate.get()) {
             if (socket) {
-              if (socket->AddIceCandidate(candidate.get())) {
-                if (!info[1].IsEmpty() && info[1]->IsFunction()) {
-                  Local<Function> success = Local<Function>::Cast(info[1]);
-                  success->Call(info.This(), 0, argv);
-                }
-              } else {            
-                error = "Failed to add ICECandidate";
-              }
+              PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+              
+              call->candidate.reset(candidate.release());
+              self->Post(kPeerConnectionCallAddIceCandidate, call, info[1], info[2]);
             } else {
               error = "Internal Error";
             }
@@ -447,7 +1062,8 @@ void PeerConnection::CreateDataChannel(const Nan::FunctionCallbackInfo<Value> &i
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("createDataChannel");
+  PeerConnectionSocket *socket = self->GetSocket();
 
   std::string label;
   webrtc::DataChannelInit config;
@@ -457,8 +1073,10 @@ void PeerConnection::CreateDataChannel(const Nan::FunctionCallbackInfo<Value> &i
     label = *label_utf8;
   }
   
+  int probe = 0;
+  
   if (!info[1].IsEmpty() && info[1]->IsObject()) {
-    Local<Object> config_obj = Local<Object>::Cast(info[0]);
+    Local<Object> config_obj = Local<Object>::Cast(info[1]);
     
     Local<Value> reliable_value = config_obj->Get(Nan::New("reliable").ToLocalChecked());
     Local<Value> ordered_value = config_obj->Get(Nan::New("ordered").ToLocalChecked());
@@ -502,13 +1120,46 @@ void PeerConnection::CreateDataChannel(const Nan::FunctionCallbackInfo<Value> &i
       Local<Int32> id(id_value->ToInt32());
       config.id = id->Value();
     }
+    
+    Local<Value> probe_value = config_obj->Get(Nan::New("latencyProbe").ToLocalChecked());
+    
+    if (!probe_value.IsEmpty()) {
+      if (probe_value->IsTrue()) {
+        probe = kLatencyProbeInterval;
+      } else if (probe_value->IsUint32() && probe_value->Uint32Value()) {
+        probe = static_cast<int>(probe_value->Uint32Value());
+      }
+    }
   }
   
+  // Posted behind the calls already queued and waited for, a channel created
+  // after createOffer() is part of that offer.
   if (socket) {
-    rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel = socket->CreateDataChannel(label, &config);
+    rtc::scoped_refptr<webrtc::DataChannelInterface> dataChannel;
+    rtc::scoped_refptr<webrtc::DataChannelInterface> probeChannel;
+    rtc::scoped_refptr<LatencyProbe> latencyProbe;
+    rtc::Event done(false, false);
+    PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+    
+    call->label = label;
+    call->init = &config;
+    call->channel = &dataChannel;
+    call->probeChannel = probe ? &probeChannel : 0;
+    call->done = &done;
+    
+    self->_signal->Post(&dispatcher, kPeerConnectionCallCreateDataChannel, call);
+    done.Wait(rtc::Event::kForever);
+    
+    if (dataChannel.get() && probe) {
+      if (probeChannel.get()) {
+        latencyProbe = LatencyProbe::Create(self->_signal, probeChannel, probe);
+      } else {
+        LOG(LS_WARNING) << "Unable to create latency probe channel";
+      }
+    }
     
     if (dataChannel.get()) {
-      return info.GetReturnValue().Set(DataChannel::New(dataChannel));
+      return info.GetReturnValue().Set(DataChannel::New(dataChannel, latencyProbe));
     }
   }
   
@@ -520,15 +1171,20 @@ void PeerConnection::AddStream(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
+  self->Trace("addStream");
   rtc::scoped_refptr<webrtc::MediaStreamInterface> mediaStream = MediaStream::Unwrap(info[0]);
 
   if (mediaStream.get()) {
-    webrtc::PeerConnectionInterface *socket = self->GetSocket();
+    PeerConnectionSocket *socket = self->GetSocket();
 
     if (socket) {
-      if (!socket->AddStream(mediaStream)) {
-        Nan::ThrowError("AddStream Failed");
-      }
+      PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+      
+      call->stream = mediaStream;
+      
+      self->RemoveLocalStream(mediaStream);
+      self->_localStreams.push_back(mediaStream);
+      self->Post(kPeerConnectionCallAddStream, call, Local<Value>(), info[1]);
     } else {
       Nan::ThrowError("Internal Error");
     }
@@ -543,13 +1199,19 @@ void PeerConnection::RemoveStream(const Nan::FunctionCallbackInfo<Value> &info)
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
+  self->Trace("removeStream");
   rtc::scoped_refptr<webrtc::MediaStreamInterface> mediaStream = MediaStream::Unwrap(info[0]);
 
   if (mediaStream.get()) {
-    webrtc::PeerConnectionInterface *socket = self->GetSocket();
+    PeerConnectionSocket *socket = self->GetSocket();
 
     if (socket) {
-      socket->RemoveStream(mediaStream);
+      PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+      
+      call->stream = mediaStream;
+      
+      self->RemoveLocalStream(mediaStream);
+      self->Post(kPeerConnectionCallRemoveStream, call);
     } else {
       Nan::ThrowError("Internal Error");
     }
@@ -564,88 +1226,56 @@ void PeerConnection::GetLocalStreams(const Nan::FunctionCallbackInfo<Value> &inf
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
-
-  if (socket) {
-    rtc::scoped_refptr<webrtc::StreamCollectionInterface> local = socket->local_streams();
-
-    if (local.get()) {
-      Local<Array> list = Nan::New<Array>();
-      uint32_t index = 0;
-      size_t count;
+  Local<Array> list = Nan::New<Array>();
+  uint32_t index;
 
-      for (count = 0; count < local->count(); count++) {
-        list->Set(index, MediaStream::New(local->at(count)));
-      }
-
-      return info.GetReturnValue().Set(list);
-    }
+  for (index = 0; index < self->_localStreams.size(); index++) {
+    list->Set(index, MediaStream::New(self->_localStreams[index]));
   }
-    
-  Nan::ThrowError("Internal Error");
-  info.GetReturnValue().SetUndefined();
+
+  info.GetReturnValue().Set(list);
 }
 
 void PeerConnection::GetRemoteStreams(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
-
-  if (socket) {
-    rtc::scoped_refptr<webrtc::StreamCollectionInterface> remote = socket->remote_streams();
+  Local<Array> list = Nan::New<Array>();
+  uint32_t index;
 
-    if (remote.get()) {
-      Local<Array> list = Nan::New<Array>();
-      uint32_t index = 0;
-      size_t count;
-
-      for (count = 0; count < remote->count(); count++) {
-        list->Set(index, MediaStream::New(remote->at(count)));
-      }
-
-      return info.GetReturnValue().Set(list);
-    }
+  for (index = 0; index < self->_remoteStreams.size(); index++) {
+    list->Set(index, MediaStream::New(self->_remoteStreams[index]));
   }
 
-  Nan::ThrowError("Internal Error");
-  info.GetReturnValue().SetUndefined();
+  info.GetReturnValue().Set(list);
 }
 
 void PeerConnection::GetStreamById(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
-
-  if (socket) {
-    if (info.Length() >= 1 && info[0]->IsString()) {
-      v8::String::Utf8Value idValue(info[0]->ToString());
-      std::string id(*idValue);
 
-      rtc::scoped_refptr<webrtc::StreamCollectionInterface> local = socket->local_streams();
-      rtc::scoped_refptr<webrtc::StreamCollectionInterface> remote = socket->remote_streams();
-      rtc::scoped_refptr<webrtc::MediaStreamInterface> stream;
+  if (info.Length() >= 1 && info[0]->IsString()) {
+    v8::String::Utf8Value idValue(info[0]->ToString());
+    std::string id(*idValue);
+    size_t index;
 
-      if (local.get()) {
-        stream = local->find(id);
+    for (index = 0; index < self->_localStreams.size(); index++) {
+      if (self->_localStreams[index]->label().compare(id) == 0) {
+        return info.GetReturnValue().Set(MediaStream::New(self->_localStreams[index]));
       }
+    }
 
-      if (remote.get() && !stream.get()) {
-        stream = remote->find(id);
+    for (index = 0; index < self->_remoteStreams.size(); index++) {
+      if (self->_remoteStreams[index]->label().compare(id) == 0) {
+        return info.GetReturnValue().Set(MediaStream::New(self->_remoteStreams[index]));
       }
-
-      if (stream.get()) {
-        return info.GetReturnValue().Set(MediaStream::New(stream));
-      } else {
-        return info.GetReturnValue().Set(Nan::Null());
-      }
-    } else {
-      Nan::ThrowError("Invalid Argument");
     }
+
+    return info.GetReturnValue().Set(Nan::Null());
   }
 
-  Nan::ThrowError("Internal Error");
+  Nan::ThrowError("Invalid Argument");
   info.GetReturnValue().SetUndefined();
 }
 
@@ -653,19 +1283,17 @@ void PeerConnection::GetStats(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("getStats");
+  PeerConnectionSocket *socket = self->GetSocket();
 
   if (!info[0].IsEmpty() && info[0]->IsFunction()) {
     self->_onstats.Reset<Function>(Local<Function>::Cast(info[0]));
 
     if (socket) {
-      if (!socket->GetStats(self->_stats.get(), 0, webrtc::PeerConnectionInterface::kStatsOutputLevelStandard)) {
-        Local<Function> callback = Nan::New<Function>(self->_onstats);
-        Local<Value> argv[1] = { Nan::Null() };
-
-        callback->Call(info.This(), 1, argv);
-        self->_onstats.Reset();
-      }
+      PeerConnectionCall *call = new PeerConnectionCall(socket, self->_peer.get());
+      
+      call->stats = self->_stats.get();
+      self->_signal->Post(&dispatcher, kPeerConnectionCallGetStats, call);
     } else {
       Nan::ThrowError("Internal Error");
     }
@@ -680,10 +1308,11 @@ void PeerConnection::Close(const Nan::FunctionCallbackInfo<Value> &info) {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.This(), "PeerConnection"); 
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
+  self->Trace("close");
+  PeerConnectionSocket *socket = self->GetSocket();
   
   if (socket) {
-    socket->Close();
+    self->_signal->Post(&dispatcher, kPeerConnectionCallClose, new PeerConnectionCall(socket, self->_peer.get()));
   } else {
     Nan::ThrowError("Internal Error");
   }
@@ -695,33 +1324,27 @@ void PeerConnection::GetSignalingState(Local<String> property, const Nan::Proper
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.Holder(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
-
-  if (socket) {
-    webrtc::PeerConnectionInterface::SignalingState state(socket->signaling_state());
-    
-    switch (state) {
-      case webrtc::PeerConnectionInterface::kStable:
-        return info.GetReturnValue().Set(Nan::New("stable").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kHaveLocalOffer:
-        return info.GetReturnValue().Set(Nan::New("have-local-offer").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kHaveLocalPrAnswer:
-        return info.GetReturnValue().Set(Nan::New("have-local-pranswer").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kHaveRemoteOffer:
-        return info.GetReturnValue().Set(Nan::New("have-remote-offer").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kHaveRemotePrAnswer:
-        return info.GetReturnValue().Set(Nan::New("have-remote-pranswer").ToLocalChecked());
-        break;
-      default: 
-        return info.GetReturnValue().Set(Nan::New("closed").ToLocalChecked());
-        break;
-    }
-  } else {
-    Nan::ThrowError("Internal Error");
+  webrtc::PeerConnectionInterface::SignalingState state(self->_peer->GetSignalingState());
+  
+  switch (state) {
+    case webrtc::PeerConnectionInterface::kStable:
+      return info.GetReturnValue().Set(Nan::New("stable").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kHaveLocalOffer:
+      return info.GetReturnValue().Set(Nan::New("have-local-offer").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kHaveLocalPrAnswer:
+      return info.GetReturnValue().Set(Nan::New("have-local-pranswer").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kHaveRemoteOffer:
+      return info.GetReturnValue().Set(Nan::New("have-remote-offer").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kHaveRemotePrAnswer:
+      return info.GetReturnValue().Set(Nan::New("have-remote-pranswer").ToLocalChecked());
+      break;
+    default: 
+      return info.GetReturnValue().Set(Nan::New("closed").ToLocalChecked());
+      break;
   }
   
   info.GetReturnValue().SetUndefined();
@@ -731,36 +1354,30 @@ void PeerConnection::GetIceConnectionState(Local<String> property, const Nan::Pr
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.Holder(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
-
-  if (socket) {
-    webrtc::PeerConnectionInterface::IceConnectionState state(socket->ice_connection_state());
-
-    switch (state) {
-      case webrtc::PeerConnectionInterface::kIceConnectionNew:
-        return info.GetReturnValue().Set(Nan::New("new").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kIceConnectionChecking:
-        return info.GetReturnValue().Set(Nan::New("checking").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kIceConnectionConnected:
-        return info.GetReturnValue().Set(Nan::New("connected").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kIceConnectionCompleted:
-        return info.GetReturnValue().Set(Nan::New("completed").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kIceConnectionFailed:
-        return info.GetReturnValue().Set(Nan::New("failed").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kIceConnectionDisconnected:
-        return info.GetReturnValue().Set(Nan::New("disconnected").ToLocalChecked());
-        break;
-      default:
-        return info.GetReturnValue().Set(Nan::New("closed").ToLocalChecked());
-        break;
-    }
-  } else {
-    Nan::ThrowError("Internal Error");
+  webrtc::PeerConnectionInterface::IceConnectionState state(self->_peer->GetIceConnectionState());
+  
+  switch (state) {
+    case webrtc::PeerConnectionInterface::kIceConnectionNew:
+      return info.GetReturnValue().Set(Nan::New("new").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionChecking:
+      return info.GetReturnValue().Set(Nan::New("checking").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionConnected:
+      return info.GetReturnValue().Set(Nan::New("connected").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionCompleted:
+      return info.GetReturnValue().Set(Nan::New("completed").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionFailed:
+      return info.GetReturnValue().Set(Nan::New("failed").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kIceConnectionDisconnected:
+      return info.GetReturnValue().Set(Nan::New("disconnected").ToLocalChecked());
+      break;
+    default:
+      return info.GetReturnValue().Set(Nan::New("closed").ToLocalChecked());
+      break;
   }
   
   info.GetReturnValue().SetUndefined();
@@ -770,24 +1387,18 @@ void PeerConnection::GetIceGatheringState(Local<String> property, const Nan::Pro
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
   PeerConnection *self = RTCWrap::Unwrap<PeerConnection>(info.Holder(), "PeerConnection");
-  webrtc::PeerConnectionInterface *socket = self->GetSocket();
-
-  if (socket) {
-    webrtc::PeerConnectionInterface::IceGatheringState state(socket->ice_gathering_state());
-
-    switch (state) {
-      case webrtc::PeerConnectionInterface::kIceGatheringNew:
-        return info.GetReturnValue().Set(Nan::New("new").ToLocalChecked());
-        break;
-      case webrtc::PeerConnectionInterface::kIceGatheringGathering:
-        return info.GetReturnValue().Set(Nan::New("gathering").ToLocalChecked());
-        break;
-      default:
-        return info.GetReturnValue().Set(Nan::New("complete").ToLocalChecked());
-        break;
-    }   
-  } else {
-    Nan::ThrowError("Internal Error");
+  webrtc::PeerConnectionInterface::IceGatheringState state(self->_peer->GetIceGatheringState());
+  
+  switch (state) {
+    case webrtc::PeerConnectionInterface::kIceGatheringNew:
+      return info.GetReturnValue().Set(Nan::New("new").ToLocalChecked());
+      break;
+    case webrtc::PeerConnectionInterface::kIceGatheringGathering:
+      return info.GetReturnValue().Set(Nan::New("gathering").ToLocalChecked());
+      break;
+    default:
+      return info.GetReturnValue().Set(Nan::New("complete").ToLocalChecked());
+      break;
   }
   
   info.GetReturnValue().SetUndefined();
@@ -955,6 +1566,9 @@ void PeerConnection::On(Event *event) {
   bool isError = false;
   std::string data;
   int argc = 0;
+  rtc::scoped_refptr<webrtc::MediaStreamInterface> stream;
+  std::map<uint32_t, PendingCall*>::iterator pending;
+  PeerConnectionCallResult result;
   
   switch (type) {
     case kPeerConnectionCreateClosed:
@@ -994,6 +1608,10 @@ void PeerConnection::On(Event *event) {
       argv[0] = JSON::Parse(Nan::New(data.c_str()).ToLocalChecked());
       argc = 1;
       
+      if (_transport.iceLite) {
+        SetIceLite(argv[0]);
+      }
+      
       break;
     case kPeerConnectionCreateAnswerError:
       callback = Nan::New<Function>(_answerErrorCallback);
@@ -1086,9 +1704,13 @@ void PeerConnection::On(Event *event) {
       break;
     case kPeerConnectionAddStream:
       callback = Nan::New<Function>(_onaddstream);
+      stream = event->Unwrap<rtc::scoped_refptr<webrtc::MediaStreamInterface> >();
+      
+      PeerConnection::RemoveRemoteStream(stream);
+      _remoteStreams.push_back(stream);
 
       container = Nan::New<Object>();
-      container->Set(Nan::New("stream").ToLocalChecked(), MediaStream::New(event->Unwrap<rtc::scoped_refptr<webrtc::MediaStreamInterface> >()));
+      container->Set(Nan::New("stream").ToLocalChecked(), MediaStream::New(stream));
       
       argv[0] = container;
       argc = 1;
@@ -1096,9 +1718,12 @@ void PeerConnection::On(Event *event) {
       break;
     case kPeerConnectionRemoveStream:
       callback = Nan::New<Function>(_onremovestream);
+      stream = event->Unwrap<rtc::scoped_refptr<webrtc::MediaStreamInterface> >();
+      
+      PeerConnection::RemoveRemoteStream(stream);
       
       container = Nan::New<Object>();
-      container->Set(Nan::New("stream").ToLocalChecked(), MediaStream::New(event->Unwrap<rtc::scoped_refptr<webrtc::MediaStreamInterface> >()));
+      container->Set(Nan::New("stream").ToLocalChecked(), MediaStream::New(stream));
       
       argv[0] = container;
       argc = 1;
@@ -1114,6 +1739,41 @@ void PeerConnection::On(Event *event) {
       argv[0] = RTCStatsResponse::New(event->Unwrap<webrtc::StatsReports>());
       argc = 1;
 
+      break;
+    case kPeerConnectionStatsError:
+      callback = Nan::New<Function>(_onstats);
+      
+      _onstats.Reset();
+      
+      argv[0] = Nan::Null();
+      argc = 1;
+      
+      break;
+    case kPeerConnectionCallComplete:
+      result = event->Unwrap<PeerConnectionCallResult>();
+      pending = _calls.find(result.id);
+      
+      if (pending == _calls.end()) {
+        return;
+      }
+      
+      if (result.success) {
+        callback = Nan::New<Function>(pending->second->onsuccess);
+      } else {
+        callback = Nan::New<Function>(pending->second->onerror);
+        
+        if (pending->second->stream.get()) {
+          PeerConnection::RemoveLocalStream(pending->second->stream);
+        }
+        
+        isError = true;
+        argv[0] = Nan::Error(result.error.c_str());
+        argc = 1;
+      }
+      
+      delete pending->second;
+      _calls.erase(pending);
+      
       break;
   }
   
@@ -1125,16 +1785,6 @@ void PeerConnection::On(Event *event) {
 }
 
 bool PeerConnection::IsStable() {
-  webrtc::PeerConnectionInterface *socket = PeerConnection::GetSocket();
-
-  if (socket) {
-    webrtc::PeerConnectionInterface::SignalingState state(socket->signaling_state());
-    
-    if (state == webrtc::PeerConnectionInterface::kStable) {
-      return true;
-    }
-  }
-  
-  return false;
+  return (_peer->GetSignalingState() == webrtc::PeerConnectionInterface::kStable);
 }
 
@@ -26,10 +26,13 @@
 #ifndef WEBRTC_PEERCONNECTION_H
 #define WEBRTC_PEERCONNECTION_H
 
+#include <map>
+
 #include "Common.h"
 #include "Observers.h" 
 #include "EventEmitter.h"
 #include "MediaConstraints.h"
+#include "PortAllocator.h"
 #include "Wrap.h"
 
 namespace WebRTC {
@@ -51,12 +54,27 @@ namespace WebRTC {
     kPeerConnectionAddStream,
     kPeerConnectionRemoveStream,
     kPeerConnectionRenegotiation,
-    kPeerConnectionStats
+    kPeerConnectionStats,
+    kPeerConnectionStatsError,
+    kPeerConnectionCallComplete
   };  
   
+  struct PeerConnectionSocket;
+  struct PeerConnectionCall;
+  
+  struct PeerConnectionCallResult {
+    uint32_t id;
+    bool success;
+    std::string error;
+  };
+  
   class PeerConnection : public RTCWrap, public EventEmitter {
    public:
     static void Init(v8::Handle<v8::Object> exports);
+    static void GetConfiguration(const v8::Local<v8::Object> &configuration,
+                                 webrtc::PeerConnectionInterface::RTCConfiguration *config,
+                                 TransportOptions *transport);
+    static rtc::scoped_refptr<MediaConstraints> GetConstraints(const v8::Local<v8::Object> &constraints);
     
    private:
     PeerConnection(const v8::Local<v8::Object> &configuration,
@@ -105,9 +123,18 @@ namespace WebRTC {
     
     bool IsStable();
     
-    webrtc::PeerConnectionInterface *GetSocket();
+    PeerConnectionSocket *GetSocket();
+    void Post(uint32_t message, PeerConnectionCall *call, v8::Local<v8::Value> onsuccess = v8::Local<v8::Value>(), v8::Local<v8::Value> onerror = v8::Local<v8::Value>());
+    void RemoveLocalStream(const rtc::scoped_refptr<webrtc::MediaStreamInterface> &stream);
+    void RemoveRemoteStream(const rtc::scoped_refptr<webrtc::MediaStreamInterface> &stream);
     
    protected:
+    struct PendingCall {
+      Nan::Persistent<v8::Function> onsuccess;
+      Nan::Persistent<v8::Function> onerror;
+      rtc::scoped_refptr<webrtc::MediaStreamInterface> stream;
+    };
+    
     Nan::Persistent<v8::Function> _onsignalingstatechange;
     Nan::Persistent<v8::Function> _oniceconnectionstatechange;
     Nan::Persistent<v8::Function> _onicecandidate;
@@ -141,11 +168,19 @@ namespace WebRTC {
     rtc::scoped_refptr<LocalDescriptionObserver> _local;
     rtc::scoped_refptr<RemoteDescriptionObserver> _remote;
     rtc::scoped_refptr<PeerConnectionObserver> _peer;
-    rtc::scoped_refptr<webrtc::PeerConnectionInterface> _socket;
+    rtc::scoped_refptr<PeerConnectionSocket> _socket;
     rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> _factory;
     
     rtc::scoped_refptr<MediaConstraints> _constraints;
     webrtc::PeerConnectionInterface::RTCConfiguration _config;
+    
+    TransportOptions _transport;
+    rtc::Thread *_signal;
+    rtc::Thread *_worker;
+    uint32_t _callId;
+    std::map<uint32_t, PendingCall*> _calls;
+    std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface> > _localStreams;
+    std::vector<rtc::scoped_refptr<webrtc::MediaStreamInterface> > _remoteStreams;
   };
 };
 
@@ -0,0 +1,306 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include <utility>
+
+#include "Platform.h"
+#include "PeerConnection.h"
+#include "PeerConnectionPool.h"
+#include "CertificateStore.h"
+
+using namespace v8;
+using namespace WebRTC;
+
+static bool SameServers(const webrtc::PeerConnectionInterface::IceServers &a, const webrtc::PeerConnectionInterface::IceServers &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  
+  for (size_t index = 0; index < a.size(); index++) {
+    if (a[index].uri != b[index].uri || a[index].username != b[index].username || a[index].password != b[index].password) {
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+static bool SameCertificates(const std::vector<rtc::scoped_refptr<rtc::RTCCertificate> > &a, const std::vector<rtc::scoped_refptr<rtc::RTCCertificate> > &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  
+  for (size_t index = 0; index < a.size(); index++) {
+    if (a[index].get() != b[index].get()) {
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+static bool SameConstraints(const webrtc::MediaConstraintsInterface::Constraints &a, const webrtc::MediaConstraintsInterface::Constraints &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  
+  for (size_t index = 0; index < a.size(); index++) {
+    if (a[index].key != b[index].key || a[index].value != b[index].value) {
+      return false;
+    }
+  }
+  
+  return true;
+}
+
+static bool SameConfiguration(const webrtc::PeerConnectionInterface::RTCConfiguration &a, const webrtc::PeerConnectionInterface::RTCConfiguration &b) {
+  return a.type == b.type &&
+         a.bundle_policy == b.bundle_policy &&
+         a.rtcp_mux_policy == b.rtcp_mux_policy &&
+         a.tcp_candidate_policy == b.tcp_candidate_policy &&
+         a.continual_gathering_policy == b.continual_gathering_policy &&
+         a.ice_backup_candidate_pair_ping_interval == b.ice_backup_candidate_pair_ping_interval &&
+         SameServers(a.servers, b.servers) &&
+         SameCertificates(a.certificates, b.certificates);
+}
+
+PeerConnectionPool::PeerConnectionPool() :
+  _running(false),
+  _filling(false),
+  _size(0),
+  _generation(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+PeerConnectionPool::~PeerConnectionPool() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+void PeerConnectionPool::Init(Handle<Object> exports) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  exports->Set(Nan::New("setPeerConnectionPool").ToLocalChecked(), Nan::New<FunctionTemplate>(PeerConnectionPool::SetPeerConnectionPool)->GetFunction());
+}
+
+void PeerConnectionPool::Dispose() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  PeerConnectionPool *self = PeerConnectionPool::Instance();
+  
+  {
+    rtc::CritScope lock(&self->_lock);
+    self->_size = 0;
+  }
+  
+  if (self->_running) {
+    self->_thread.SetAllowBlockingCalls(true);
+    self->_thread.Stop();
+    self->_running = false;
+  }
+  
+  std::vector<PooledPeerConnection> pool;
+  
+  {
+    rtc::CritScope lock(&self->_lock);
+    
+    pool.swap(self->_pool);
+    self->_filling = false;
+  }
+  
+  for (size_t index = 0; index < pool.size(); index++) {
+    pool[index].socket->Close();
+  }
+}
+
+PeerConnectionPool *PeerConnectionPool::Instance() {
+  static PeerConnectionPool *pool = new PeerConnectionPool();
+  return pool;
+}
+
+bool PeerConnectionPool::Take(const webrtc::PeerConnectionInterface::RTCConfiguration &config,
+                              const TransportOptions &transport,
+                              const rtc::scoped_refptr<MediaConstraints> &constraints,
+                              PooledPeerConnection *entry)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  
+  if (_pool.empty()) {
+    return false;
+  }
+  
+  if (!SameConfiguration(config, _config) || !transport.Equals(_transport) ||
+      !SameConstraints(constraints->GetMandatory(), _constraints->GetMandatory()) ||
+      !SameConstraints(constraints->GetOptional(), _constraints->GetOptional()))
+  {
+    LOG(LS_INFO) << "Configuration differs from the pool, creating a new connection";
+    return false;
+  }
+  
+  *entry = _pool.back();
+  _pool.pop_back();
+  
+  PeerConnectionPool::Fill();
+  return true;
+}
+
+void PeerConnectionPool::Configure(const webrtc::PeerConnectionInterface::RTCConfiguration &config,
+                                   const TransportOptions &transport,
+                                   const rtc::scoped_refptr<MediaConstraints> &constraints,
+                                   size_t size)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  std::vector<PooledPeerConnection> stale;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    stale.swap(_pool);
+    
+    _config = config;
+    _transport = transport;
+    _constraints = constraints;
+    _size = size;
+    _generation++;
+    
+    if (!_running && _size) {
+      _thread.SetName("pool", 0);
+      _running = _thread.Start();
+    }
+    
+    PeerConnectionPool::Fill();
+  }
+  
+  for (size_t index = 0; index < stale.size(); index++) {
+    stale[index].socket->Close();
+  }
+}
+
+void PeerConnectionPool::Fill() {
+  if (!_filling && _running && _pool.size() < _size) {
+    _filling = true;
+    _thread.Post(this);
+  }
+}
+
+void PeerConnectionPool::OnMessage(rtc::Message *msg) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  PooledPeerConnection entry;
+  uint32_t generation;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    entry.config = _config;
+    entry.transport = _transport;
+    entry.constraints = _constraints;
+    generation = _generation;
+  }
+  
+  if (entry.config.certificates.empty()) {
+    rtc::scoped_refptr<rtc::RTCCertificate> certificate = CertificateStore::Instance()->Take();
+    
+    if (certificate.get()) {
+      entry.config.certificates.push_back(certificate);
+    }
+  }
+  
+  // Building the socket blocks on the shard threads, so it runs here and
+  // never on the JS thread or a shard worker.
+  entry.factory = Platform::CreateFactory(&entry.signal, &entry.worker);
+  entry.observer = new rtc::RefCountedObject<PeerConnectionObserver>();
+  
+  if (entry.factory.get()) {
+    rtc::scoped_ptr<cricket::PortAllocator> allocator(PortAllocator::Create(entry.worker, entry.transport));
+    
+    entry.socket = entry.factory->CreatePeerConnection(entry.config, entry.constraints->ToConstraints(), std::move(allocator), NULL, entry.observer.get());
+  }
+  
+  bool expired = false;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    _filling = false;
+    
+    if (!entry.socket.get()) {
+      LOG(LS_ERROR) << "Unable to create pooled PeerConnection";
+      return;
+    }
+    
+    if (generation == _generation && _pool.size() < _size) {
+      _pool.push_back(entry);
+    } else {
+      expired = true;
+    }
+    
+    PeerConnectionPool::Fill();
+  }
+  
+  // Closing blocks on the shard threads, never do it holding the pool lock.
+  if (expired) {
+    entry.socket->Close();
+  }
+}
+
+void PeerConnectionPool::SetPeerConnectionPool(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  webrtc::PeerConnectionInterface::RTCConfiguration config;
+  TransportOptions transport;
+  Local<Object> configuration;
+  Local<Object> constraints;
+  size_t size = 0;
+  
+  if (info.Length() < 1 || !info[0]->IsObject()) {
+    Nan::ThrowError("Invalid Argument");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  Local<Object> options = Local<Object>::Cast(info[0]);
+  Local<Value> size_value = options->Get(Nan::New("size").ToLocalChecked());
+  Local<Value> configuration_value = options->Get(Nan::New("configuration").ToLocalChecked());
+  Local<Value> constraints_value = options->Get(Nan::New("constraints").ToLocalChecked());
+  
+  if (!size_value.IsEmpty() && size_value->IsUint32()) {
+    size = size_value->Uint32Value();
+  }
+  
+  if (!configuration_value.IsEmpty() && configuration_value->IsObject()) {
+    configuration = Local<Object>::Cast(configuration_value);
+  }
+  
+  if (!constraints_value.IsEmpty() && constraints_value->IsObject()) {
+    constraints = Local<Object>::Cast(constraints_value);
+  }
+  
+  PeerConnection::GetConfiguration(configuration, &config, &transport);
+  PeerConnectionPool::Instance()->Configure(config, transport, PeerConnection::GetConstraints(constraints), size);
+  
+  info.GetReturnValue().SetUndefined();
+}
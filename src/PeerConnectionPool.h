@@ -0,0 +1,95 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_PEERCONNECTIONPOOL_H
+#define WEBRTC_PEERCONNECTIONPOOL_H
+
+#include <vector>
+
+#include "Common.h"
+#include "Observers.h"
+#include "MediaConstraints.h"
+#include "PortAllocator.h"
+
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/messagehandler.h"
+
+namespace WebRTC {
+  struct PooledPeerConnection {
+    PooledPeerConnection() : signal(0), worker(0) { }
+    
+    webrtc::PeerConnectionInterface::RTCConfiguration config;
+    TransportOptions transport;
+    rtc::scoped_refptr<MediaConstraints> constraints;
+    rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory;
+    rtc::scoped_refptr<webrtc::PeerConnectionInterface> socket;
+    rtc::scoped_refptr<PeerConnectionObserver> observer;
+    rtc::Thread *signal;
+    rtc::Thread *worker;
+  };
+  
+  // Keeps PeerConnections built ahead of time, factory, certificate and
+  // socket included, so new RTCPeerConnection({ pool: true }) only has to
+  // attach its listeners.
+  class PeerConnectionPool : public rtc::MessageHandler {
+   public:
+    static void Init(v8::Handle<v8::Object> exports);
+    static void Dispose();
+    static PeerConnectionPool *Instance();
+    
+    // Hands out a pooled connection only when config, transport and
+    // constraints match the ones the pool was configured with.
+    bool Take(const webrtc::PeerConnectionInterface::RTCConfiguration &config,
+              const TransportOptions &transport,
+              const rtc::scoped_refptr<MediaConstraints> &constraints,
+              PooledPeerConnection *entry);
+    void OnMessage(rtc::Message *msg) final;
+    
+   private:
+    PeerConnectionPool();
+    ~PeerConnectionPool() override;
+    
+    static void SetPeerConnectionPool(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    
+    void Configure(const webrtc::PeerConnectionInterface::RTCConfiguration &config,
+                   const TransportOptions &transport,
+                   const rtc::scoped_refptr<MediaConstraints> &constraints,
+                   size_t size);
+    void Fill();
+    
+   protected:
+    rtc::CriticalSection _lock;
+    rtc::Thread _thread;
+    bool _running;
+    bool _filling;
+    size_t _size;
+    uint32_t _generation;
+    webrtc::PeerConnectionInterface::RTCConfiguration _config;
+    TransportOptions _transport;
+    rtc::scoped_refptr<MediaConstraints> _constraints;
+    std::vector<PooledPeerConnection> _pool;
+  };
+};
+
+#endif
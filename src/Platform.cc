@@ -24,8 +24,15 @@
 *
 */
 
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
 #include "Platform.h"
 
+#include "webrtc/base/criticalsection.h"
+
 #if defined(WEBRTC_WIN)
 #include <webrtc/base/win32socketinit.h>
 #include <webrtc/base/win32socketserver.h>
@@ -37,9 +44,44 @@ using namespace WebRTC;
 #define WEBRTC_THREAD_COUNT 4
 #endif
 
-rtc::Thread signal_thread;
-rtc::Thread worker_thread[WEBRTC_THREAD_COUNT];
-uint32_t counter = 0;
+#define WEBRTC_THREAD_MAX 64
+
+// Each shard pairs a signaling thread with a worker thread. A factory and
+// every PeerConnection created from it stay on one shard, so the only state
+// shared between shards is the event queue back to the uv loop.
+struct PlatformShard {
+  MonitoredThread signaling;
+  MonitoredThread worker;
+  
+  // Virtual audio device of the shard and the factory bound to it, created
+  // on first use. The device has a single transport, so headless peers on
+  // this shard share the factory.
+  rtc::scoped_refptr<AudioDevice> device;
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory;
+};
+
+std::vector<PlatformShard*> shards;
+MonitoredThread device_thread;
+rtc::Thread *main_thread = 0;
+volatile int counter = 0;
+
+bool headless = false;
+rtc::CriticalSection factory_lock;
+
+static PlatformShard *NextShard() {
+  uint32_t index = static_cast<uint32_t>(rtc::AtomicOps::Increment(&counter));
+  return shards[index % shards.size()];
+}
+
+static PlatformShard *FindShard(rtc::Thread *signaling) {
+  for (size_t index = 0; index < shards.size(); index++) {
+    if (&shards[index]->signaling == signaling) {
+      return shards[index];
+    }
+  }
+  
+  return 0;
+}
 
 void Platform::Init() {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
@@ -49,38 +91,185 @@ void Platform::Init() {
 #endif
   
   rtc::InitializeSSL();
-   
-  signal_thread.Start();
   
-  rtc::ThreadManager::Instance()->SetCurrentThread(&signal_thread);
+  main_thread = rtc::ThreadManager::Instance()->WrapCurrentThread();
   
-  if (rtc::ThreadManager::Instance()->CurrentThread() != &signal_thread) {
+  if (!main_thread) {
     Nan::ThrowError("Internal Thread Error!");
   }
   
-  for (int index = 0; index < WEBRTC_THREAD_COUNT; index++) {
-    worker_thread[index].Start();
+  int count = WEBRTC_THREAD_COUNT;
+  const char *env = getenv("WEBRTC_THREADS");
+  
+  if (env && *env) {
+    count = atoi(env);
+  }
+  
+  count = std::min(std::max(count, 1), WEBRTC_THREAD_MAX);
+  
+  for (int index = 0; index < count; index++) {
+    PlatformShard *shard = new PlatformShard();
+    
+    // Named so per thread CPU time can be attributed, see test/scale.js.
+    shard->signaling.SetName("signaling-" + rtc::ToString(index), 0);
+    shard->worker.SetName("worker-" + rtc::ToString(index), 0);
+    shard->signaling.Start();
+    shard->worker.Start();
+    shards.push_back(shard);
+  }
+  
+  device_thread.SetName("device", 0);
+  device_thread.Start();
+  
+  env = getenv("WEBRTC_HEADLESS");
+  
+  if (env && *env && strcmp(env, "0")) {
+    headless = true;
   }
 }
 
 void Platform::Dispose() {
   LOG(LS_INFO) << __PRETTY_FUNCTION__;
   
-  signal_thread.SetAllowBlockingCalls(true);
-  signal_thread.Stop();
+  for (size_t index = 0; index < shards.size(); index++) {
+    shards[index]->factory = NULL;
+    shards[index]->device = NULL;
+  }
+  
+  device_thread.SetAllowBlockingCalls(true);
+  device_thread.Stop();
   
-  for (int index = 0; index < WEBRTC_THREAD_COUNT; index++) {
-    worker_thread[index].SetAllowBlockingCalls(true);
-    worker_thread[index].Stop();
+  for (size_t index = 0; index < shards.size(); index++) {
+    shards[index]->signaling.SetAllowBlockingCalls(true);
+    shards[index]->signaling.Stop();
+    shards[index]->worker.SetAllowBlockingCalls(true);
+    shards[index]->worker.Stop();
+    
+    delete shards[index];
   }
+  
+  shards.clear();
 
-  if (rtc::ThreadManager::Instance()->CurrentThread() == &signal_thread) {
-    rtc::ThreadManager::Instance()->SetCurrentThread(NULL);
+  if (main_thread && rtc::ThreadManager::Instance()->CurrentThread() == main_thread) {
+    rtc::ThreadManager::Instance()->UnwrapCurrentThread();
   }
   
+  main_thread = 0;
   rtc::CleanupSSL();
 }
 
+size_t Platform::GetShardCount() {
+  return shards.size();
+}
+
 rtc::Thread *Platform::GetWorker() {
-  return &worker_thread[(counter++) % WEBRTC_THREAD_COUNT];
-}
\ No newline at end of file
+  return &NextShard()->worker;
+}
+
+rtc::Thread *Platform::GetDeviceWorker() {
+  return &device_thread;
+}
+
+void Platform::SetHeadless(bool enable) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  headless = enable;
+}
+
+bool Platform::IsHeadless() {
+  return headless;
+}
+
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> Platform::CreateFactory(rtc::Thread **signaling, rtc::Thread **worker, AudioDevice *device) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!device && headless) {
+    return Platform::GetHeadlessFactory(signaling, worker);
+  }
+  
+  PlatformShard *shard = NextShard();
+  
+  // Sources owning a device get a factory of their own, its peers are the
+  // only ones recording from and playing out to that device.
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = webrtc::CreatePeerConnectionFactory(&shard->worker, &shard->signaling, device, 0, 0);
+  
+  if (signaling) {
+    *signaling = &shard->signaling;
+  }
+  
+  if (worker) {
+    *worker = &shard->worker;
+  }
+  
+  return factory;
+}
+
+rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> Platform::GetHeadlessFactory(rtc::Thread **signaling, rtc::Thread **worker) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  PlatformShard *shard = NextShard();
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory;
+  
+  {
+    rtc::CritScope lock(&factory_lock);
+    
+    if (!shard->factory.get()) {
+      // Records only what is pushed, file tracks feed their senders directly.
+      shard->device = AudioDevice::Create(false);
+      shard->factory = webrtc::CreatePeerConnectionFactory(&shard->worker, &shard->signaling, shard->device.get(), 0, 0);
+    }
+    
+    factory = shard->factory;
+  }
+  
+  if (signaling) {
+    *signaling = &shard->signaling;
+  }
+  
+  if (worker) {
+    *worker = &shard->worker;
+  }
+  
+  return factory;
+}
+
+void Platform::AddPeer(rtc::Thread *signaling) {
+  PlatformShard *shard = FindShard(signaling);
+  
+  if (shard) {
+    shard->signaling.AddPeer();
+    shard->worker.AddPeer();
+  }
+}
+
+void Platform::RemovePeer(rtc::Thread *signaling) {
+  PlatformShard *shard = FindShard(signaling);
+  
+  if (shard) {
+    shard->signaling.RemovePeer();
+    shard->worker.RemovePeer();
+  }
+}
+
+void Platform::GetThreadMetrics(std::vector<ThreadMetrics> *metrics, bool reset) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  std::vector<MonitoredThread*> threads;
+  ThreadMetrics thread;
+  
+  Platform::GetThreads(&threads);
+  
+  for (size_t index = 0; index < threads.size(); index++) {
+    threads[index]->GetMetrics(&thread, reset);
+    metrics->push_back(thread);
+  }
+}
+
+void Platform::GetThreads(std::vector<MonitoredThread*> *threads) {
+  for (size_t index = 0; index < shards.size(); index++) {
+    threads->push_back(&shards[index]->signaling);
+    threads->push_back(&shards[index]->worker);
+  }
+  
+  threads->push_back(&device_thread);
+}
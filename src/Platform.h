@@ -26,14 +26,33 @@
 #ifndef WEBRTC_PLATFORM_H
 #define WEBRTC_PLATFORM_H
 
+#include <vector>
+
 #include "Common.h"
+#include "AudioDevice.h"
+#include "ThreadMonitor.h"
 
 namespace WebRTC {
   class Platform {
 	  public:
 	    static void Init();
 	    static void Dispose();
+      static size_t GetShardCount();
       static rtc::Thread *GetWorker();
+      static rtc::Thread *GetDeviceWorker();
+      
+      static void SetHeadless(bool headless);
+      static bool IsHeadless();
+      static rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> CreateFactory(rtc::Thread **signaling = 0, rtc::Thread **worker = 0, AudioDevice *device = 0);
+      
+      // Factory on the next shard that uses the shard's virtual audio device,
+      // regardless of the headless setting.
+      static rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> GetHeadlessFactory(rtc::Thread **signaling = 0, rtc::Thread **worker = 0);
+      
+      static void AddPeer(rtc::Thread *signaling);
+      static void RemovePeer(rtc::Thread *signaling);
+      static void GetThreadMetrics(std::vector<ThreadMetrics> *metrics, bool reset = false);
+      static void GetThreads(std::vector<MonitoredThread*> *threads);
   };
 };
 
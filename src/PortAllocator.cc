@@ -0,0 +1,167 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include "PortAllocator.h"
+#include "UdpMux.h"
+#include "BatchedSocket.h"
+#include "VirtualNetwork.h"
+
+using namespace WebRTC;
+
+SocketFactory::SocketFactory(rtc::Thread *thread, const TransportOptions &options) :
+  rtc::BasicPacketSocketFactory(thread),
+  _thread(thread),
+  _options(options)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+SocketFactory::~SocketFactory() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (_options.muxPort) {
+    UdpMux::Get(_options.muxPort)->RemoveOwner(this);
+  }
+}
+
+void SocketFactory::AddUfrag(const std::string &ufrag) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (_options.muxPort) {
+    UdpMux::Get(_options.muxPort)->AddUfrag(this, ufrag);
+  }
+}
+
+rtc::AsyncPacketSocket *SocketFactory::CreateUdpSocket(const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::AsyncPacketSocket *socket = SocketFactory::CreateSocket(address, min_port, max_port);
+  
+  if (socket && !_options.emulation.IsDefault()) {
+    return new EmulatedSocket(_thread, socket, _options.emulation);
+  }
+  
+  return socket;
+}
+
+rtc::AsyncPacketSocket *SocketFactory::CreateSocket(const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port) {
+  if (_options.virtualNetwork) {
+    return VirtualNetwork::Instance()->CreateSocket(_thread, address, min_port, max_port);
+  }
+  
+  if (_options.muxPort && address.family() == AF_INET) {
+    rtc::AsyncPacketSocket *shared = UdpMux::Get(_options.muxPort)->CreateSocket(_thread, address, _options.receiveBuffer, _options.sendBuffer, this);
+    
+    if (shared) {
+      return shared;
+    }
+    
+    LOG(LS_WARNING) << "Falling back to a dedicated UDP socket";
+  }
+  
+  rtc::AsyncPacketSocket *socket = 0;
+  
+#if defined(WEBRTC_LINUX)
+  if (_options.batching) {
+    socket = BatchedUdpSocket::Create(_thread, address, min_port, max_port);
+  }
+#endif
+  
+  if (!socket) {
+    socket = rtc::BasicPacketSocketFactory::CreateUdpSocket(address, min_port, max_port);
+  }
+  
+  if (socket) {
+    if (_options.receiveBuffer > 0 && socket->SetOption(rtc::Socket::OPT_RCVBUF, _options.receiveBuffer) < 0) {
+      LOG(LS_WARNING) << "Unable to set SO_RCVBUF to " << _options.receiveBuffer;
+    }
+    
+    if (_options.sendBuffer > 0 && socket->SetOption(rtc::Socket::OPT_SNDBUF, _options.sendBuffer) < 0) {
+      LOG(LS_WARNING) << "Unable to set SO_SNDBUF to " << _options.sendBuffer;
+    }
+  }
+  
+  return socket;
+}
+
+PortAllocatorResources::PortAllocatorResources(rtc::Thread *thread, const TransportOptions &options) :
+  sockets(thread, options)
+{
+  if (options.virtualNetwork) {
+    network.reset(new VirtualNetworkManager());
+  } else {
+    rtc::BasicNetworkManager *basic = new rtc::BasicNetworkManager();
+    
+    basic->set_network_ignore_mask(options.networkIgnoreMask);
+    network.reset(basic);
+  }
+}
+
+PortAllocator::PortAllocator(rtc::Thread *worker, const TransportOptions &options) :
+  PortAllocatorResources(worker, options),
+  cricket::BasicPortAllocator(network.get(), &sockets)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (options.minPort || options.maxPort) {
+    cricket::BasicPortAllocator::SetPortRange(options.minPort, options.maxPort);
+  }
+  
+  // A lite agent on a public address only offers host candidates, and
+  // nothing but the switch is reachable from the virtual network.
+  if (options.iceLite || options.virtualNetwork) {
+    cricket::BasicPortAllocator::set_flags(cricket::BasicPortAllocator::flags() |
+                                           cricket::PORTALLOCATOR_DISABLE_STUN |
+                                           cricket::PORTALLOCATOR_DISABLE_RELAY |
+                                           cricket::PORTALLOCATOR_DISABLE_TCP);
+  }
+}
+
+PortAllocator::~PortAllocator() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+cricket::PortAllocatorSession *PortAllocator::CreateSessionInternal(const std::string &content_name,
+                                                                    int component,
+                                                                    const std::string &ice_ufrag,
+                                                                    const std::string &ice_pwd)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  // Known before any port of the session exists, so checks from the peer
+  // reach us even when they arrive before our first outgoing check.
+  sockets.AddUfrag(ice_ufrag);
+  return cricket::BasicPortAllocator::CreateSessionInternal(content_name, component, ice_ufrag, ice_pwd);
+}
+
+cricket::PortAllocator *PortAllocator::Create(rtc::Thread *worker, const TransportOptions &options) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  // Let WebRTC use its own factory wide allocator when nothing is tuned.
+  if (!worker || options.IsDefault()) {
+    return 0;
+  }
+  
+  return new PortAllocator(worker, options);
+}
@@ -0,0 +1,120 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_PORTALLOCATOR_H
+#define WEBRTC_PORTALLOCATOR_H
+
+#include "Logging.h"
+#include "EmulatedSocket.h"
+
+#include "webrtc/api/peerconnectioninterface.h"
+#include "webrtc/base/network.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/p2p/base/basicpacketsocketfactory.h"
+#include "webrtc/p2p/client/basicportallocator.h"
+
+namespace WebRTC {
+  // Transport settings that live outside webrtc::RTCConfiguration and are
+  // applied through our own port allocator.
+  struct TransportOptions {
+    TransportOptions() :
+      minPort(0),
+      maxPort(0),
+      receiveBuffer(0),
+      sendBuffer(0),
+      networkIgnoreMask(0),
+      muxPort(0),
+      batching(false),
+      iceLite(false),
+      virtualNetwork(false)
+    { }
+    
+    bool IsDefault() const {
+      return !minPort && !maxPort && !receiveBuffer && !sendBuffer && !networkIgnoreMask && !muxPort && !batching && !iceLite && !virtualNetwork && emulation.IsDefault();
+    }
+    
+    bool Equals(const TransportOptions &other) const {
+      return minPort == other.minPort && maxPort == other.maxPort && receiveBuffer == other.receiveBuffer &&
+             sendBuffer == other.sendBuffer && networkIgnoreMask == other.networkIgnoreMask && muxPort == other.muxPort &&
+             batching == other.batching && iceLite == other.iceLite && virtualNetwork == other.virtualNetwork &&
+             emulation.Equals(other.emulation);
+    }
+    
+    int minPort;
+    int maxPort;
+    int receiveBuffer;
+    int sendBuffer;
+    int networkIgnoreMask;
+    int muxPort;
+    bool batching;
+    bool iceLite;
+    bool virtualNetwork;
+    EmulationOptions emulation;
+  };
+  
+  class SocketFactory : public rtc::BasicPacketSocketFactory {
+   public:
+    SocketFactory(rtc::Thread *thread, const TransportOptions &options);
+    ~SocketFactory() override;
+    
+    rtc::AsyncPacketSocket *CreateUdpSocket(const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port) override;
+    
+    // Lets the shared port route checks for ufrag to this factory's sockets.
+    void AddUfrag(const std::string &ufrag);
+    
+   private:
+    rtc::AsyncPacketSocket *CreateSocket(const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port);
+    
+   protected:
+    rtc::Thread *_thread;
+    TransportOptions _options;
+  };
+  
+  struct PortAllocatorResources {
+    PortAllocatorResources(rtc::Thread *thread, const TransportOptions &options);
+    
+    rtc::scoped_ptr<rtc::NetworkManager> network;
+    SocketFactory sockets;
+  };
+  
+  // Owns its network manager and socket factory, so they live exactly as
+  // long as the PeerConnection that owns the allocator.
+  class PortAllocator : private PortAllocatorResources, public cricket::BasicPortAllocator {
+   public:
+    static cricket::PortAllocator *Create(rtc::Thread *worker, const TransportOptions &options);
+    
+   private:
+    PortAllocator(rtc::Thread *worker, const TransportOptions &options);
+    ~PortAllocator() override;
+    
+    cricket::PortAllocatorSession *CreateSessionInternal(const std::string &content_name,
+                                                         int component,
+                                                         const std::string &ice_ufrag,
+                                                         const std::string &ice_pwd) override;
+  };
+};
+
+#endif
@@ -0,0 +1,175 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <errno.h>
+
+#include "RoutedSocket.h"
+
+#include "webrtc/base/timeutils.h"
+
+using namespace WebRTC;
+
+struct RoutedPacket : public rtc::MessageData {
+  RoutedPacket(RoutedSocket *socket, uint64_t id, const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time) :
+    socket(socket),
+    id(id),
+    data(static_cast<const uint8_t*>(data), size),
+    address(address),
+    time(time)
+  { }
+  
+  RoutedSocket *socket;
+  uint64_t id;
+  rtc::Buffer data;
+  rtc::SocketAddress address;
+  rtc::PacketTime time;
+};
+
+RoutedSocket::RoutedSocket(rtc::Thread *thread, const rtc::SocketAddress &address) :
+  _thread(thread),
+  _address(address),
+  _id(0),
+  _closed(false),
+  _error(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+RoutedSocket::~RoutedSocket() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+rtc::SocketAddress RoutedSocket::GetLocalAddress() const {
+  return _address;
+}
+
+rtc::SocketAddress RoutedSocket::GetRemoteAddress() const {
+  return rtc::SocketAddress();
+}
+
+int RoutedSocket::Send(const void *data, size_t size, const rtc::PacketOptions &options) {
+  _error = ENOTCONN;
+  return -1;
+}
+
+int RoutedSocket::SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) {
+  if (_closed) {
+    _error = EBADF;
+    return -1;
+  }
+  
+  int sent = Transmit(data, size, address, options);
+  
+  if (sent >= 0) {
+    SignalSentPacket(this, rtc::SentPacket(options.packet_id, rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec));
+  }
+  
+  return sent;
+}
+
+int RoutedSocket::Close() {
+  if (!_closed) {
+    _closed = true;
+    Detach();
+  }
+  
+  return 0;
+}
+
+rtc::AsyncPacketSocket::State RoutedSocket::GetState() const {
+  return _closed ? rtc::AsyncPacketSocket::STATE_CLOSED : rtc::AsyncPacketSocket::STATE_BOUND;
+}
+
+int RoutedSocket::GetOption(rtc::Socket::Option option, int *value) {
+  return -1;
+}
+
+int RoutedSocket::SetOption(rtc::Socket::Option option, int value) {
+  return 0;
+}
+
+int RoutedSocket::GetError() const {
+  return _error;
+}
+
+void RoutedSocket::SetError(int error) {
+  _error = error;
+}
+
+void RoutedSocket::OnPacket(const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time) {
+  if (_closed) {
+    return;
+  }
+  
+  if (time.timestamp < 0) {
+    SignalReadPacket(this, data, size, address, rtc::PacketTime(rtc::TimeNanos() / rtc::kNumNanosecsPerMicrosec, 0));
+  } else {
+    SignalReadPacket(this, data, size, address, time);
+  }
+}
+
+SocketRouter::SocketRouter() : _nextId(0) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+SocketRouter::~SocketRouter() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+void SocketRouter::Track(RoutedSocket *socket) {
+  rtc::CritScope lock(&_lock);
+  
+  // Ids are never reused, so a packet queued for a closed socket is not
+  // delivered to a new one allocated at the same address.
+  socket->_id = ++_nextId;
+  _alive[socket] = socket->_id;
+}
+
+void SocketRouter::Untrack(RoutedSocket *socket) {
+  rtc::CritScope lock(&_lock);
+  _alive.erase(socket);
+}
+
+void SocketRouter::Post(rtc::Thread *thread, RoutedSocket *target, uint64_t id, const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time) {
+  thread->Post(this, 0, new RoutedPacket(target, id, data, size, address, time));
+}
+
+void SocketRouter::OnMessage(rtc::Message *msg) {
+  RoutedPacket *packet = static_cast<RoutedPacket*>(msg->pdata);
+  bool alive;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    std::map<RoutedSocket*, uint64_t>::iterator index = _alive.find(packet->socket);
+    alive = (index != _alive.end() && index->second == packet->id);
+  }
+  
+  // Sockets are only destroyed on their own thread, which is this one.
+  if (alive) {
+    packet->socket->OnPacket(packet->data.data<char>(), packet->data.size(), packet->address, packet->time);
+  }
+  
+  delete packet;
+}
@@ -0,0 +1,105 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_ROUTEDSOCKET_H
+#define WEBRTC_ROUTEDSOCKET_H
+
+#include <map>
+
+#include "Logging.h"
+
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/thread.h"
+
+namespace WebRTC {
+  class SocketRouter;
+  
+  // UDP socket whose packets are switched in process by a SocketRouter
+  // instead of being read from the kernel.
+  class RoutedSocket : public rtc::AsyncPacketSocket {
+    friend class SocketRouter;
+    
+   public:
+    ~RoutedSocket() override;
+    
+    rtc::SocketAddress GetLocalAddress() const override;
+    rtc::SocketAddress GetRemoteAddress() const override;
+    
+    int Send(const void *data, size_t size, const rtc::PacketOptions &options) override;
+    int SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) override;
+    int Close() override;
+    
+    State GetState() const override;
+    int GetOption(rtc::Socket::Option option, int *value) override;
+    int SetOption(rtc::Socket::Option option, int value) override;
+    int GetError() const override;
+    void SetError(int error) override;
+    
+   protected:
+    RoutedSocket(rtc::Thread *thread, const rtc::SocketAddress &address);
+    
+    // Hands the datagram to the router, returns the bytes sent or -1.
+    virtual int Transmit(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) = 0;
+    
+    // Unregisters from the router, called once by the first Close().
+    virtual void Detach() = 0;
+    
+    void OnPacket(const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time);
+    
+    rtc::Thread *_thread;
+    rtc::SocketAddress _address;
+    uint64_t _id;
+    bool _closed;
+    int _error;
+  };
+  
+  // Tracks the live RoutedSockets of a switch and delivers packets on the
+  // thread that owns the receiving socket.
+  class SocketRouter : public rtc::MessageHandler {
+   public:
+    void OnMessage(rtc::Message *msg) override;
+    
+   protected:
+    SocketRouter();
+    ~SocketRouter() override;
+    
+    void Track(RoutedSocket *socket);
+    void Untrack(RoutedSocket *socket);
+    
+    // Queues the packet for target on thread, its owning thread. Thread and
+    // id are read by the caller under _lock, target itself is only touched
+    // on delivery once the id proves it still alive. A default time is
+    // replaced with the time of delivery.
+    void Post(rtc::Thread *thread, RoutedSocket *target, uint64_t id, const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time);
+    
+    rtc::CriticalSection _lock;
+    uint64_t _nextId;
+    std::map<RoutedSocket*, uint64_t> _alive;
+  };
+};
+
+#endif
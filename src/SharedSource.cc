@@ -0,0 +1,266 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <ctype.h>
+
+#include "webrtc/base/bind.h"
+
+#include "Platform.h"
+#include "SharedSource.h"
+
+using namespace WebRTC;
+
+enum SharedSourceMessage {
+  kSharedSourceSweep,
+  kSharedSourceRestart,
+};
+
+static const int kSharedSourceSweepInterval = 5000;
+
+static rtc::CriticalSection shared_lock;
+static std::map<std::string, rtc::scoped_refptr<SharedSource> > shared_sources;
+
+// True when ptr is the only reference left. The probe takes a reference of
+// its own and hands it back through Release(), which returns what remains.
+template <class T> static bool HasOneRef(const rtc::scoped_refptr<T> &ptr) {
+  rtc::scoped_refptr<T> probe(ptr);
+  return probe.release()->Release() == 1;
+}
+
+static int GetConstraint(const rtc::scoped_refptr<MediaConstraints> &constraints, const std::string &key) {
+  std::string value;
+  int retval = 0;
+  
+  if (constraints->GetMandatory().FindFirst(key, &value) || constraints->GetOptional().FindFirst(key, &value)) {
+    rtc::FromString(value, &retval);
+  }
+  
+  return retval;
+}
+
+static cricket::VideoFormat GetRequestedFormat(const rtc::scoped_refptr<MediaConstraints> &constraints) {
+  int width = std::max(GetConstraint(constraints, webrtc::MediaConstraintsInterface::kMaxWidth),
+                       GetConstraint(constraints, webrtc::MediaConstraintsInterface::kMinWidth));
+  int height = std::max(GetConstraint(constraints, webrtc::MediaConstraintsInterface::kMaxHeight),
+                        GetConstraint(constraints, webrtc::MediaConstraintsInterface::kMinHeight));
+  int fps = std::max(GetConstraint(constraints, webrtc::MediaConstraintsInterface::kMaxFrameRate),
+                     GetConstraint(constraints, webrtc::MediaConstraintsInterface::kMinFrameRate));
+  
+  return cricket::VideoFormat(width, height, fps > 0 ? cricket::VideoFormat::FpsToInterval(fps) : 0, cricket::FOURCC_ANY);
+}
+
+rtc::scoped_refptr<webrtc::VideoTrackInterface> SharedSource::CreateTrack(const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory,
+                                                                         rtc::Thread *worker,
+                                                                         const SourceInfo &device,
+                                                                         const rtc::scoped_refptr<MediaConstraints> &constraints)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&shared_lock);
+  std::map<std::string, rtc::scoped_refptr<SharedSource> >::iterator index = shared_sources.find(device.id);
+  rtc::scoped_refptr<SharedSource> source;
+  
+  if (index != shared_sources.end()) {
+    source = index->second;
+  } else {
+    source = new rtc::RefCountedObject<SharedSource>(device.id, worker);
+    
+    if (!source->Open(factory, device.label, constraints)) {
+      return NULL;
+    }
+    
+    shared_sources[device.id] = source;
+    Platform::GetDeviceWorker()->PostDelayed(kSharedSourceSweepInterval, source.get(), kSharedSourceSweep);
+  }
+  
+  return source->AddTrack(factory, constraints);
+}
+
+SharedSource::SharedSource(const std::string &id, rtc::Thread *worker) : _id(id), _worker(worker) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+SharedSource::~SharedSource() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _worker->Clear(this);
+}
+
+bool SharedSource::Open(const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory, const std::string &label, const rtc::scoped_refptr<MediaConstraints> &constraints) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  cricket::WebRtcVideoDeviceCapturerFactory device_factory;
+  cricket::VideoCapturer *capturer = device_factory.Create(cricket::Device(label, 0));
+  
+  if (!capturer) {
+    return false;
+  }
+  
+  _name = label;
+  
+  for (size_t i = 0; i < _name.size(); i++) {
+    if (_name[i] == ' ') _name[i] = '_';
+    _name[i] = tolower(_name[i]);
+  }
+  
+  // The source owns the capturer from here on.
+  _source = factory->CreateVideoSource(capturer, constraints->ToConstraints());
+  
+  if (!_source.get()) {
+    return false;
+  }
+  
+  const cricket::VideoFormat *format = capturer->GetCaptureFormat();
+  
+  if (format) {
+    _format = *format;
+    _default = *format;
+  }
+  
+  return true;
+}
+
+rtc::scoped_refptr<webrtc::VideoTrackInterface> SharedSource::AddTrack(const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory, const rtc::scoped_refptr<MediaConstraints> &constraints) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Sink sink;
+  
+  sink.track = factory->CreateVideoTrack(_name, _source);
+  sink.format = GetRequestedFormat(constraints);
+  
+  if (sink.track.get()) {
+    sink.track->RegisterObserver(this);
+    _sinks.push_back(sink);
+    
+    SharedSource::Reconfigure();
+  }
+  
+  return sink.track;
+}
+
+bool SharedSource::Sweep() {
+  std::vector<Sink>::iterator index = _sinks.begin();
+  
+  while (index != _sinks.end()) {
+    // Tracks that have ended, or that nobody but us references anymore, no longer need frames.
+    if (index->track->state() == webrtc::MediaStreamTrackInterface::kEnded || HasOneRef(index->track)) {
+      index->track->UnregisterObserver(this);
+      index = _sinks.erase(index);
+    } else {
+      index++;
+    }
+  }
+  
+  return !_sinks.empty();
+}
+
+void SharedSource::Reconfigure() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  cricket::VideoFormat desired(0, 0, 0, _default.fourcc);
+  std::vector<Sink>::iterator index;
+  
+  // Capture at the largest size and highest rate any remaining sink asks
+  // for, sinks asking for less are scaled down.
+  for (index = _sinks.begin(); index != _sinks.end(); index++) {
+    desired.width = std::max(desired.width, index->format.width);
+    desired.height = std::max(desired.height, index->format.height);
+    
+    if (index->format.interval && (!desired.interval || index->format.interval < desired.interval)) {
+      desired.interval = index->format.interval;
+    }
+  }
+  
+  if (!desired.width || !desired.height) {
+    desired.width = _default.width;
+    desired.height = _default.height;
+  }
+  
+  if (!desired.interval) {
+    desired.interval = _default.interval;
+  }
+  
+  cricket::VideoCapturer *capturer = _source->GetVideoCapturer();
+  cricket::VideoFormat best;
+  
+  if (!capturer || !capturer->GetBestCaptureFormat(desired, &best) || best == _format) {
+    return;
+  }
+  
+  LOG(LS_INFO) << "Changing capture format to " << best.ToString();
+  
+  _format = best;
+  
+  // The capturer runs on the worker thread of the factory that opened it,
+  // restart it there without waiting and without holding shared_lock.
+  _worker->Clear(this, kSharedSourceRestart);
+  _worker->Post(this, kSharedSourceRestart, new rtc::TypedMessageData<cricket::VideoFormat>(best));
+}
+
+void SharedSource::OnChanged() {
+  Platform::GetDeviceWorker()->Post(this, kSharedSourceSweep);
+}
+
+void SharedSource::OnMessage(rtc::Message *msg) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<SharedSource> self(this);
+  
+  if (msg->message_id == kSharedSourceRestart) {
+    rtc::scoped_ptr<rtc::TypedMessageData<cricket::VideoFormat> > data(static_cast<rtc::TypedMessageData<cricket::VideoFormat>*>(msg->pdata));
+    cricket::VideoCapturer *capturer = _source->GetVideoCapturer();
+    
+    // VideoTrackSource has no call to change its format, the capturer it
+    // owns is restarted in place so the source and its sinks stay attached.
+    if (capturer && capturer->IsRunning()) {
+      capturer->Stop();
+      capturer->StartCapturing(data->data());
+    }
+    
+    return;
+  }
+  
+  rtc::CritScope lock(&shared_lock);
+  
+  std::map<std::string, rtc::scoped_refptr<SharedSource> >::iterator index = shared_sources.find(_id);
+  
+  if (index == shared_sources.end() || index->second.get() != this) {
+    return;
+  }
+  
+  if (SharedSource::Sweep()) {
+    SharedSource::Reconfigure();
+    Platform::GetDeviceWorker()->Clear(this, kSharedSourceSweep);
+    Platform::GetDeviceWorker()->PostDelayed(kSharedSourceSweepInterval, this, kSharedSourceSweep);
+    return;
+  }
+  
+  LOG(LS_INFO) << "Last track ended, closing device " << _id;
+  
+  Platform::GetDeviceWorker()->Clear(this);
+  _worker->Clear(this);
+  _source->Stop();
+  shared_sources.erase(index);
+}
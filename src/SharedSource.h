@@ -0,0 +1,77 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_SHAREDSOURCE_H
+#define WEBRTC_SHAREDSOURCE_H
+
+#include <map>
+
+#include "Common.h"
+#include "GetSources.h"
+#include "MediaConstraints.h"
+
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/messagehandler.h"
+
+namespace WebRTC {
+  class SharedSource : public webrtc::ObserverInterface, public rtc::MessageHandler, public rtc::RefCountInterface {
+    friend class rtc::RefCountedObject<SharedSource>;
+    
+   public:
+    static rtc::scoped_refptr<webrtc::VideoTrackInterface> CreateTrack(const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory,
+                                                                        rtc::Thread *worker,
+                                                                        const SourceInfo &device,
+                                                                        const rtc::scoped_refptr<MediaConstraints> &constraints);
+    
+    void OnChanged() final;
+    void OnMessage(rtc::Message *msg) final;
+    
+   private:
+    SharedSource(const std::string &id, rtc::Thread *worker);
+    ~SharedSource() override;
+    
+    bool Open(const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory, const std::string &label, const rtc::scoped_refptr<MediaConstraints> &constraints);
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> AddTrack(const rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> &factory, const rtc::scoped_refptr<MediaConstraints> &constraints);
+    
+    bool Sweep();
+    void Reconfigure();
+    
+   protected:
+    struct Sink {
+      rtc::scoped_refptr<webrtc::VideoTrackInterface> track;
+      cricket::VideoFormat format;
+    };
+    
+    std::string _id;
+    std::string _name;
+    rtc::Thread *_worker;
+    rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> _source;
+    std::vector<Sink> _sinks;
+    cricket::VideoFormat _format;
+    cricket::VideoFormat _default;
+  };
+};
+
+#endif
@@ -0,0 +1,170 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include "ThreadMonitor.h"
+
+#include "webrtc/base/timeutils.h"
+
+using namespace WebRTC;
+
+MonitoredThread::MonitoredThread() :
+  _running(false),
+  _cpuClock(false),
+  _handled(0),
+  _busy(0),
+  _maxLatency(0),
+  _peers(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+MonitoredThread::~MonitoredThread() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  // Must stop before this subclass goes away, rtc::Thread::~Thread is too late.
+  MonitoredThread::Stop();
+}
+
+void MonitoredThread::Run() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  {
+    rtc::CritScope lock(&_crit);
+    
+    // The CPU clock can only be looked up from the thread itself, reading
+    // it afterwards works from any thread.
+#if defined(WEBRTC_POSIX)
+    _self = pthread_self();
+#endif
+
+#if defined(WEBRTC_MAC)
+    _thread = pthread_mach_thread_np(_self);
+    _cpuClock = true;
+#elif defined(WEBRTC_POSIX)
+    _cpuClock = (pthread_getcpuclockid(_self, &_clock) == 0);
+#endif
+    
+    _running = true;
+  }
+  
+  rtc::Thread::Run();
+  
+  rtc::CritScope lock(&_crit);
+  
+  _running = false;
+  _cpuClock = false;
+}
+
+void MonitoredThread::Dispatch(rtc::Message *msg) {
+  int64_t started = rtc::TimeNanos();
+  
+  rtc::Thread::Dispatch(msg);
+  
+  int64_t elapsed = rtc::TimeNanos() - started;
+  rtc::CritScope lock(&_crit);
+  
+  _handled++;
+  _busy += elapsed;
+  
+  if (elapsed > _maxLatency) {
+    _maxLatency = elapsed;
+  }
+}
+
+void MonitoredThread::AddPeer() {
+  rtc::AtomicOps::Increment(&_peers);
+}
+
+void MonitoredThread::RemovePeer() {
+  rtc::AtomicOps::Decrement(&_peers);
+}
+
+double MonitoredThread::GetCpuTime() {
+  if (!_cpuClock) {
+    return -1;
+  }
+  
+#if defined(WEBRTC_MAC)
+  thread_basic_info_data_t info;
+  mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+  
+  if (thread_info(_thread, THREAD_BASIC_INFO, reinterpret_cast<thread_info_t>(&info), &count) == KERN_SUCCESS) {
+    return (info.user_time.seconds + info.system_time.seconds) * 1000.0 +
+           (info.user_time.microseconds + info.system_time.microseconds) / 1000.0;
+  }
+#elif defined(WEBRTC_POSIX)
+  struct timespec ts;
+  
+  if (clock_gettime(_clock, &ts) == 0) {
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+  }
+#endif
+  
+  return -1;
+}
+
+void MonitoredThread::GetMetrics(ThreadMetrics *metrics, bool reset) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  metrics->name = name();
+  metrics->pending = size();
+  metrics->peers = rtc::AtomicOps::AcquireLoad(&_peers);
+  
+  rtc::CritScope lock(&_crit);
+  
+  metrics->cpu = MonitoredThread::GetCpuTime();
+  metrics->handled = _handled;
+  metrics->busy = _busy;
+  metrics->maxLatency = _maxLatency;
+  
+  if (reset) {
+    _handled = 0;
+    _busy = 0;
+    _maxLatency = 0;
+  }
+}
+
+bool MonitoredThread::CaptureStack(std::vector<std::string> *stack) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+#if defined(USE_BACKTRACE)
+  pthread_t self;
+  
+  {
+    rtc::CritScope lock(&_crit);
+    
+    if (!_running) {
+      return false;
+    }
+    
+    self = _self;
+  }
+  
+  // Not signaled under the lock, Dispatch() on the captured thread takes it
+  // after every message and would stall for the whole capture timeout.
+  return BackTrace::Capture(self, stack);
+#endif
+  
+  return false;
+}
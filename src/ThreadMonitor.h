@@ -0,0 +1,102 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_THREADMONITOR_H
+#define WEBRTC_THREADMONITOR_H
+
+#include <string>
+#include <vector>
+
+#include "Common.h"
+#include "BackTrace.h"
+
+#include "webrtc/base/criticalsection.h"
+
+#if defined(WEBRTC_POSIX)
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#if defined(WEBRTC_MAC)
+#include <mach/mach.h>
+#endif
+
+namespace WebRTC {
+  struct ThreadMetrics {
+    ThreadMetrics() : cpu(-1), pending(0), handled(0), busy(0), maxLatency(0), peers(0) { }
+    
+    std::string name;
+    double cpu;          // Thread CPU time in milliseconds, -1 when unknown.
+    size_t pending;      // Messages waiting in the queue, delayed included.
+    uint64_t handled;    // Messages dispatched since the last reset.
+    int64_t busy;        // Nanoseconds spent in those messages.
+    int64_t maxLatency;  // Longest single message in nanoseconds.
+    int peers;           // PeerConnections assigned to the thread.
+  };
+  
+  // rtc::Thread that times every posted message it dispatches. Synchronous
+  // Invoke() calls bypass Dispatch() and are only visible in cpu.
+  class MonitoredThread : public rtc::Thread {
+   public:
+    MonitoredThread();
+    ~MonitoredThread() override;
+    
+    void Run() override;
+    
+    void AddPeer();
+    void RemovePeer();
+    
+    void GetMetrics(ThreadMetrics *metrics, bool reset = false);
+    
+    // Stack of the thread wherever it is right now, false when stack
+    // capture is not supported or the thread did not answer.
+    bool CaptureStack(std::vector<std::string> *stack);
+    
+   protected:
+    void Dispatch(rtc::Message *msg) override;
+    
+    double GetCpuTime();
+    
+    rtc::CriticalSection _crit;
+    bool _running;
+    bool _cpuClock;
+    
+#if defined(WEBRTC_POSIX)
+    pthread_t _self;
+#endif
+    
+#if defined(WEBRTC_MAC)
+    mach_port_t _thread;
+#elif defined(WEBRTC_POSIX)
+    clockid_t _clock;
+#endif
+    
+    uint64_t _handled;
+    int64_t _busy;
+    int64_t _maxLatency;
+    volatile int _peers;
+  };
+};
+
+#endif
@@ -0,0 +1,443 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <errno.h>
+#include <string.h>
+
+#include "UdpMux.h"
+#include "BatchedSocket.h"
+
+#include "webrtc/base/timeutils.h"
+
+#if defined(WEBRTC_LINUX)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
+
+using namespace WebRTC;
+
+#define kStunHeaderSize 20
+#define kStunAttributeUsername 0x0006
+#define kStunTransactionLimit 65536
+
+enum StunClass {
+  kStunNone,
+  kStunRequest,
+  kStunIndication,
+  kStunResponse,
+};
+
+static inline uint16_t ReadUInt16(const char *data) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+  return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+}
+
+// Reads just enough of a STUN message to route it: the class, the
+// transaction id and the USERNAME attribute when present.
+static StunClass ParseStun(const char *data, size_t size, std::string *transaction, std::string *username) {
+  static const uint8_t cookie[4] = { 0x21, 0x12, 0xA4, 0x42 };
+  
+  if (size < kStunHeaderSize || (data[0] & 0xC0) || memcmp(data + 4, cookie, 4)) {
+    return kStunNone;
+  }
+  
+  size_t length = ReadUInt16(data + 2);
+  
+  if (length + kStunHeaderSize > size) {
+    return kStunNone;
+  }
+  
+  transaction->assign(data + 8, 12);
+  
+  for (size_t offset = kStunHeaderSize; offset + 4 <= length + kStunHeaderSize;) {
+    uint16_t type = ReadUInt16(data + offset);
+    size_t attribute = ReadUInt16(data + offset + 2);
+    
+    if (offset + 4 + attribute > length + kStunHeaderSize) {
+      break;
+    }
+    
+    if (type == kStunAttributeUsername) {
+      username->assign(data + offset + 4, attribute);
+      break;
+    }
+    
+    offset += 4 + ((attribute + 3) & ~3);
+  }
+  
+  switch (ReadUInt16(data) & 0x0110) {
+    case 0x0000:
+      return kStunRequest;
+    case 0x0010:
+      return kStunIndication;
+    default:
+      return kStunResponse;
+  }
+}
+
+UdpMuxSocket::UdpMuxSocket(UdpMux *mux, rtc::Thread *thread, const rtc::SocketAddress &address, const void *owner) :
+  RoutedSocket(thread, address),
+  _mux(mux),
+  _owner(owner)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+UdpMuxSocket::~UdpMuxSocket() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  UdpMuxSocket::Close();
+}
+
+int UdpMuxSocket::SetOption(rtc::Socket::Option option, int value) {
+  // Options would apply to every session on the port, they are set once
+  // when the shared socket is created.
+  return 0;
+}
+
+int UdpMuxSocket::Transmit(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) {
+  return _mux->SendTo(this, data, size, address, options);
+}
+
+void UdpMuxSocket::Detach() {
+  _mux->Remove(this);
+}
+
+UdpMuxListener::UdpMuxListener(UdpMux *mux, rtc::AsyncPacketSocket *socket) :
+  references(0),
+  _mux(mux),
+  _socket(socket)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _socket->SignalReadPacket.connect(this, &UdpMuxListener::OnReadPacket);
+}
+
+UdpMuxListener::~UdpMuxListener() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  delete _socket;
+}
+
+UdpMuxListener *UdpMuxListener::Create(UdpMux *mux, rtc::Thread *thread, int port, int receiveBuffer, int sendBuffer) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+#if defined(WEBRTC_LINUX)
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int enable = 1;
+  
+  if (fd < 0) {
+    return 0;
+  }
+  
+  struct sockaddr_in address;
+  
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0 ||
+      bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0)
+  {
+    LOG(LS_ERROR) << "Unable to bind shared UDP port " << port;
+    close(fd);
+    return 0;
+  }
+  
+  if (receiveBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+  }
+  
+  if (sendBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+  }
+  
+  // The shared port carries every session on this worker, read and write it in batches.
+  return new UdpMuxListener(mux, BatchedUdpSocket::Wrap(thread, fd));
+#else
+  LOG(LS_WARNING) << "Shared UDP port is only supported on Linux";
+  return 0;
+#endif
+}
+
+int UdpMuxListener::SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) {
+  return _socket->SendTo(data, size, address, options);
+}
+
+int UdpMuxListener::GetError() const {
+  return _socket->GetError();
+}
+
+void UdpMuxListener::OnReadPacket(rtc::AsyncPacketSocket *socket, const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time) {
+  _mux->Route(data, size, address, time);
+}
+
+UdpMux::UdpMux(int port) : _port(port) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+UdpMux::~UdpMux() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+UdpMux *UdpMux::Get(int port) {
+  static rtc::CriticalSection lock;
+  static std::map<int, UdpMux*> muxes;
+  
+  rtc::CritScope scope(&lock);
+  std::map<int, UdpMux*>::iterator index = muxes.find(port);
+  
+  if (index != muxes.end()) {
+    return index->second;
+  }
+  
+  UdpMux *mux = new UdpMux(port);
+  muxes[port] = mux;
+  
+  return mux;
+}
+
+rtc::AsyncPacketSocket *UdpMux::CreateSocket(rtc::Thread *thread, const rtc::SocketAddress &address, int receiveBuffer, int sendBuffer, const void *owner) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  std::map<rtc::Thread*, UdpMuxListener*>::iterator index = _listeners.find(thread);
+  UdpMuxListener *listener = 0;
+  
+  if (index != _listeners.end()) {
+    listener = index->second;
+  } else {
+    listener = UdpMuxListener::Create(this, thread, _port, receiveBuffer, sendBuffer);
+    
+    if (!listener) {
+      return 0;
+    }
+    
+    _listeners[thread] = listener;
+  }
+  
+  UdpMuxSocket *socket = new UdpMuxSocket(this, thread, rtc::SocketAddress(address.ipaddr(), _port), owner);
+  
+  listener->references++;
+  SocketRouter::Track(socket);
+  
+  return socket;
+}
+
+void UdpMux::AddUfrag(const void *owner, const std::string &ufrag) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  _owners[ufrag] = owner;
+}
+
+void UdpMux::RemoveOwner(const void *owner) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  std::map<std::string, const void*>::iterator index = _owners.begin();
+  
+  while (index != _owners.end()) {
+    if (index->second == owner) {
+      _owners.erase(index++);
+    } else {
+      index++;
+    }
+  }
+}
+
+UdpMuxSocket *UdpMux::FindOwner(const std::string &ufrag) {
+  std::map<std::string, const void*>::iterator owner = _owners.find(ufrag);
+  
+  if (owner == _owners.end()) {
+    return 0;
+  }
+  
+  std::map<RoutedSocket*, uint64_t>::iterator index;
+  
+  // Only UdpMuxSockets are tracked by this router.
+  for (index = _alive.begin(); index != _alive.end(); index++) {
+    UdpMuxSocket *socket = static_cast<UdpMuxSocket*>(index->first);
+    
+    if (socket->_owner == owner->second) {
+      return socket;
+    }
+  }
+  
+  return 0;
+}
+
+int UdpMux::SendTo(UdpMuxSocket *socket, const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) {
+  std::string transaction, username;
+  StunClass type = ParseStun(static_cast<const char*>(data), size, &transaction, &username);
+  UdpMuxListener *listener = 0;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    // Outgoing checks carry "remote:local", remember our half so the peer's
+    // checks find their way back.
+    if (type == kStunRequest) {
+      if (_transactions.size() >= kStunTransactionLimit) {
+        _transactions.clear();
+      }
+      
+      _transactions[transaction] = socket;
+      
+      size_t colon = username.find(':');
+      
+      if (colon != std::string::npos) {
+        _ufrags[username.substr(colon + 1)] = socket;
+      }
+    }
+    
+    std::map<rtc::Thread*, UdpMuxListener*>::iterator index = _listeners.find(socket->_thread);
+    
+    if (index != _listeners.end()) {
+      listener = index->second;
+    }
+  }
+  
+  if (!listener) {
+    socket->SetError(EBADF);
+    return -1;
+  }
+  
+  int sent = listener->SendTo(data, size, address, options);
+  
+  if (sent < 0) {
+    socket->SetError(listener->GetError());
+  }
+  
+  return sent;
+}
+
+void UdpMux::Route(const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time) {
+  std::string transaction, username;
+  StunClass type = ParseStun(data, size, &transaction, &username);
+  UdpMuxSocket *target = 0;
+  rtc::Thread *thread = 0;
+  uint64_t id = 0;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    // Remote addresses are only bound by checks that prove who they talk
+    // to, a request carrying our ufrag or the response to our request.
+    if ((type == kStunRequest || type == kStunIndication) && !username.empty()) {
+      std::string ufrag = username.substr(0, username.find(':'));
+      std::map<std::string, UdpMuxSocket*>::iterator index = _ufrags.find(ufrag);
+      
+      if (index != _ufrags.end()) {
+        target = index->second;
+      } else if ((target = UdpMux::FindOwner(ufrag))) {
+        _ufrags[ufrag] = target;
+      }
+      
+      if (target) {
+        _remotes[address] = target;
+      }
+    } else if (type == kStunResponse) {
+      std::map<std::string, UdpMuxSocket*>::iterator index = _transactions.find(transaction);
+      
+      if (index != _transactions.end()) {
+        target = index->second;
+        _remotes[address] = target;
+        _transactions.erase(index);
+      }
+    }
+    
+    if (!target) {
+      std::map<rtc::SocketAddress, UdpMuxSocket*>::iterator index = _remotes.find(address);
+      
+      if (index != _remotes.end()) {
+        target = index->second;
+      }
+    }
+    
+    // The socket may be closed on its own thread as soon as the lock is
+    // released, only these copies are used afterwards.
+    if (target) {
+      thread = target->_thread;
+      id = target->_id;
+    }
+  }
+  
+  if (!target) {
+    LOG(LS_VERBOSE) << "Dropping packet from unknown source " << address.ToString();
+    return;
+  }
+  
+  // Sockets are destroyed on their own thread, so one owned by this thread
+  // is still alive here.
+  if (thread->IsCurrent()) {
+    target->OnPacket(data, size, address, time);
+  } else {
+    SocketRouter::Post(thread, target, id, data, size, address, time);
+  }
+}
+
+template <class K> static void EraseSocket(std::map<K, UdpMuxSocket*> *entries, UdpMuxSocket *socket) {
+  typename std::map<K, UdpMuxSocket*>::iterator index = entries->begin();
+  
+  while (index != entries->end()) {
+    if (index->second == socket) {
+      entries->erase(index++);
+    } else {
+      index++;
+    }
+  }
+}
+
+void UdpMux::Remove(UdpMuxSocket *socket) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  UdpMuxListener *listener = 0;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    SocketRouter::Untrack(socket);
+    
+    EraseSocket(&_ufrags, socket);
+    EraseSocket(&_transactions, socket);
+    EraseSocket(&_remotes, socket);
+    
+    std::map<rtc::Thread*, UdpMuxListener*>::iterator index = _listeners.find(socket->_thread);
+    
+    if (index != _listeners.end() && !--index->second->references) {
+      listener = index->second;
+      _listeners.erase(index);
+    }
+  }
+  
+  // Last session on this worker, close its shared socket.
+  delete listener;
+}
@@ -0,0 +1,118 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_UDPMUX_H
+#define WEBRTC_UDPMUX_H
+
+#include <map>
+#include <string>
+
+#include "Logging.h"
+#include "RoutedSocket.h"
+
+#include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/sigslot.h"
+
+namespace WebRTC {
+  class UdpMux;
+  
+  // One ICE session on the shared port. Behaves like a bound UDP socket for
+  // the UDPPort that owns it.
+  class UdpMuxSocket : public RoutedSocket {
+    friend class UdpMux;
+    
+   public:
+    ~UdpMuxSocket() override;
+    
+    int SetOption(rtc::Socket::Option option, int value) override;
+    
+   private:
+    UdpMuxSocket(UdpMux *mux, rtc::Thread *thread, const rtc::SocketAddress &address, const void *owner);
+    
+    int Transmit(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) override;
+    void Detach() override;
+    
+   protected:
+    UdpMux *_mux;
+    const void *_owner;
+  };
+  
+  class UdpMuxListener : public sigslot::has_slots<> {
+   public:
+    static UdpMuxListener *Create(UdpMux *mux, rtc::Thread *thread, int port, int receiveBuffer, int sendBuffer);
+    ~UdpMuxListener() override;
+    
+    int SendTo(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options);
+    int GetError() const;
+    
+    int references;
+    
+   private:
+    UdpMuxListener(UdpMux *mux, rtc::AsyncPacketSocket *socket);
+    
+    void OnReadPacket(rtc::AsyncPacketSocket *socket, const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time);
+    
+   protected:
+    UdpMux *_mux;
+    rtc::AsyncPacketSocket *_socket;
+  };
+  
+  // Shares one UDP port between every ICE session in the process. Each worker
+  // thread reads from its own SO_REUSEPORT socket; packets are routed by STUN
+  // USERNAME, STUN transaction id or remote address to the owning session and
+  // handed to its worker thread when the kernel picked another one.
+  class UdpMux : public SocketRouter {
+   public:
+    static UdpMux *Get(int port);
+    
+    // Sockets created with the same owner belong to one PeerConnection, the
+    // ufrags registered for it route checks that arrive before our own.
+    rtc::AsyncPacketSocket *CreateSocket(rtc::Thread *thread, const rtc::SocketAddress &address, int receiveBuffer, int sendBuffer, const void *owner);
+    void AddUfrag(const void *owner, const std::string &ufrag);
+    void RemoveOwner(const void *owner);
+    
+   private:
+    explicit UdpMux(int port);
+    ~UdpMux() override;
+    
+    friend class UdpMuxSocket;
+    friend class UdpMuxListener;
+    
+    int SendTo(UdpMuxSocket *socket, const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options);
+    void Route(const char *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketTime &time);
+    void Remove(UdpMuxSocket *socket);
+    UdpMuxSocket *FindOwner(const std::string &ufrag);
+    
+   protected:
+    int _port;
+    std::map<std::string, const void*> _owners;
+    std::map<rtc::Thread*, UdpMuxListener*> _listeners;
+    std::map<std::string, UdpMuxSocket*> _ufrags;
+    std::map<std::string, UdpMuxSocket*> _transactions;
+    std::map<rtc::SocketAddress, UdpMuxSocket*> _remotes;
+  };
+};
+
+#endif
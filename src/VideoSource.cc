@@ -0,0 +1,360 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <string.h>
+#include <node_buffer.h>
+
+#include "libyuv/convert.h"
+#include "webrtc/base/timeutils.h"
+
+#include "Platform.h"
+#include "VideoSource.h"
+#include "MediaStream.h"
+#include "MediaStreamTrack.h"
+#include "MediaConstraints.h"
+#include "ArrayBuffer.h"
+
+using namespace v8;
+using namespace WebRTC;
+
+FramePool::FramePool(size_t limit) : _limit(limit) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+FramePool::~FramePool() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  std::vector<rtc::Buffer*>::iterator index;
+  
+  for (index = _free.begin(); index != _free.end(); index++) {
+    delete (*index);
+  }
+  
+  _free.clear();
+}
+
+rtc::Buffer *FramePool::Acquire(size_t size) {
+  rtc::Buffer *buffer = 0;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    if (!_free.empty()) {
+      buffer = _free.back();
+      _free.pop_back();
+    }
+  }
+  
+  if (!buffer) {
+    buffer = new rtc::Buffer();
+  }
+  
+  buffer->SetSize(size);
+  return buffer;
+}
+
+void FramePool::Release(rtc::Buffer *buffer) {
+  if (!buffer) {
+    return;
+  }
+  
+  {
+    rtc::CritScope lock(&_lock);
+    
+    if (_free.size() < _limit) {
+      _free.push_back(buffer);
+      return;
+    }
+  }
+  
+  delete buffer;
+}
+
+FrameCapturer::FrameCapturer(int width, int height, int fps) : _running(false) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  std::vector<cricket::VideoFormat> formats;
+  
+  formats.push_back(cricket::VideoFormat(width, height, cricket::VideoFormat::FpsToInterval(fps), cricket::FOURCC_I420));
+  SetSupportedFormats(formats);
+}
+
+FrameCapturer::~FrameCapturer() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  FrameCapturer::Stop();
+}
+
+bool FrameCapturer::PushFrame(const uint8_t *data, size_t size, int width, int height, uint32_t fourcc) {
+  if (!_running || !data || width <= 0 || height <= 0) {
+    return false;
+  }
+  
+  size_t chroma = static_cast<size_t>((width + 1) / 2) * static_cast<size_t>((height + 1) / 2);
+  size_t length = static_cast<size_t>(width) * height + chroma * 2;
+  rtc::Buffer *buffer = 0;
+  cricket::CapturedFrame frame;
+  
+  if (fourcc == cricket::FOURCC_I420) {
+    if (size < length) {
+      return false;
+    }
+    
+    frame.data = const_cast<uint8_t*>(data);
+  } else if (fourcc == cricket::FOURCC_ABGR) {
+    if (size < static_cast<size_t>(width) * height * 4) {
+      return false;
+    }
+    
+    buffer = _pool.Acquire(length);
+    
+    uint8_t *y = buffer->data();
+    uint8_t *u = y + static_cast<size_t>(width) * height;
+    uint8_t *v = u + chroma;
+    int stride = (width + 1) / 2;
+    
+    // libyuv names formats by little endian word order, RGBA bytes are "ABGR".
+    libyuv::ABGRToI420(data, width * 4, y, width, u, stride, v, stride, width, height);
+    frame.data = buffer->data();
+  } else {
+    return false;
+  }
+  
+  frame.width = width;
+  frame.height = height;
+  frame.fourcc = cricket::FOURCC_I420;
+  frame.data_size = static_cast<uint32_t>(length);
+  frame.time_stamp = rtc::TimeNanos();
+  
+  SignalFrameCaptured(this, &frame);
+  
+  _pool.Release(buffer);
+  return true;
+}
+
+cricket::CaptureState FrameCapturer::Start(const cricket::VideoFormat &format) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  SetCaptureFormat(&format);
+  _running = true;
+  SetCaptureState(cricket::CS_RUNNING);
+  
+  return cricket::CS_RUNNING;
+}
+
+void FrameCapturer::Stop() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (_running) {
+    _running = false;
+    SetCaptureFormat(NULL);
+    SetCaptureState(cricket::CS_STOPPED);
+  }
+}
+
+bool FrameCapturer::IsRunning() {
+  return _running;
+}
+
+bool FrameCapturer::IsScreencast() const {
+  return false;
+}
+
+bool FrameCapturer::GetPreferredFourccs(std::vector<uint32_t> *fourccs) {
+  if (!fourccs) {
+    return false;
+  }
+  
+  fourccs->push_back(cricket::FOURCC_I420);
+  return true;
+}
+
+Nan::Persistent<Function> VideoSource::constructor;
+
+void VideoSource::Init(Handle<Object> exports) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::HandleScope scope;
+  
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(VideoSource::New);
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+  tpl->SetClassName(Nan::New("RTCVideoSource").ToLocalChecked());
+  
+  Nan::SetPrototypeMethod(tpl, "pushFrame", VideoSource::PushFrame);
+  Nan::SetPrototypeMethod(tpl, "stop", VideoSource::Stop);
+  
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("track").ToLocalChecked(), VideoSource::GetTrack);
+  Nan::SetAccessor(tpl->InstanceTemplate(), Nan::New("stream").ToLocalChecked(), VideoSource::GetStream);
+  
+  constructor.Reset<Function>(tpl->GetFunction());
+  exports->Set(Nan::New("RTCVideoSource").ToLocalChecked(), tpl->GetFunction());
+}
+
+VideoSource::VideoSource(int width, int height, int fps) : _capturer(0) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory = Platform::CreateFactory();
+  rtc::scoped_refptr<MediaConstraints> constraints = MediaConstraints::New();
+  
+  if (factory.get()) {
+    // The source takes ownership of the capturer and keeps it alive with the track.
+    _capturer = new FrameCapturer(width, height, fps);
+    _source = factory->CreateVideoSource(_capturer, constraints->ToConstraints());
+    
+    if (_source.get()) {
+      _track = factory->CreateVideoTrack("video", _source);
+      _stream = factory->CreateLocalMediaStream("stream");
+      
+      if (_stream.get() && _track.get()) {
+        _stream->AddTrack(_track);
+      }
+    }
+  }
+}
+
+VideoSource::~VideoSource() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (_source.get()) {
+    _source->Stop();
+  }
+}
+
+void VideoSource::New(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  int width = 640;
+  int height = 480;
+  int fps = 30;
+  
+  if (info.Length() >= 1 && info[0]->IsObject()) {
+    Local<Object> options = Local<Object>::Cast(info[0]);
+    Local<Value> width_value = options->Get(Nan::New("width").ToLocalChecked());
+    Local<Value> height_value = options->Get(Nan::New("height").ToLocalChecked());
+    Local<Value> fps_value = options->Get(Nan::New("frameRate").ToLocalChecked());
+    
+    if (!width_value.IsEmpty() && width_value->IsInt32()) {
+      width = width_value->Int32Value();
+    }
+    
+    if (!height_value.IsEmpty() && height_value->IsInt32()) {
+      height = height_value->Int32Value();
+    }
+    
+    if (!fps_value.IsEmpty() && fps_value->IsInt32()) {
+      fps = fps_value->Int32Value();
+    }
+  }
+  
+  if (info.IsConstructCall()) {
+    VideoSource *source = new VideoSource(width, height, fps);
+    source->Wrap(info.This(), "VideoSource");
+    
+    if (!source->_track.get()) {
+      Nan::ThrowError("Internal Source Error");
+    }
+    
+    return info.GetReturnValue().Set(info.This());
+  } else {
+    const int argc = 1;
+    Local<Value> argv[argc] = { info[0] };
+    Local<Function> instance = Nan::New(VideoSource::constructor);
+    return info.GetReturnValue().Set(instance->NewInstance(argc, argv));
+  }
+}
+
+void VideoSource::PushFrame(const Nan::FunctionCallbackInfo<Value> &info) {
+  VideoSource *self = RTCWrap::Unwrap<VideoSource>(info.This(), "VideoSource");
+  uint32_t fourcc = cricket::FOURCC_I420;
+  bool retval = false;
+  
+  if (info.Length() < 3 || !info[0]->IsInt32() || !info[1]->IsInt32()) {
+    Nan::ThrowError("Invalid Arguments");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  if (!node::Buffer::HasInstance(info[2]) && !info[2]->IsArrayBuffer()) {
+    Nan::ThrowTypeError("Frame must be a Buffer or an ArrayBuffer");
+    return info.GetReturnValue().SetUndefined();
+  }
+  
+  if (info.Length() >= 4 && info[3]->IsString()) {
+    Nan::Utf8String format(info[3]);
+    
+    if (!strcmp(*format, "rgba")) {
+      fourcc = cricket::FOURCC_ABGR;
+    } else if (strcmp(*format, "i420")) {
+      Nan::ThrowError("Unsupported Frame Format");
+      return info.GetReturnValue().SetUndefined();
+    }
+  }
+  
+  if (self->_capturer && self->_track.get()) {
+    int width = info[0]->Int32Value();
+    int height = info[1]->Int32Value();
+    
+    if (node::Buffer::HasInstance(info[2])) {
+      const uint8_t *data = reinterpret_cast<const uint8_t*>(node::Buffer::Data(info[2]));
+      retval = self->_capturer->PushFrame(data, node::Buffer::Length(info[2]), width, height, fourcc);
+    } else {
+      node::ArrayBuffer *container = node::ArrayBuffer::New(info[2]);
+      const uint8_t *data = reinterpret_cast<const uint8_t*>(container->Data());
+      retval = self->_capturer->PushFrame(data, container->Length(), width, height, fourcc);
+    }
+  }
+  
+  info.GetReturnValue().Set(Nan::New(retval));
+}
+
+void VideoSource::Stop(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  VideoSource *self = RTCWrap::Unwrap<VideoSource>(info.This(), "VideoSource");
+  
+  if (self->_source.get()) {
+    self->_source->Stop();
+  }
+  
+  if (self->_track.get()) {
+    self->_track->set_state(webrtc::MediaStreamTrackInterface::kEnded);
+  }
+  
+  info.GetReturnValue().SetUndefined();
+}
+
+void VideoSource::GetTrack(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  VideoSource *self = RTCWrap::Unwrap<VideoSource>(info.Holder(), "VideoSource");
+  info.GetReturnValue().Set(MediaStreamTrack::New(self->_track));
+}
+
+void VideoSource::GetStream(Local<String> property, const Nan::PropertyCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  VideoSource *self = RTCWrap::Unwrap<VideoSource>(info.Holder(), "VideoSource");
+  info.GetReturnValue().Set(MediaStream::New(self->_stream));
+}
@@ -0,0 +1,95 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_VIDEOSOURCE_H
+#define WEBRTC_VIDEOSOURCE_H
+
+#include "Common.h"
+#include "Wrap.h"
+
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/media/base/videocapturer.h"
+#include "webrtc/media/base/videocommon.h"
+
+namespace WebRTC {
+  class FramePool {
+   public:
+    explicit FramePool(size_t limit = 4);
+    ~FramePool();
+    
+    rtc::Buffer *Acquire(size_t size);
+    void Release(rtc::Buffer *buffer);
+    
+   protected:
+    size_t _limit;
+    rtc::CriticalSection _lock;
+    std::vector<rtc::Buffer*> _free;
+  };
+  
+  class FrameCapturer : public cricket::VideoCapturer {
+   public:
+    FrameCapturer(int width = 640, int height = 480, int fps = 30);
+    ~FrameCapturer() override;
+    
+    bool PushFrame(const uint8_t *data, size_t size, int width, int height, uint32_t fourcc = cricket::FOURCC_I420);
+    
+    cricket::CaptureState Start(const cricket::VideoFormat &format) override;
+    void Stop() override;
+    bool IsRunning() override;
+    bool IsScreencast() const override;
+    
+   protected:
+    bool GetPreferredFourccs(std::vector<uint32_t> *fourccs) override;
+    
+    volatile bool _running;
+    FramePool _pool;
+  };
+  
+  class VideoSource : public RTCWrap {
+   public:
+    static void Init(v8::Handle<v8::Object> exports);
+    
+   private:
+    VideoSource(int width, int height, int fps);
+    ~VideoSource() final;
+    
+    static void New(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void PushFrame(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void Stop(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    
+    static void GetTrack(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    static void GetStream(v8::Local<v8::String> property, const Nan::PropertyCallbackInfo<v8::Value> &info);
+    
+   protected:
+    FrameCapturer *_capturer;
+    rtc::scoped_refptr<webrtc::VideoTrackInterface> _track;
+    rtc::scoped_refptr<webrtc::MediaStreamInterface> _stream;
+    rtc::scoped_refptr<webrtc::VideoTrackSourceInterface> _source;
+    
+    static Nan::Persistent<v8::Function> constructor;
+  };
+};
+
+#endif
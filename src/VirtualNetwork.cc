@@ -0,0 +1,182 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include "VirtualNetwork.h"
+
+#include "webrtc/base/timeutils.h"
+
+using namespace WebRTC;
+
+// 10.0.0.0/8, one address per peer.
+#define kVirtualNetworkBase 0x0A000001
+#define kVirtualNetworkPrefix 8
+#define kVirtualPortFirst 10000
+#define kVirtualPortLast 65535
+
+VirtualSocket::VirtualSocket(VirtualNetwork *network, rtc::Thread *thread, const rtc::SocketAddress &address) :
+  RoutedSocket(thread, address),
+  _network(network)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+VirtualSocket::~VirtualSocket() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  VirtualSocket::Close();
+}
+
+int VirtualSocket::Transmit(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) {
+  return _network->SendTo(this, data, size, address);
+}
+
+void VirtualSocket::Detach() {
+  _network->Remove(this);
+}
+
+VirtualNetworkManager::VirtualNetworkManager() :
+  _address(VirtualNetwork::Instance()->CreateAddress()),
+  _thread(0),
+  _started(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+VirtualNetworkManager::~VirtualNetworkManager() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  // The update was posted to the thread StartUpdating ran on, which need
+  // not be the one destroying the manager.
+  if (_thread) {
+    _thread->Clear(this);
+  }
+}
+
+void VirtualNetworkManager::StartUpdating() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!_started++) {
+    _thread = rtc::Thread::Current();
+    _thread->Post(this);
+  } else {
+    SignalNetworksChanged();
+  }
+}
+
+void VirtualNetworkManager::StopUpdating() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (_started) {
+    _started--;
+  }
+}
+
+void VirtualNetworkManager::OnMessage(rtc::Message *msg) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (!_started) {
+    return;
+  }
+  
+  rtc::IPAddress prefix = rtc::TruncateIP(_address, kVirtualNetworkPrefix);
+  rtc::Network *network = new rtc::Network("virtual0", "Virtual network", prefix, kVirtualNetworkPrefix);
+  NetworkList list;
+  bool changed = false;
+  
+  network->AddIP(_address);
+  list.push_back(network);
+  
+  MergeNetworkList(list, &changed);
+  
+  if (changed) {
+    SignalNetworksChanged();
+  }
+}
+
+VirtualNetwork::VirtualNetwork() : _hosts(0) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+VirtualNetwork::~VirtualNetwork() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+VirtualNetwork *VirtualNetwork::Instance() {
+  static VirtualNetwork *network = new VirtualNetwork();
+  return network;
+}
+
+rtc::IPAddress VirtualNetwork::CreateAddress() {
+  rtc::CritScope lock(&_lock);
+  uint32_t host = _hosts++ % 0x00FFFFFE;
+  
+  return rtc::IPAddress(kVirtualNetworkBase + host);
+}
+
+rtc::AsyncPacketSocket *VirtualNetwork::CreateSocket(rtc::Thread *thread, const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  int first = min_port ? min_port : kVirtualPortFirst;
+  int last = max_port ? max_port : kVirtualPortLast;
+  
+  rtc::CritScope lock(&_lock);
+  
+  for (int port = first; port <= last; port++) {
+    rtc::SocketAddress local(address.ipaddr(), port);
+    
+    if (_sockets.find(local) == _sockets.end()) {
+      VirtualSocket *socket = new VirtualSocket(this, thread, local);
+      
+      _sockets[local] = socket;
+      SocketRouter::Track(socket);
+      
+      return socket;
+    }
+  }
+  
+  return 0;
+}
+
+int VirtualNetwork::SendTo(VirtualSocket *socket, const void *data, size_t size, const rtc::SocketAddress &address) {
+  rtc::CritScope lock(&_lock);
+  std::map<rtc::SocketAddress, VirtualSocket*>::iterator index = _sockets.find(address);
+  
+  // Like UDP, a packet to nobody is silently lost.
+  if (index != _sockets.end()) {
+    VirtualSocket *target = index->second;
+    SocketRouter::Post(target->_thread, target, target->_id, data, size, socket->_address, rtc::PacketTime());
+  }
+  
+  return static_cast<int>(size);
+}
+
+void VirtualNetwork::Remove(VirtualSocket *socket) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::CritScope lock(&_lock);
+  
+  _sockets.erase(socket->_address);
+  SocketRouter::Untrack(socket);
+}
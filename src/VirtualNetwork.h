@@ -0,0 +1,99 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_VIRTUALNETWORK_H
+#define WEBRTC_VIRTUALNETWORK_H
+
+#include <map>
+
+#include "Logging.h"
+#include "RoutedSocket.h"
+
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/network.h"
+
+namespace WebRTC {
+  class VirtualNetwork;
+  
+  class VirtualSocket : public RoutedSocket {
+    friend class VirtualNetwork;
+    
+   public:
+    ~VirtualSocket() override;
+    
+   private:
+    VirtualSocket(VirtualNetwork *network, rtc::Thread *thread, const rtc::SocketAddress &address);
+    
+    int Transmit(const void *data, size_t size, const rtc::SocketAddress &address, const rtc::PacketOptions &options) override;
+    void Detach() override;
+    
+   protected:
+    VirtualNetwork *_network;
+  };
+  
+  // Reports a single virtual interface with an address of its own, so every
+  // peer on the virtual network is a distinct host.
+  class VirtualNetworkManager : public rtc::NetworkManagerBase, public rtc::MessageHandler {
+   public:
+    VirtualNetworkManager();
+    ~VirtualNetworkManager() override;
+    
+    void StartUpdating() override;
+    void StopUpdating() override;
+    
+    void OnMessage(rtc::Message *msg) final;
+    
+   protected:
+    rtc::IPAddress _address;
+    rtc::Thread *_thread;
+    int _started;
+  };
+  
+  // In-memory packet switch between every peer using the virtual network.
+  // Packets are handed to the receiving socket's thread without touching the
+  // kernel, the full ICE / DTLS / SCTP stack still runs on top.
+  class VirtualNetwork : public SocketRouter {
+   public:
+    static VirtualNetwork *Instance();
+    
+    rtc::IPAddress CreateAddress();
+    rtc::AsyncPacketSocket *CreateSocket(rtc::Thread *thread, const rtc::SocketAddress &address, uint16_t min_port, uint16_t max_port);
+    
+   private:
+    VirtualNetwork();
+    ~VirtualNetwork() override;
+    
+    friend class VirtualSocket;
+    
+    int SendTo(VirtualSocket *socket, const void *data, size_t size, const rtc::SocketAddress &address);
+    void Remove(VirtualSocket *socket);
+    
+   protected:
+    uint32_t _hosts;
+    std::map<rtc::SocketAddress, VirtualSocket*> _sockets;
+  };
+};
+
+#endif
@@ -0,0 +1,243 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#include "Watchdog.h"
+#include "Platform.h"
+
+#include "webrtc/base/timeutils.h"
+
+using namespace v8;
+using namespace WebRTC;
+
+#define kWatchdogInterval 1000
+#define kWatchdogThreshold 5000
+
+enum WatchdogMessage {
+  kWatchdogTick,
+  kWatchdogHeartbeat,
+  kWatchdogReport,
+};
+
+namespace WebRTC {
+  class HeartbeatHandler : public rtc::MessageHandler {
+   public:
+    void OnMessage(rtc::Message *msg) final {
+      rtc::ScopedRefMessageData<WatchdogTarget> *data = static_cast<rtc::ScopedRefMessageData<WatchdogTarget>*>(msg->pdata);
+      rtc::AtomicOps::ReleaseStore(&data->data()->pending, 0);
+      delete data;
+    }
+  };
+};
+
+// Outlives every watchdog, a heartbeat may be answered long after the
+// watchdog that sent it was stopped.
+static HeartbeatHandler heartbeat;
+static Watchdog *watchdog = 0;
+
+static int GetMilliseconds(Local<Object> options, const char *key, int value) {
+  Local<Value> number = options->Get(Nan::New(key).ToLocalChecked());
+  
+  if (number->IsNumber() && number->Int32Value() > 0) {
+    return number->Int32Value();
+  }
+  
+  return value;
+}
+
+void Watchdog::Init(Handle<Object> exports) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  exports->Set(Nan::New("startWatchdog").ToLocalChecked(), Nan::New<FunctionTemplate>(Watchdog::StartWatchdog)->GetFunction());
+  exports->Set(Nan::New("stopWatchdog").ToLocalChecked(), Nan::New<FunctionTemplate>(Watchdog::StopWatchdog)->GetFunction());
+}
+
+void Watchdog::Dispose() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  delete watchdog;
+  watchdog = 0;
+}
+
+Watchdog::Watchdog(int interval, int threshold, Local<Function> callback) :
+  _interval(interval),
+  _threshold(threshold)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  SetEmitterName("Watchdog");
+  
+  std::vector<MonitoredThread*> threads;
+  Platform::GetThreads(&threads);
+  
+  for (size_t index = 0; index < threads.size(); index++) {
+    _targets.push_back(new rtc::RefCountedObject<WatchdogTarget>(threads[index]));
+  }
+  
+  _callback.Reset<Function>(callback);
+  _thread.SetName("watchdog", 0);
+}
+
+Watchdog::~Watchdog() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Watchdog::Stop();
+  _callback.Reset();
+}
+
+void Watchdog::Start() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _thread.Start();
+  _thread.Post(this, kWatchdogTick);
+}
+
+void Watchdog::Stop() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  _thread.Stop();
+}
+
+void Watchdog::OnMessage(rtc::Message *msg) {
+  if (msg->message_id == kWatchdogTick) {
+    Watchdog::Check();
+    _thread.PostDelayed(_interval, this, kWatchdogTick);
+  }
+}
+
+void Watchdog::Check() {
+  int64_t now = rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec;
+  
+  for (size_t index = 0; index < _targets.size(); index++) {
+    WatchdogTarget *target = _targets[index].get();
+    
+    if (!rtc::AtomicOps::AcquireLoad(&target->pending)) {
+      if (target->stalled) {
+        WatchdogReport report;
+        
+        report.thread = target->thread->name();
+        report.elapsed = now - target->sent;
+        
+        LOG(LS_WARNING) << "Thread " << report.thread << " resumed after " << report.elapsed << " ms";
+        
+        target->stalled = false;
+        EventEmitter::Emit<WatchdogReport>(kWatchdogReport, report);
+      }
+      
+      rtc::AtomicOps::ReleaseStore(&target->pending, 1);
+      target->sent = now;
+      target->thread->Post(&heartbeat, kWatchdogHeartbeat, new rtc::ScopedRefMessageData<WatchdogTarget>(target));
+    } else if (!target->stalled && (now - target->sent) >= _threshold) {
+      WatchdogReport report;
+      
+      report.thread = target->thread->name();
+      report.stalled = true;
+      report.elapsed = now - target->sent;
+      report.pending = target->thread->size();
+      report.captured = target->thread->CaptureStack(&report.stack);
+      
+      LOG(LS_ERROR) << "Thread " << report.thread << " stalled for " << report.elapsed << " ms with " << report.pending << " pending messages";
+      
+      for (size_t frame = 0; frame < report.stack.size(); frame++) {
+        LOG(LS_ERROR) << frame << ": " << report.stack[frame];
+      }
+      
+      target->stalled = true;
+      EventEmitter::Emit<WatchdogReport>(kWatchdogReport, report);
+    }
+  }
+}
+
+void Watchdog::On(Event *event) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Nan::HandleScope scope;
+  
+  if (event->Type<WatchdogMessage>() != kWatchdogReport || _callback.IsEmpty()) {
+    return;
+  }
+  
+  const WatchdogReport &report = event->Unwrap<WatchdogReport>();
+  Local<Object> retval = Nan::New<Object>();
+  Local<Value> argv[1] = { retval };
+  
+  retval->Set(Nan::New("thread").ToLocalChecked(), Nan::New(report.thread.c_str()).ToLocalChecked());
+  retval->Set(Nan::New("stalled").ToLocalChecked(), Nan::New(report.stalled));
+  retval->Set(Nan::New("elapsed").ToLocalChecked(), Nan::New(static_cast<double>(report.elapsed)));
+  
+  if (report.stalled) {
+    retval->Set(Nan::New("pending").ToLocalChecked(), Nan::New(static_cast<double>(report.pending)));
+    
+    if (report.captured) {
+      Local<Array> stack = Nan::New<Array>();
+      
+      for (size_t index = 0; index < report.stack.size(); index++) {
+        stack->Set(index, Nan::New(report.stack[index].c_str()).ToLocalChecked());
+      }
+      
+      retval->Set(Nan::New("stack").ToLocalChecked(), stack);
+    } else {
+      retval->Set(Nan::New("stack").ToLocalChecked(), Nan::Null());
+    }
+  }
+  
+  Local<Function> callback = Nan::New<Function>(_callback);
+  callback->Call(Nan::GetCurrentContext()->Global(), 1, argv);
+}
+
+void Watchdog::StartWatchdog(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  int interval = kWatchdogInterval;
+  int threshold = kWatchdogThreshold;
+  Local<Value> callback = info[0];
+  
+  if (info.Length() >= 2) {
+    if (info[0]->IsObject()) {
+      Local<Object> options = info[0]->ToObject();
+      
+      interval = GetMilliseconds(options, "interval", interval);
+      threshold = GetMilliseconds(options, "threshold", threshold);
+    }
+    
+    callback = info[1];
+  }
+  
+  if (callback.IsEmpty() || !callback->IsFunction()) {
+    return Nan::ThrowError("Missing callback");
+  }
+  
+  Watchdog::Dispose();
+  
+  watchdog = new Watchdog(interval, threshold, Local<Function>::Cast(callback));
+  watchdog->Start();
+  
+  info.GetReturnValue().SetUndefined();
+}
+
+void Watchdog::StopWatchdog(const Nan::FunctionCallbackInfo<Value> &info) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  Watchdog::Dispose();
+  info.GetReturnValue().SetUndefined();
+}
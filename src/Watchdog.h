@@ -0,0 +1,96 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+#ifndef WEBRTC_WATCHDOG_H
+#define WEBRTC_WATCHDOG_H
+
+#include <string>
+#include <vector>
+
+#include "Common.h"
+#include "EventEmitter.h"
+#include "ThreadMonitor.h"
+
+namespace WebRTC {
+  struct WatchdogReport {
+    WatchdogReport() : stalled(false), elapsed(0), pending(0), captured(false) { }
+    
+    std::string thread;
+    bool stalled;
+    int64_t elapsed;
+    size_t pending;
+    bool captured;
+    std::vector<std::string> stack;
+  };
+  
+  // Heartbeat state of one monitored thread, shared with the heartbeat
+  // message so a wedged thread never holds a dangling pointer.
+  class WatchdogTarget : public rtc::RefCountInterface {
+   public:
+    explicit WatchdogTarget(MonitoredThread *thread) :
+      thread(thread),
+      pending(0),
+      sent(0),
+      stalled(false)
+    { }
+    
+    MonitoredThread *thread;
+    volatile int pending;
+    int64_t sent;
+    bool stalled;
+  };
+  
+  // Posts a heartbeat to every Platform thread each interval from its own
+  // thread. A heartbeat still queued after threshold milliseconds marks the
+  // thread stalled, its stack is captured and the report is handed to the
+  // JavaScript callback.
+  class Watchdog : public EventEmitter, public rtc::MessageHandler {
+   public:
+    static void Init(v8::Handle<v8::Object> exports);
+    static void Dispose();
+    
+    void On(Event *event) final;
+    void OnMessage(rtc::Message *msg) final;
+    
+   private:
+    Watchdog(int interval, int threshold, v8::Local<v8::Function> callback);
+    ~Watchdog() final;
+    
+    static void StartWatchdog(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    static void StopWatchdog(const Nan::FunctionCallbackInfo<v8::Value> &info);
+    
+    void Start();
+    void Stop();
+    void Check();
+    
+   protected:
+    rtc::Thread _thread;
+    int _interval;
+    int _threshold;
+    std::vector<rtc::scoped_refptr<WatchdogTarget> > _targets;
+    Nan::Persistent<v8::Function> _callback;
+  };
+};
+
+#endif
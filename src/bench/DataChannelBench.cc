@@ -0,0 +1,402 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "Histogram.h"
+#include "bench/Loopback.h"
+
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/ssladapter.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/timeutils.h"
+
+using namespace WebRTC;
+using namespace WebRTC::Bench;
+
+// Stop queueing once this much is buffered in the channel and resume when
+// the buffered amount drops.
+#define kHighWaterMark (1024 * 1024)
+#define kDrainTimeout 500
+
+static const size_t kSizes[] = {
+  16, 64, 256, 1024, 4096, 16384, 65536, 262144,
+};
+
+struct BenchOptions {
+  BenchOptions() :
+    bytes(32 * 1024 * 1024),
+    maxMessages(100000),
+    minMessages(200),
+    probes(1000),
+    maxRetransmits(0)
+  { }
+  
+  std::vector<size_t> sizes;
+  size_t bytes;
+  size_t maxMessages;
+  size_t minMessages;
+  size_t probes;
+  int maxRetransmits;
+  TransportOptions transport;
+  std::string output;
+};
+
+// Every message starts with the rtc::TimeNanos() of its send, both peers
+// share the process clock so the difference is the one-way latency.
+class Receiver : public LoopbackChannel {
+ public:
+  Receiver() : _received(false, false), _count(0), _bytes(0), _last(0) { }
+  
+  void Reset() {
+    rtc::CritScope lock(&_lock);
+    
+    _latency.Reset();
+    _count = 0;
+    _bytes = 0;
+    _last = 0;
+    _received.Reset();
+  }
+  
+  // Drops a signal left over from an earlier message, so the next wait only
+  // returns for a message that arrives after this call.
+  void ResetSignal() {
+    _received.Reset();
+  }
+  
+  bool WaitForMessage(int timeout) {
+    return _received.Wait(timeout);
+  }
+  
+  void Snapshot(Histogram *latency, size_t *count, size_t *bytes, int64_t *last) {
+    rtc::CritScope lock(&_lock);
+    
+    *latency = _latency;
+    *count = _count;
+    *bytes = _bytes;
+    *last = _last;
+  }
+  
+  size_t Count() {
+    rtc::CritScope lock(&_lock);
+    return _count;
+  }
+  
+ protected:
+  void Received(const webrtc::DataBuffer &buffer) override {
+    int64_t now = rtc::TimeNanos();
+    int64_t sent = 0;
+    
+    if (buffer.data.size() >= sizeof(sent)) {
+      memcpy(&sent, buffer.data.data(), sizeof(sent));
+    }
+    
+    {
+      rtc::CritScope lock(&_lock);
+      
+      _latency.Record((now - sent) / rtc::kNumNanosecsPerMicrosec);
+      _count++;
+      _bytes += buffer.data.size();
+      _last = now;
+    }
+    
+    _received.Set();
+  }
+  
+  rtc::CriticalSection _lock;
+  rtc::Event _received;
+  Histogram _latency;
+  size_t _count;
+  size_t _bytes;
+  int64_t _last;
+};
+
+static bool Send(LoopbackChannel *sender, std::vector<uint8_t> *payload) {
+  while (sender->channel->buffered_amount() > kHighWaterMark) {
+    if (!sender->WaitForWritable(kTimeout)) {
+      return false;
+    }
+  }
+  
+  int64_t now = rtc::TimeNanos();
+  memcpy(payload->data(), &now, sizeof(now));
+  
+  return sender->channel->Send(webrtc::DataBuffer(rtc::Buffer(payload->data(), payload->size()), true));
+}
+
+// Waits until everything arrived, or for partially reliable channels until
+// nothing has arrived for a while.
+static void Drain(Receiver *receiver, size_t expected, bool reliable) {
+  size_t count = receiver->Count();
+  
+  while (count < expected) {
+    if (!receiver->WaitForMessage(reliable ? kTimeout : kDrainTimeout)) {
+      break;
+    }
+    
+    count = receiver->Count();
+  }
+}
+
+static bool RunCase(LoopbackPeer *local, LoopbackPeer *remote, const BenchOptions &options, size_t size, bool ordered, bool reliable, Json::Value *result) {
+  static int index = 0;
+  
+  LoopbackChannel sender;
+  Receiver receiver;
+  webrtc::DataChannelInit init;
+  std::string label = "bench-" + rtc::ToString(index++);
+  
+  init.ordered = ordered;
+  
+  if (!reliable) {
+    init.maxRetransmits = options.maxRetransmits;
+  }
+  
+  remote->Expect(&receiver);
+  rtc::scoped_refptr<webrtc::DataChannelInterface> channel = local->peer->CreateDataChannel(label, &init);
+  
+  if (!channel.get()) {
+    remote->Expect(0);
+    fprintf(stderr, "Unable to create data channel\n");
+    return false;
+  }
+  
+  sender.Attach(channel);
+  
+  if (!sender.WaitForOpen() || !receiver.WaitForOpen()) {
+    remote->Expect(0);
+    fprintf(stderr, "Timeout while opening data channel\n");
+    return false;
+  }
+  
+  std::vector<uint8_t> payload(size, 0x55);
+  size_t messages = std::max(options.minMessages, std::min(options.maxMessages, options.bytes / size));
+  
+  // Throughput: keep the channel saturated.
+  int64_t start = rtc::TimeNanos();
+  size_t sent = 0;
+  
+  for (; sent < messages; sent++) {
+    if (!Send(&sender, &payload)) {
+      break;
+    }
+  }
+  
+  Drain(&receiver, sent, reliable);
+  
+  Histogram loaded;
+  size_t received = 0;
+  size_t bytes = 0;
+  int64_t last = 0;
+  
+  receiver.Snapshot(&loaded, &received, &bytes, &last);
+  
+  double seconds = (received && last > start) ? static_cast<double>(last - start) / rtc::kNumNanosecsPerSec : 0;
+  
+  // Latency: one message in flight at a time.
+  receiver.Reset();
+  
+  for (size_t probe = 0; probe < options.probes; probe++) {
+    receiver.ResetSignal();
+    
+    if (!Send(&sender, &payload)) {
+      break;
+    }
+    
+    if (!receiver.WaitForMessage(reliable ? kTimeout : kDrainTimeout) && reliable) {
+      break;
+    }
+  }
+  
+  Histogram latency;
+  size_t probes = 0;
+  size_t probeBytes = 0;
+  
+  receiver.Snapshot(&latency, &probes, &probeBytes, &last);
+  
+  sender.Detach();
+  receiver.Detach();
+  
+  (*result)["size"] = Json::Value::UInt64(size);
+  (*result)["ordered"] = ordered;
+  (*result)["reliable"] = reliable;
+  
+  if (!reliable) {
+    (*result)["maxRetransmits"] = options.maxRetransmits;
+  }
+  
+  (*result)["sent"] = Json::Value::UInt64(sent);
+  (*result)["received"] = Json::Value::UInt64(received);
+  (*result)["seconds"] = seconds;
+  (*result)["messagesPerSecond"] = seconds > 0 ? received / seconds : 0;
+  (*result)["megabytesPerSecond"] = seconds > 0 ? bytes / seconds / 1000000 : 0;
+  (*result)["latency"] = latency.ToJson();
+  (*result)["loadedLatency"] = loaded.ToJson();
+  
+  fprintf(stderr, "%7u B %-9s %-8s %10.0f msg/s %9.2f MB/s  latency p50 %lld us p99 %lld us p999 %lld us\n",
+          static_cast<unsigned int>(size),
+          ordered ? "ordered" : "unordered",
+          reliable ? "reliable" : "partial",
+          seconds > 0 ? received / seconds : 0,
+          seconds > 0 ? bytes / seconds / 1000000 : 0,
+          static_cast<long long>(latency.Percentile(50)),
+          static_cast<long long>(latency.Percentile(99)),
+          static_cast<long long>(latency.Percentile(99.9)));
+  
+  return sent == messages;
+}
+
+static bool ParseOptions(int argc, char **argv, BenchOptions *options) {
+  for (int index = 1; index < argc; index++) {
+    const char *arg = argv[index];
+    
+    if (!strncmp(arg, "--sizes=", 8)) {
+      std::vector<std::string> sizes;
+      rtc::split(arg + 8, ',', &sizes);
+      
+      for (size_t size = 0; size < sizes.size(); size++) {
+        size_t value = strtoul(sizes[size].c_str(), 0, 10);
+        
+        if (value < sizeof(int64_t)) {
+          fprintf(stderr, "Message size must be at least %u bytes\n", static_cast<unsigned int>(sizeof(int64_t)));
+          return false;
+        }
+        
+        options->sizes.push_back(value);
+      }
+    } else if (!strncmp(arg, "--bytes=", 8)) {
+      options->bytes = strtoul(arg + 8, 0, 10);
+    } else if (!strncmp(arg, "--messages=", 11)) {
+      options->maxMessages = options->minMessages = strtoul(arg + 11, 0, 10);
+    } else if (!strncmp(arg, "--probes=", 9)) {
+      options->probes = strtoul(arg + 9, 0, 10);
+    } else if (!strncmp(arg, "--max-retransmits=", 18)) {
+      options->maxRetransmits = atoi(arg + 18);
+    } else if (!strncmp(arg, "--output=", 9)) {
+      options->output = arg + 9;
+    } else if (!strcmp(arg, "--virtual")) {
+      options->transport.virtualNetwork = true;
+    } else if (!strcmp(arg, "--verbose")) {
+      rtc::LogMessage::LogToDebug(rtc::LS_VERBOSE);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--sizes=16,1024,...] [--bytes=N] [--messages=N] [--probes=N]\n"
+              "          [--max-retransmits=N] [--virtual] [--output=file.json] [--verbose]\n", argv[0]);
+      return false;
+    }
+  }
+  
+  if (options->sizes.empty()) {
+    options->sizes.assign(kSizes, kSizes + sizeof(kSizes) / sizeof(kSizes[0]));
+  }
+  
+  return true;
+}
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  
+  rtc::LogMessage::LogToDebug(rtc::LS_NONE);
+  
+  if (!ParseOptions(argc, argv, &options)) {
+    return 2;
+  }
+  
+  rtc::InitializeSSL();
+  
+  int status = 0;
+  std::string error;
+  Json::Value report(Json::objectValue);
+  Json::Value results(Json::arrayValue);
+  
+  {
+    LoopbackFactory factory;
+    LoopbackPeer local, remote;
+    LoopbackChannel control, remoteControl;
+    
+    // The control channel puts SCTP in the offer and keeps the association
+    // up between cases. Both ends are attached and open before the first
+    // case, so its OPEN can't reach the receiver of a case.
+    if (!factory.Start() || !local.Create(&factory, options.transport) || !remote.Create(&factory, options.transport)) {
+      fprintf(stderr, "Unable to create peer connections\n");
+      return 1;
+    }
+    
+    remote.Expect(&remoteControl);
+    control.Attach(local.peer->CreateDataChannel("control", 0));
+    
+    if (!Connect(&local, &remote, &error) || !control.WaitForOpen() || !remoteControl.WaitForOpen()) {
+      fprintf(stderr, "Unable to connect peers: %s\n", error.empty() ? "timeout" : error.c_str());
+      return 1;
+    }
+    
+    for (size_t index = 0; index < options.sizes.size(); index++) {
+      for (int mode = 0; mode < 4; mode++) {
+        Json::Value result(Json::objectValue);
+        
+        if (!RunCase(&local, &remote, options, options.sizes[index], !(mode & 1), !(mode & 2), &result)) {
+          status = 1;
+        }
+        
+        results.append(result);
+      }
+    }
+    
+    control.Detach();
+    remoteControl.Detach();
+    local.Close();
+    remote.Close();
+  }
+  
+  report["benchmark"] = "datachannel";
+  report["transport"] = options.transport.virtualNetwork ? "virtual" : "udp";
+  report["latencyUnit"] = "us";
+  report["results"] = results;
+  
+  Json::StyledWriter writer;
+  std::string json = writer.write(report);
+  
+  if (options.output.empty()) {
+    fputs(json.c_str(), stdout);
+  } else {
+    FILE *file = fopen(options.output.c_str(), "w");
+    
+    if (!file) {
+      fprintf(stderr, "Unable to write %s\n", options.output.c_str());
+      status = 1;
+    } else {
+      fputs(json.c_str(), file);
+      fclose(file);
+    }
+  }
+  
+  rtc::CleanupSSL();
+  return status;
+}
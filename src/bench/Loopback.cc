@@ -0,0 +1,335 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#include <utility>
+
+#include "Loopback.h"
+
+#include "webrtc/api/jsep.h"
+#include "webrtc/api/test/fakeconstraints.h"
+#include "webrtc/base/refcount.h"
+#include "webrtc/base/scoped_ptr.h"
+
+using namespace WebRTC;
+using namespace WebRTC::Bench;
+
+class CreateDescriptionObserver : public webrtc::CreateSessionDescriptionObserver {
+ public:
+  CreateDescriptionObserver() : _event(false, false) { }
+  
+  void OnSuccess(webrtc::SessionDescriptionInterface* sdp) final {
+    _sdp.reset(sdp);
+    _event.Set();
+  }
+  
+  void OnFailure(const std::string &error) final {
+    _error = error;
+    _event.Set();
+  }
+  
+  webrtc::SessionDescriptionInterface *Wait(std::string *error) {
+    if (!_event.Wait(kTimeout)) {
+      *error = "Timeout while creating session description";
+      return 0;
+    }
+    
+    if (!_sdp.get()) {
+      *error = _error;
+    }
+    
+    return _sdp.release();
+  }
+ 
+ protected:
+  rtc::Event _event;
+  rtc::scoped_ptr<webrtc::SessionDescriptionInterface> _sdp;
+  std::string _error;
+};
+
+class SetDescriptionObserver : public webrtc::SetSessionDescriptionObserver {
+ public:
+  SetDescriptionObserver() : _event(false, false), _success(false) { }
+  
+  void OnSuccess() final {
+    _success = true;
+    _event.Set();
+  }
+  
+  void OnFailure(const std::string &error) final {
+    _error = error;
+    _event.Set();
+  }
+  
+  bool Wait(std::string *error) {
+    if (!_event.Wait(kTimeout)) {
+      *error = "Timeout while setting session description";
+      return false;
+    }
+    
+    if (!_success) {
+      *error = _error;
+    }
+    
+    return _success;
+  }
+ 
+ protected:
+  rtc::Event _event;
+  bool _success;
+  std::string _error;
+};
+
+LoopbackFactory::LoopbackFactory() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+LoopbackFactory::~LoopbackFactory() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  factory = nullptr;
+  
+  signaling.Stop();
+  worker.Stop();
+}
+
+bool LoopbackFactory::Start() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  signaling.Start();
+  worker.Start();
+  
+  factory = webrtc::CreatePeerConnectionFactory(&worker, &signaling, 0, 0, 0);
+  return factory.get() != 0;
+}
+
+LoopbackPeer::LoopbackPeer() :
+  _gathered(true, false),
+  _expected(0)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+LoopbackPeer::~LoopbackPeer() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  LoopbackPeer::Close();
+}
+
+bool LoopbackPeer::Create(LoopbackFactory *factory, const TransportOptions &transport) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  webrtc::PeerConnectionInterface::RTCConfiguration config;
+  webrtc::FakeConstraints constraints;
+  
+  constraints.AddOptional(webrtc::MediaConstraintsInterface::kEnableDtlsSrtp, true);
+  
+  rtc::scoped_ptr<cricket::PortAllocator> allocator(PortAllocator::Create(&factory->worker, transport));
+  peer = factory->factory->CreatePeerConnection(config, &constraints, std::move(allocator), NULL, this);
+  
+  return peer.get() != 0;
+}
+
+void LoopbackPeer::Close() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  if (peer.get()) {
+    peer->Close();
+    peer = nullptr;
+  }
+}
+
+void LoopbackPeer::Expect(LoopbackChannel *channel) {
+  rtc::CritScope lock(&_lock);
+  _expected = channel;
+}
+
+bool LoopbackPeer::WaitForGathering(int timeout) {
+  return _gathered.Wait(timeout);
+}
+
+void LoopbackPeer::OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState state) {
+}
+
+void LoopbackPeer::OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState state) {
+  if (state == webrtc::PeerConnectionInterface::kIceConnectionFailed) {
+    LOG(LS_ERROR) << "Loopback ICE connection failed";
+  }
+}
+
+void LoopbackPeer::OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState state) {
+  if (state == webrtc::PeerConnectionInterface::kIceGatheringComplete) {
+    _gathered.Set();
+  }
+}
+
+void LoopbackPeer::OnIceCandidate(const webrtc::IceCandidateInterface* candidate) {
+}
+
+void LoopbackPeer::OnDataChannel(webrtc::DataChannelInterface* channel) {
+  LoopbackChannel *expected = 0;
+  
+  {
+    rtc::CritScope lock(&_lock);
+    expected = _expected;
+    _expected = 0;
+  }
+  
+  if (expected) {
+    expected->Attach(channel);
+  } else {
+    channel->Close();
+  }
+}
+
+void LoopbackPeer::OnRenegotiationNeeded() {
+}
+
+void LoopbackPeer::OnAddStream(webrtc::MediaStreamInterface* stream) {
+}
+
+void LoopbackPeer::OnRemoveStream(webrtc::MediaStreamInterface* stream) {
+}
+
+LoopbackChannel::LoopbackChannel() :
+  _open(true, false),
+  _writable(false, false)
+{
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+}
+
+LoopbackChannel::~LoopbackChannel() {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  LoopbackChannel::Detach();
+}
+
+void LoopbackChannel::Attach(webrtc::DataChannelInterface *value) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  channel = value;
+  channel->RegisterObserver(this);
+  
+  if (channel->state() == webrtc::DataChannelInterface::kOpen) {
+    _open.Set();
+  }
+}
+
+void LoopbackChannel::Detach() {
+  if (channel.get()) {
+    channel->UnregisterObserver();
+    channel->Close();
+    channel = nullptr;
+  }
+}
+
+bool LoopbackChannel::WaitForOpen(int timeout) {
+  return _open.Wait(timeout);
+}
+
+bool LoopbackChannel::WaitForWritable(int timeout) {
+  return _writable.Wait(timeout);
+}
+
+void LoopbackChannel::OnStateChange() {
+  if (channel->state() == webrtc::DataChannelInterface::kOpen) {
+    _open.Set();
+  }
+}
+
+void LoopbackChannel::OnMessage(const webrtc::DataBuffer& buffer) {
+  Received(buffer);
+}
+
+void LoopbackChannel::OnBufferedAmountChange(uint64_t previous) {
+  _writable.Set();
+}
+
+static webrtc::SessionDescriptionInterface *CopyDescription(const webrtc::SessionDescriptionInterface *sdp, std::string *error) {
+  webrtc::SdpParseError parse;
+  std::string data;
+  
+  if (!sdp || !sdp->ToString(&data)) {
+    *error = "Missing session description";
+    return 0;
+  }
+  
+  webrtc::SessionDescriptionInterface *copy = webrtc::CreateSessionDescription(sdp->type(), data, &parse);
+  
+  if (!copy) {
+    *error = parse.description;
+  }
+  
+  return copy;
+}
+
+static bool SetDescription(LoopbackPeer *peer, bool local, webrtc::SessionDescriptionInterface *sdp, std::string *error) {
+  rtc::scoped_refptr<SetDescriptionObserver> observer(new rtc::RefCountedObject<SetDescriptionObserver>());
+  
+  if (!sdp) {
+    return false;
+  }
+  
+  if (local) {
+    peer->peer->SetLocalDescription(observer, sdp);
+  } else {
+    peer->peer->SetRemoteDescription(observer, sdp);
+  }
+  
+  return observer->Wait(error);
+}
+
+bool WebRTC::Bench::Connect(LoopbackPeer *offerer, LoopbackPeer *answerer, std::string *error) {
+  LOG(LS_INFO) << __PRETTY_FUNCTION__;
+  
+  rtc::scoped_refptr<CreateDescriptionObserver> offer(new rtc::RefCountedObject<CreateDescriptionObserver>());
+  offerer->peer->CreateOffer(offer, static_cast<const webrtc::MediaConstraintsInterface*>(0));
+  
+  if (!SetDescription(offerer, true, offer->Wait(error), error)) {
+    return false;
+  }
+  
+  if (!offerer->WaitForGathering()) {
+    *error = "Timeout while gathering offerer candidates";
+    return false;
+  }
+  
+  if (!SetDescription(answerer, false, CopyDescription(offerer->peer->local_description(), error), error)) {
+    return false;
+  }
+  
+  rtc::scoped_refptr<CreateDescriptionObserver> answer(new rtc::RefCountedObject<CreateDescriptionObserver>());
+  answerer->peer->CreateAnswer(answer, static_cast<const webrtc::MediaConstraintsInterface*>(0));
+  
+  if (!SetDescription(answerer, true, answer->Wait(error), error)) {
+    return false;
+  }
+  
+  if (!answerer->WaitForGathering()) {
+    *error = "Timeout while gathering answerer candidates";
+    return false;
+  }
+  
+  return SetDescription(offerer, false, CopyDescription(answerer->peer->local_description(), error), error);
+}
@@ -0,0 +1,125 @@
+/*
+* The MIT License (MIT)
+*
+* Copyright (c) 2015 vmolsa <ville.molsa@gmail.com> (http://github.com/vmolsa)
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+* THE SOFTWARE.
+*
+*/
+
+#ifndef WEBRTC_BENCH_LOOPBACK_H
+#define WEBRTC_BENCH_LOOPBACK_H
+
+#include <string>
+
+#include "Logging.h"
+#include "PortAllocator.h"
+
+#include "webrtc/api/datachannelinterface.h"
+#include "webrtc/api/peerconnectioninterface.h"
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/base/thread.h"
+
+namespace WebRTC {
+  namespace Bench {
+    // Upper bound for any single step of a benchmark in milliseconds.
+    const int kTimeout = 30000;
+    
+    class LoopbackChannel;
+    
+    // Shared factory on its own signaling and worker threads.
+    class LoopbackFactory {
+     public:
+      LoopbackFactory();
+      ~LoopbackFactory();
+      
+      bool Start();
+      
+      rtc::Thread signaling;
+      rtc::Thread worker;
+      rtc::scoped_refptr<webrtc::PeerConnectionFactoryInterface> factory;
+    };
+    
+    // One side of an in-process peer pair. Callbacks arrive on the signaling
+    // thread, the benchmark drives the peer through its proxy from main().
+    class LoopbackPeer : public webrtc::PeerConnectionObserver {
+     public:
+      LoopbackPeer();
+      ~LoopbackPeer() override;
+      
+      bool Create(LoopbackFactory *factory, const TransportOptions &transport);
+      void Close();
+      
+      // The next remote data channel is attached to this end point.
+      void Expect(LoopbackChannel *channel);
+      
+      bool WaitForGathering(int timeout = kTimeout);
+      
+      void OnSignalingChange(webrtc::PeerConnectionInterface::SignalingState state) final;
+      void OnIceConnectionChange(webrtc::PeerConnectionInterface::IceConnectionState state) final;
+      void OnIceGatheringChange(webrtc::PeerConnectionInterface::IceGatheringState state) final;
+      void OnIceCandidate(const webrtc::IceCandidateInterface* candidate) final;
+      void OnDataChannel(webrtc::DataChannelInterface* channel) final;
+      void OnRenegotiationNeeded() final;
+      void OnAddStream(webrtc::MediaStreamInterface* stream) final;
+      void OnRemoveStream(webrtc::MediaStreamInterface* stream) final;
+      
+      rtc::scoped_refptr<webrtc::PeerConnectionInterface> peer;
+     
+     protected:
+      rtc::CriticalSection _lock;
+      rtc::Event _gathered;
+      LoopbackChannel *_expected;
+    };
+    
+    // Data channel end point. Messages are handed to Received() on the
+    // signaling thread.
+    class LoopbackChannel : public webrtc::DataChannelObserver {
+     public:
+      LoopbackChannel();
+      ~LoopbackChannel() override;
+      
+      void Attach(webrtc::DataChannelInterface *channel);
+      void Detach();
+      
+      bool WaitForOpen(int timeout = kTimeout);
+      bool WaitForWritable(int timeout);
+      
+      void OnStateChange() final;
+      void OnMessage(const webrtc::DataBuffer& buffer) final;
+      void OnBufferedAmountChange(uint64_t previous) final;
+      
+      rtc::scoped_refptr<webrtc::DataChannelInterface> channel;
+     
+     protected:
+      virtual void Received(const webrtc::DataBuffer &buffer) { }
+      
+      rtc::Event _open;
+      rtc::Event _writable;
+    };
+    
+    // Offer / answer between two peers. Each side finishes gathering before
+    // its description is passed on, so no trickled candidates are relayed.
+    bool Connect(LoopbackPeer *offerer, LoopbackPeer *answerer, std::string *error);
+  };
+};
+
+#endif
@@ -14,19 +14,40 @@
         'Global.cc',
         'BackTrace.cc',
         'EventEmitter.cc',
+        'EmitterMetrics.cc',
         'Observers.cc',
         'Module.cc',
         'PeerConnection.cc',
+        'PeerConnectionPool.cc',
+        'ThreadMonitor.cc',
+        'Watchdog.cc',
+        'PortAllocator.cc',
+        'RoutedSocket.cc',
+        'UdpMux.cc',
+        'BatchedSocket.cc',
+        'VirtualNetwork.cc',
+        'EmulatedSocket.cc',
         'DataChannel.cc',
+        'LatencyProbe.cc',
         'GetSources.cc',
         'GetUserMedia.cc',
         'MediaStream.cc',
         'MediaStreamTrack.cc',
+        'AudioAnalyzer.cc',
+        'VideoSource.cc',
+        'AudioDevice.cc',
+        'AudioSource.cc',
+        'FileSource.cc',
+        'MediaRequest.cc',
+        'DeviceCache.cc',
+        'SharedSource.cc',
+        'CertificateStore.cc',
         'MediaConstraints.cc',
         'Stats.cc',
       ],
       'dependencies': [
         '<(webrtc_root)/webrtc.gyp:webrtc_all',
+        '<(DEPTH)/third_party/libyuv/libyuv.gyp:libyuv',
       ],
       'include_dirs': [
         '<(DEPTH)/third_party/jsoncpp/source/include',
@@ -78,6 +99,54 @@
         }],
       ],
     },
+    {
+      'target_name': 'webrtc_bench',
+      'type': 'executable',
+      'suppress_wildcard': 1,
+      'product_extension': '',
+      'sources': [
+        'bench/Loopback.cc',
+        'bench/DataChannelBench.cc',
+        'PortAllocator.cc',
+        'RoutedSocket.cc',
+        'UdpMux.cc',
+        'BatchedSocket.cc',
+        'VirtualNetwork.cc',
+        'EmulatedSocket.cc',
+      ],
+      'dependencies': [
+        '<(webrtc_root)/webrtc.gyp:webrtc_all',
+      ],
+      'include_dirs': [
+        '.',
+        '<(DEPTH)/third_party/jsoncpp/source/include',
+      ],
+      'conditions': [
+        ['OS=="linux"', {
+          'cflags': [
+            '-Wno-deprecated-declarations',
+            '-Wno-unused-variable',
+            '-Wno-unknown-pragmas',
+            '-Wno-unused-result',
+          ],
+          'cflags_cc': [
+            '-Wno-non-virtual-dtor',
+            '-Wno-delete-non-virtual-dtor',
+            '-Wno-overloaded-virtual',
+          ],
+        }],
+        ['OS=="mac"', {
+          'xcode_settings': {
+            'OTHER_CFLAGS': [
+              '-Wno-nonnull',
+              '-Wno-deprecated-declarations',
+              '-Wno-unknown-pragmas',
+              '-Wno-unused-result',
+            ],
+          },
+        }],
+      ],
+    },
     {
       'target_name': 'All',
       'type': 'none',
@@ -0,0 +1,37 @@
+var WebRTC = require('../');
+
+//WebRTC.setDebug(true);
+
+function onSuccess(stream) {
+  var audio_list = stream.getAudioTracks();
+
+  audio_list.forEach(function (track) {
+    track.levelInterval = 250;
+
+    track.onlevel = function(event) {
+      console.log('Audio Level:', event.level.toFixed(4), 'Peak:', event.peak.toFixed(4), 'Speaking:', event.speaking);
+    };
+
+    track.onspeakingchange = function(event) {
+      console.log(event.speaking ? 'Speaking...' : 'Silent...');
+    };
+  });
+
+  setTimeout(function() {
+    console.log('Closing...');
+
+    audio_list.forEach(function (track) {
+      track.onlevel = null;
+      track.onspeakingchange = null;
+    });
+  }, 10000);
+}
+
+function onError(error) {
+  throw error;
+}
+
+WebRTC.getUserMedia({
+  audio: true,
+  video: false,
+}, onSuccess, onError);
@@ -0,0 +1,30 @@
+var WebRTC = require('../');
+
+//WebRTC.setDebug(true);
+
+var sampleRate = 48000;
+var source = new WebRTC.RTCAudioSource();
+var frame = new Buffer((sampleRate / 100) * 2);
+var playout = new Buffer(frame.length);
+var count = 0;
+var received = 0;
+
+console.log('Audio Track:', source.track.kind, source.track.readyState);
+console.log('Audio Stream:', source.stream.id);
+
+var timer = setInterval(function() {
+  for (var index = 0; index < frame.length / 2; index++) {
+    frame.writeInt16LE(Math.round(Math.sin(2 * Math.PI * 440 * (count * 480 + index) / sampleRate) * 8000), index * 2);
+  }
+  
+  source.push(frame, sampleRate, 1);
+  received += source.pull(playout);
+  count++;
+}, 10);
+
+setTimeout(function() {
+  console.log('Closing...', count, 'frames pushed,', received, 'samples received');
+  
+  clearInterval(timer);
+  source.stop();
+}, 5000);
@@ -24,6 +24,10 @@ function main() {
         // node test/bwtest --iceConfig '{"ordered": false}'
         args.iceConfig = JSON.parse(args.iceConfig);
     }
+    if (typeof(args.networkEmulation) === 'string') {
+        // node test/bwtest --networkEmulation '{"delay": 50, "loss": 0.02}'
+        args.networkEmulation = JSON.parse(args.networkEmulation);
+    }
     console.log('bwtest args:', args);
     bwtest(args);
 }
@@ -53,6 +57,35 @@ function bwtape() {
         });
     });
 
+    tape('bwtest virtual network', function(t) {
+        t.plan(1);
+        bwtest({
+            packetCount: 500,
+            virtualNetwork: true
+        }, function(err) {
+            t.error(err, 'bwtest check for error');
+        });
+    });
+
+    tape('bwtest emulated network', function(t) {
+        t.plan(1);
+        bwtest({
+            packetCount: 500,
+            virtualNetwork: true,
+            networkEmulation: {
+                delay: 20,
+                jitter: 5,
+                loss: 0.01,
+                bandwidth: 20 * 1000 * 1000,
+                burst: 64 * 1024,
+                queue: 256 * 1024,
+                seed: 1
+            }
+        }, function(err) {
+            t.error(err, 'bwtest check for error');
+        });
+    });
+
     tape('bwtest unordered and unreliable', function(t) {
         t.plan(1);
         bwtest({
@@ -97,6 +130,19 @@ function bwtest(options, callback) {
     options.congestLowThreshold = options.congestLowThreshold || 256 * 1024;
     options.iceConfig = options.iceConfig || defaultIceConfig();
 
+    // transport settings shared by both peers, the in-memory network only
+    // reaches peers on it and emulation shapes each direction of the link
+    var peerConfig;
+
+    if (options.virtualNetwork || options.networkEmulation) {
+        peerConfig = {
+            virtualNetwork: !!options.virtualNetwork,
+            networkEmulation: options.networkEmulation
+        };
+        options.iceConfig.virtualNetwork = peerConfig.virtualNetwork;
+        options.iceConfig.networkEmulation = peerConfig.networkEmulation;
+    }
+
     var n = 0;
     var congested = 0;
     var stats = {
@@ -109,7 +155,8 @@ function bwtest(options, callback) {
 
     // setup two peers with simple-peer
     var peer1 = new SimplePeer({
-        wrtc: wrtc
+        wrtc: wrtc,
+        config: peerConfig
     });
     var peer2 = new SimplePeer({
         wrtc: wrtc,
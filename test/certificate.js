@@ -0,0 +1,29 @@
+var WebRTC = require('../');
+
+//WebRTC.setDebug(true);
+
+var started = Date.now();
+
+WebRTC.setCertificatePolicy({ policy: 'pool', keyType: 'ECDSA', poolSize: 4 });
+
+WebRTC.generateCertificate({ name: 'ECDSA', namedCurve: 'P-256' }).then(function(certificate) {
+  console.log('Certificate generated in', Date.now() - started, 'ms, expires', new Date(certificate.expires));
+  
+  var peers = [];
+  
+  for (var index = 0; index < 4; index++) {
+    peers.push(new WebRTC.RTCPeerConnection({ iceServers: [], certificates: index ? [] : [ certificate ] }));
+  }
+  
+  peers[0].createOffer(function(offer) {
+    console.log('Offer fingerprint:', /a=fingerprint:(.*)/.exec(offer.sdp)[1]);
+    
+    peers.forEach(function(peer) {
+      peer.close();
+    });
+  }, function(error) {
+    console.log(error);
+  });
+}, function(error) {
+  console.log(error);
+});
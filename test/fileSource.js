@@ -0,0 +1,91 @@
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var WebRTC = require('../');
+
+//WebRTC.setDebug(true);
+
+var video = process.argv[2] || path.join(os.tmpdir(), 'webrtc-native-test.y4m');
+var audio = process.argv[3] || path.join(os.tmpdir(), 'webrtc-native-test.wav');
+var senders = parseInt(process.argv[4]) || 1;
+var streams = [];
+
+function onError(error) {
+  throw error;
+}
+
+function writeY4M(file, width, height, frames) {
+  var chroma = (width / 2) * (height / 2);
+  var chunks = [ new Buffer('YUV4MPEG2 W' + width + ' H' + height + ' F30:1 Ip A1:1 C420jpeg\n') ];
+  
+  for (var index = 0; index < frames; index++) {
+    var frame = new Buffer(width * height + chroma * 2);
+    
+    frame.fill((index * 8) & 0xFF, 0, width * height);
+    frame.fill(128, width * height);
+    chunks.push(new Buffer('FRAME\n'), frame);
+  }
+  
+  fs.writeFileSync(file, Buffer.concat(chunks));
+}
+
+function writeWav(file, sampleRate, seconds) {
+  var samples = sampleRate * seconds;
+  var wav = new Buffer(44 + samples * 2);
+  
+  wav.write('RIFF', 0);
+  wav.writeUInt32LE(36 + samples * 2, 4);
+  wav.write('WAVE', 8);
+  wav.write('fmt ', 12);
+  wav.writeUInt32LE(16, 16);
+  wav.writeUInt16LE(1, 20);
+  wav.writeUInt16LE(1, 22);
+  wav.writeUInt32LE(sampleRate, 24);
+  wav.writeUInt32LE(sampleRate * 2, 28);
+  wav.writeUInt16LE(2, 32);
+  wav.writeUInt16LE(16, 34);
+  wav.write('data', 36);
+  wav.writeUInt32LE(samples * 2, 40);
+  
+  for (var index = 0; index < samples; index++) {
+    wav.writeInt16LE(Math.round(Math.sin(2 * Math.PI * 440 * index / sampleRate) * 8000), 44 + index * 2);
+  }
+  
+  fs.writeFileSync(file, wav);
+}
+
+if (!process.argv[2]) {
+  writeY4M(video, 64, 48, 30);
+}
+
+if (!process.argv[3]) {
+  writeWav(audio, 48000, 1);
+}
+
+if (!fs.existsSync(video) || !fs.existsSync(audio)) {
+  console.log('Skipping, missing', fs.existsSync(video) ? audio : video);
+  process.exit(0);
+}
+
+for (var index = 0; index < senders; index++) {
+  WebRTC.getUserMedia({
+    audio: { optional: [{ sourceId: 'file:' + audio }] },
+    video: { optional: [{ sourceId: 'file:' + video }] },
+  }, function(stream) {
+    streams.push(stream);
+    
+    if (streams.length == senders) {
+      console.log('Streaming', senders, 'file sources');
+    }
+  }, onError);
+}
+
+setTimeout(function() {
+  console.log('Closing...');
+  
+  streams.forEach(function(stream) {
+    stream.getTracks().forEach(function(track) {
+      track.stop();
+    });
+  });
+}, 5000);
@@ -0,0 +1,80 @@
+var assert = require('assert');
+var WebRTC = require('../');
+
+//WebRTC.setDebug(true);
+
+var interval = 50;
+var duration = 2000;
+
+var alice = new WebRTC.RTCPeerConnection({ iceServers: [] });
+var bob = new WebRTC.RTCPeerConnection({ iceServers: [] });
+
+alice.onicecandidate = function(event) {
+  if (event.candidate) {
+    bob.addIceCandidate(event.candidate);
+  }
+};
+
+bob.onicecandidate = function(event) {
+  if (event.candidate) {
+    alice.addIceCandidate(event.candidate);
+  }
+};
+
+bob.ondatachannel = function(event) {
+  var channel = event ? event.channel || event : null;
+
+  if (!channel) {
+    return false;
+  }
+
+  assert.notEqual(channel.protocol, 'webrtc-native-latency', 'probe channel reported to JS');
+};
+
+function check(histogram) {
+  assert.ok(histogram, 'no histogram');
+  assert.ok(histogram.count > 0, 'no round trips measured');
+  assert.ok(histogram.min >= 0, 'negative minimum');
+  assert.ok(histogram.min <= histogram.p50, 'p50 below minimum');
+  assert.ok(histogram.p50 <= histogram.p90, 'p90 below p50');
+  assert.ok(histogram.p90 <= histogram.p99, 'p99 below p90');
+  assert.ok(histogram.p99 <= histogram.p999, 'p999 below p99');
+  assert.ok(histogram.p999 <= histogram.max, 'p999 above maximum');
+  assert.ok(histogram.mean >= histogram.min && histogram.mean <= histogram.max, 'mean out of range');
+
+  // Both peers share the process, a loopback round trip stays well below a second.
+  assert.ok(histogram.max < 1e6, 'round trip of ' + histogram.max + ' us');
+}
+
+var plain = alice.createDataChannel('plain', { reliable: true, ordered: true });
+var channel = alice.createDataChannel('probed', { reliable: true, ordered: true, latencyProbe: interval });
+
+assert.strictEqual(plain.getLatencyHistogram(), null, 'histogram without a probe');
+
+channel.onopen = function() {
+  setTimeout(function() {
+    var histogram = channel.getLatencyHistogram();
+
+    console.log('RTT:', histogram);
+    check(histogram);
+
+    plain.close();
+    channel.close();
+    alice.close();
+    bob.close();
+  }, duration);
+};
+
+alice.createOffer(function(sdp) {
+  alice.setLocalDescription(sdp, function() {
+    bob.setRemoteDescription(sdp, function() {
+      bob.createAnswer(function(sdp) {
+        bob.setLocalDescription(sdp, function() {
+          alice.setRemoteDescription(sdp, function() {
+            console.log('Alice -> Bob: Connected!');
+          });
+        });
+      });
+    });
+  });
+});
@@ -0,0 +1,87 @@
+'use strict';
+
+var fs = require('fs');
+var minimist = require('minimist');
+
+
+exports.main = main;
+exports.list = list;
+exports.percentiles = percentiles;
+
+
+/**
+ * called from a benchmark that runs directly from cli
+ *
+ * node test/<name> [--timeout ms] [--virtual] [--output report.json] ...
+ *
+ * parses the command line, passes the options returned by parse(args) with
+ * the common timeout and virtualNetwork options to benchmark(options,
+ * callback) and prints the report, or writes it to --output. exits non zero
+ * on error and on any entry in report.failures (the regression gates).
+ *
+ * @param name - prefix of the error message
+ * @param benchmark function(options, callback)
+ * @param parse function(args) returning the benchmark specific options
+ *
+ */
+function main(name, benchmark, parse) {
+    var args = minimist(process.argv.slice(2));
+    var options = parse(args);
+
+    options.timeout = args.timeout || 30000;
+    options.virtualNetwork = !!args.virtual;
+
+    benchmark(options, function(err, report) {
+        if (err) {
+            console.error(name + ' error:', err.message);
+            process.exit(1);
+        }
+
+        var json = JSON.stringify(report, null, 2);
+
+        if (args.output) {
+            fs.writeFileSync(args.output, json);
+        } else {
+            console.log(json);
+        }
+
+        // regression gates
+        if (report.failures && report.failures.length) {
+            report.failures.forEach(function(failure) {
+                console.error('FAIL', failure);
+            });
+            process.exit(1);
+        }
+
+        process.exit(0);
+    });
+}
+
+/**
+ * comma separated numbers, e.g. --steps 100,500,1000
+ */
+function list(value, fallback) {
+    return String(value || fallback).split(',').map(Number);
+}
+
+function percentiles(times) {
+    var sorted = times.slice().sort(function(a, b) {
+        return a - b;
+    });
+
+    function at(percentile) {
+        if (!sorted.length) {
+            return 0;
+        }
+
+        return sorted[Math.min(sorted.length - 1, Math.ceil(percentile / 100 * sorted.length) - 1)];
+    }
+
+    return {
+        count: sorted.length,
+        p50: at(50),
+        p90: at(90),
+        p99: at(99),
+        max: at(100)
+    };
+}
@@ -0,0 +1,35 @@
+var WebRTC = require('../');
+
+//WebRTC.setDebug(true);
+
+var config = {
+  iceServers: [
+    {
+      url: 'stun:stun.l.google.com:19302',
+    },
+  ],
+};
+
+WebRTC.setPeerConnectionPool({ size: 8, configuration: config });
+
+function measure(pool, count) {
+  var started = process.hrtime();
+  var peers = [];
+  
+  for (var index = 0; index < count; index++) {
+    peers.push(new WebRTC.RTCPeerConnection({ iceServers: config.iceServers, pool: pool }));
+  }
+  
+  var elapsed = process.hrtime(started);
+  
+  console.log(pool ? 'Pooled:' : 'Unpooled:', count, 'peers in', (elapsed[0] * 1e3 + elapsed[1] / 1e6).toFixed(2), 'ms', peers[0].signalingState);
+  
+  peers.forEach(function(peer) {
+    peer.close();
+  });
+}
+
+setTimeout(function() {
+  measure(false, 8);
+  measure(true, 8);
+}, 2000);
@@ -0,0 +1,292 @@
+'use strict';
+
+var fs = require('fs');
+var wrtc = require('..');
+var bench = require('./lib/bench');
+var SimplePeer = require('simple-peer');
+
+
+module.exports = scale;
+
+
+/**
+ * node test/scale --steps 100,500,1000,2000 --concurrency 50 --virtual
+ *                 [--output report.json] [--maxConnectP99 ms] [--maxRssPerPeer bytes]
+ */
+if (require.main === module) {
+    bench.main('scale', scale, function(args) {
+        return {
+            steps: bench.list(args.steps, '100,500,1000,2000'),
+            concurrency: args.concurrency || 50,
+            maxConnectP99: args.maxConnectP99,
+            maxRssPerPeer: args.maxRssPerPeer
+        };
+    });
+}
+
+
+/**
+ *
+ * SCALE
+ *
+ * ramp up to options.steps[n] connected peer pairs in this process and take
+ * a sample of the process after each step.
+ *
+ * @param options - steps, concurrency, timeout, virtualNetwork and the
+ *                  optional maxConnectP99 / maxRssPerPeer gates.
+ * @param callback function(err, report)
+ *
+ */
+function scale(options, callback) {
+    var pairs = [];
+    var config = options.virtualNetwork ? { virtualNetwork: true } : undefined;
+    var baseline = sample();
+
+    // only the messages dispatched during a step count towards it
+    wrtc.getThreadMetrics(true);
+    var previous = baseline;
+    var report = {
+        benchmark: 'scale',
+        transport: options.virtualNetwork ? 'virtual' : 'udp',
+        concurrency: options.concurrency,
+        baseline: baseline,
+        steps: [],
+        failures: []
+    };
+
+    nextStep(0);
+
+    function nextStep(index) {
+        if (index >= options.steps.length) {
+            return finish();
+        }
+
+        var target = options.steps[index];
+        var times = [];
+        var started = Date.now();
+
+        ramp(target, times, function(err) {
+            if (err) {
+                return finish(err);
+            }
+
+            var current = sample();
+            var peers = pairs.length * 2;
+            var step = {
+                pairs: pairs.length,
+                seconds: (Date.now() - started) / 1000,
+                connect: bench.percentiles(times),
+                rssPerPeer: Math.round((current.rss - baseline.rss) / peers),
+                heapPerPeer: Math.round((current.heapUsed - baseline.heapUsed) / peers),
+                sample: current,
+                cpu: cpuDelta(previous, current),
+                threadMetrics: wrtc.getThreadMetrics(true)
+            };
+
+            previous = current;
+            report.steps.push(step);
+            gate(step);
+
+            console.error('pairs ' + step.pairs +
+                          ' connect p50 ' + step.connect.p50 + ' ms p99 ' + step.connect.p99 + ' ms' +
+                          ' rss/peer ' + (step.rssPerPeer / 1024).toFixed(1) + ' KB' +
+                          ' threads ' + current.threads +
+                          ' fds ' + current.fds +
+                          ' uv ' + current.handles.total);
+
+            nextStep(index + 1);
+        });
+    }
+
+    // connect pairs, at most options.concurrency at a time
+    function ramp(target, times, done) {
+        var pending = 0;
+        var failed = false;
+
+        fill();
+
+        function fill() {
+            if (failed) {
+                return;
+            }
+
+            if (pairs.length + pending >= target) {
+                if (!pending) {
+                    done();
+                }
+
+                return;
+            }
+
+            while (pending < options.concurrency && pairs.length + pending < target) {
+                pending += 1;
+                connect(config, options.timeout, onConnect);
+            }
+        }
+
+        function onConnect(err, pair, time) {
+            pending -= 1;
+
+            if (failed) {
+                if (pair) {
+                    pair[0].destroy();
+                    pair[1].destroy();
+                }
+
+                return;
+            }
+
+            if (err) {
+                failed = true;
+                return done(err);
+            }
+
+            pairs.push(pair);
+            times.push(time);
+            fill();
+        }
+    }
+
+    function gate(step) {
+        if (options.maxConnectP99 && step.connect.p99 > options.maxConnectP99) {
+            report.failures.push('connect p99 ' + step.connect.p99 + ' ms > ' + options.maxConnectP99 + ' ms at ' + step.pairs + ' pairs');
+        }
+
+        if (options.maxRssPerPeer && step.rssPerPeer > options.maxRssPerPeer) {
+            report.failures.push('rss per peer ' + step.rssPerPeer + ' > ' + options.maxRssPerPeer + ' at ' + step.pairs + ' pairs');
+        }
+    }
+
+    function finish(err) {
+        pairs.forEach(function(pair) {
+            pair[0].destroy();
+            pair[1].destroy();
+        });
+
+        pairs = [];
+        callback(err, report);
+    }
+}
+
+
+/**
+ * connect one peer pair, callback(err, pair, milliseconds)
+ */
+function connect(config, timeout, callback) {
+    var started = Date.now();
+    var connected = 0;
+    var finished = false;
+
+    var peer1 = new SimplePeer({
+        wrtc: wrtc,
+        config: config
+    });
+    var peer2 = new SimplePeer({
+        wrtc: wrtc,
+        initiator: true,
+        config: config
+    });
+
+    var timer = setTimeout(function() {
+        done(new Error('Timeout'));
+    }, timeout);
+
+    peer1.on('signal', peer2.signal.bind(peer2));
+    peer2.on('signal', peer1.signal.bind(peer1));
+    peer1.on('error', done);
+    peer2.on('error', done);
+    peer1.on('connect', onConnect);
+    peer2.on('connect', onConnect);
+
+    function onConnect() {
+        connected += 1;
+
+        if (connected === 2) {
+            done();
+        }
+    }
+
+    function done(err) {
+        if (finished) {
+            return;
+        }
+
+        finished = true;
+        clearTimeout(timer);
+
+        if (err) {
+            peer1.destroy();
+            peer2.destroy();
+            return callback(err);
+        }
+
+        callback(null, [ peer1, peer2 ], Date.now() - started);
+    }
+}
+
+
+/**
+ * process wide resource usage, thread and fd counts are only available
+ * where /proc (or /dev/fd) exists.
+ */
+function sample() {
+    var memory = process.memoryUsage();
+
+    return {
+        rss: memory.rss,
+        heapUsed: memory.heapUsed,
+        threads: count('/proc/self/task'),
+        fds: count('/proc/self/fd') || count('/dev/fd'),
+        handles: wrtc.getLoopHandles(),
+        jsHandles: process._getActiveHandles().length,
+        threadTimes: threadTimes()
+    };
+}
+
+function count(path) {
+    try {
+        return fs.readdirSync(path).length;
+    } catch (ignored) {
+        return null;
+    }
+}
+
+/**
+ * cpu milliseconds per thread name, summed over threads with the same
+ * name. assumes the usual 100 ticks per second.
+ */
+function threadTimes() {
+    var times = {};
+    var tasks;
+
+    try {
+        tasks = fs.readdirSync('/proc/self/task');
+    } catch (ignored) {
+        return times;
+    }
+
+    tasks.forEach(function(tid) {
+        try {
+            var name = fs.readFileSync('/proc/self/task/' + tid + '/comm', 'utf8').trim();
+            var stat = fs.readFileSync('/proc/self/task/' + tid + '/stat', 'utf8');
+            var fields = stat.slice(stat.lastIndexOf(')') + 2).split(' ');
+
+            // utime and stime are fields 14 and 15 of stat
+            times[name] = (times[name] || 0) + (Number(fields[11]) + Number(fields[12])) * 10;
+        } catch (ignored) {
+            // thread exited while reading
+        }
+    });
+
+    return times;
+}
+
+function cpuDelta(previous, current) {
+    var delta = {};
+
+    Object.keys(current.threadTimes).forEach(function(name) {
+        delta[name] = current.threadTimes[name] - (previous.threadTimes[name] || 0);
+    });
+
+    return delta;
+}
@@ -0,0 +1,250 @@
+'use strict';
+
+var wrtc = require('..');
+var bench = require('./lib/bench');
+
+
+module.exports = signaling;
+
+
+/**
+ * node test/signaling --concurrency 1,8,64 --cycles 500 [--virtual] [--emitterMetrics]
+ *                     [--output report.json]
+ */
+if (require.main === module) {
+    bench.main('signaling', signaling, function(args) {
+        return {
+            concurrency: bench.list(args.concurrency, '1,8,64'),
+            cycles: args.cycles || 500,
+            emitterMetrics: !!args.emitterMetrics
+        };
+    });
+}
+
+
+/**
+ *
+ * SIGNALING
+ *
+ * run options.cycles full negotiations for every concurrency level. a cycle
+ * creates a peer pair, runs createOffer / setLocalDescription /
+ * setRemoteDescription / createAnswer in both directions and relays every
+ * candidate until both sides signal the end of candidates.
+ *
+ * everything goes through the addon's observers and event queue, which is
+ * the path this benchmark is meant to measure.
+ *
+ * @param options - concurrency (array), cycles, timeout, virtualNetwork,
+ *                  emitterMetrics
+ * @param callback function(err, report)
+ *
+ */
+function signaling(options, callback) {
+    var config = {
+        iceServers: [],
+        virtualNetwork: options.virtualNetwork
+    };
+    var report = {
+        benchmark: 'signaling',
+        transport: options.virtualNetwork ? 'virtual' : 'udp',
+        latencyUnit: 'ms',
+        results: []
+    };
+
+    nextLevel(0);
+
+    function nextLevel(index) {
+        if (index >= options.concurrency.length) {
+            return callback(null, report);
+        }
+
+        run(options.concurrency[index], function(err, result) {
+            if (err) {
+                return callback(err);
+            }
+
+            report.results.push(result);
+
+            console.error('concurrency ' + result.concurrency +
+                          ' ' + result.cyclesPerSecond.toFixed(1) + ' cycles/s' +
+                          ' cycle p50 ' + result.cycle.p50.toFixed(2) + ' ms' +
+                          ' p99 ' + result.cycle.p99.toFixed(2) + ' ms');
+
+            nextLevel(index + 1);
+        });
+    }
+
+    function run(concurrency, done) {
+        if (options.emitterMetrics) {
+            wrtc.setEmitterMetrics(true, true);
+        }
+
+        var started = now();
+        var launched = 0;
+        var completed = 0;
+        var failed = false;
+        var phases = {
+            cycle: [],
+            offer: [],
+            answer: [],
+            candidates: []
+        };
+
+        for (var i = 0; i < concurrency && launched < options.cycles; i += 1) {
+            launch();
+        }
+
+        function launch() {
+            launched += 1;
+            cycle(config, options.timeout, onCycle);
+        }
+
+        function onCycle(err, times) {
+            if (failed) {
+                return;
+            }
+
+            if (err) {
+                failed = true;
+                return done(err);
+            }
+
+            completed += 1;
+
+            Object.keys(phases).forEach(function(phase) {
+                phases[phase].push(times[phase]);
+            });
+
+            if (launched < options.cycles) {
+                return launch();
+            }
+
+            if (completed === options.cycles) {
+                var seconds = (now() - started) / 1000;
+                var result = {
+                    concurrency: concurrency,
+                    cycles: completed,
+                    seconds: seconds,
+                    cyclesPerSecond: completed / seconds,
+                    cycle: bench.percentiles(phases.cycle),
+                    offer: bench.percentiles(phases.offer),
+                    answer: bench.percentiles(phases.answer),
+                    candidates: bench.percentiles(phases.candidates)
+                };
+
+                if (options.emitterMetrics) {
+                    result.emitters = wrtc.getEmitterMetrics();
+                }
+
+                done(null, result);
+            }
+        }
+    }
+}
+
+
+/**
+ * one negotiation between a fresh peer pair, callback(err, times) with the
+ * milliseconds spent in each phase.
+ */
+function cycle(config, timeout, callback) {
+    var alice = new wrtc.RTCPeerConnection(config);
+    var bob = new wrtc.RTCPeerConnection(config);
+    var started = now();
+    var times = {};
+    var ended = 0;
+    var finished = false;
+
+    var timer = setTimeout(function() {
+        done(new Error('Timeout'));
+    }, timeout);
+
+    // candidates are held back until the receiving side has its remote
+    // description, like a signaling server would
+    var pending = {
+        alice: [],
+        bob: []
+    };
+
+    alice.onicecandidate = relay(bob, 'bob');
+    bob.onicecandidate = relay(alice, 'alice');
+
+    // an SCTP channel gives the offer something to negotiate
+    alice.createDataChannel('signaling');
+
+    alice.createOffer(function(offer) {
+        alice.setLocalDescription(offer, function() {
+            bob.setRemoteDescription(offer, function() {
+                times.offer = now() - started;
+                flush(bob, 'bob');
+
+                bob.createAnswer(function(answer) {
+                    bob.setLocalDescription(answer, function() {
+                        alice.setRemoteDescription(answer, function() {
+                            times.answer = now() - started - times.offer;
+                            flush(alice, 'alice');
+                            check();
+                        }, done);
+                    }, done);
+                }, done);
+            }, done);
+        }, done);
+    }, done);
+
+    function relay(remote, name) {
+        return function(event) {
+            if (!event.candidate) {
+                ended += 1;
+                return check();
+            }
+
+            if (pending[name]) {
+                pending[name].push(event.candidate);
+            } else {
+                remote.addIceCandidate(new wrtc.RTCIceCandidate(event.candidate), noop, done);
+            }
+        };
+    }
+
+    function flush(remote, name) {
+        var candidates = pending[name];
+
+        pending[name] = null;
+        candidates.forEach(function(candidate) {
+            remote.addIceCandidate(new wrtc.RTCIceCandidate(candidate), noop, done);
+        });
+    }
+
+    function check() {
+        if (ended === 2 && times.answer !== undefined) {
+            times.cycle = now() - started;
+            times.candidates = times.cycle - times.offer - times.answer;
+            done();
+        }
+    }
+
+    function done(err) {
+        if (finished) {
+            return;
+        }
+
+        finished = true;
+        clearTimeout(timer);
+
+        alice.close();
+        bob.close();
+
+        if (err) {
+            return callback(err instanceof Error ? err : new Error(String(err)));
+        }
+
+        callback(null, times);
+    }
+}
+
+function noop() {}
+
+function now() {
+    var time = process.hrtime();
+    return time[0] * 1e3 + time[1] / 1e6;
+}
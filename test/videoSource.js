@@ -0,0 +1,29 @@
+var WebRTC = require('../');
+
+//WebRTC.setDebug(true);
+
+var width = 320;
+var height = 240;
+var source = new WebRTC.RTCVideoSource({ width: width, height: height, frameRate: 30 });
+var frame = new Buffer(width * height * 4);
+var count = 0;
+
+console.log('Video Track:', source.track.kind, source.track.readyState);
+console.log('Video Stream:', source.stream.id);
+
+var timer = setInterval(function() {
+  frame.fill(count % 256);
+  
+  if (!source.pushFrame(width, height, frame, 'rgba')) {
+    console.log('Frame dropped!');
+  }
+  
+  count++;
+}, 33);
+
+setTimeout(function() {
+  console.log('Closing...', count, 'frames pushed');
+  
+  clearInterval(timer);
+  source.stop();
+}, 5000);